@@ -49,6 +49,8 @@ protected:
   virtual void SetupLigand();
   virtual void SetupScore();
   virtual double RawScore() const;
+  // Shares the receptor interaction centers and indexing grids with a clone
+  virtual void ShareReceptorData(BaseSF *pClone) const;
 
   // Clear the receptor and ligand grids and lists respectively
   // As we are not using smart pointers, there is some memory management to do
@@ -96,6 +98,7 @@ private:
   // End of section that should ultimately be moved to AromSF base class
   //////////////////////////////////////////////////////////
 
+  InteractionCenterOwnerPtr m_spRecepOwner; // Owns the receptor centers
   InteractionGridPtr m_spAromGrid;
   InteractionGridPtr m_spGuanGrid;
   InteractionCenterList m_recepAromList;
@@ -0,0 +1,206 @@
+//===-- AsyncFileWriter.h - Ordered background file writer ------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Writes numbered blocks of text to a file in a background thread.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef RXDOCK_ASYNCFILEWRITER_H
+#define RXDOCK_ASYNCFILEWRITER_H
+
+#include "rxdock/Config.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <exception>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace rxdock {
+
+///
+/// \brief Writes blocks of text to a file in a background thread, in block
+/// order.
+///
+/// Blocks are numbered from 0 and can be submitted in any order by any thread;
+/// block i is written once blocks 0 to i - 1 have been written. Every block
+/// number must therefore be submitted, with an empty text if there is nothing
+/// to write. The blocks waiting to be written are held in memory, up to a
+/// window of \p nWindowBytes bytes of text: a thread submitting a block that
+/// does not fit waits for earlier blocks to be written, unless its block is
+/// the next one to write.
+///
+/// Alternatively, a writer without a file of its own writes each block
+/// submitted with SubmitFile to a file of its own, so that a single writer
+/// thread serves any number of small files.
+///
+/// A file is compressed with gzip if its name ends with ".gz" (only if built
+/// with zlib).
+///
+class AsyncFileWriter {
+public:
+  ///
+  /// \brief Called by the writer thread with the number of blocks and bytes
+  /// in the file, once they are all flushed to disk.
+  ///
+  typedef std::function<void(std::size_t nBlocks, std::size_t nBytes)>
+      CheckpointFunction;
+
+  ///
+  /// \brief Opens the file for writing blocks from \p iFirstBlock on.
+  ///
+  /// With \p iFirstBlock = 0 the file is truncated. Otherwise writing is
+  /// resumed: the file is truncated to its first \p nBytes bytes, which hold
+  /// blocks 0 to iFirstBlock - 1, and the blocks are appended to it.
+  /// \throw FileWriteError if the file can not be opened, or if resuming a
+  /// compressed file
+  ///
+  RBTDLL_EXPORT AsyncFileWriter(const std::string &fileName,
+                                std::size_t nWindowBytes = 0,
+                                std::size_t iFirstBlock = 0,
+                                std::size_t nBytes = 0);
+
+  ///
+  /// \brief Writes to an open stream, which is flushed after each block so
+  /// that its reader gets the blocks straight away.
+  ///
+  /// The stream is not closed by the writer.
+  ///
+  RBTDLL_EXPORT AsyncFileWriter(std::FILE *stream,
+                                std::size_t nWindowBytes = 0);
+
+  ///
+  /// \brief Writes the blocks submitted with SubmitFile, each to its own
+  /// file.
+  ///
+  RBTDLL_EXPORT explicit AsyncFileWriter(std::size_t nWindowBytes);
+
+  /// Writes the remaining blocks and closes the file, ignoring errors
+  RBTDLL_EXPORT ~AsyncFileWriter();
+
+  std::string GetFileName() const { return m_strFileName; }
+
+  ///
+  /// \brief Returns the number of blocks written so far, counting the block
+  /// being written.
+  ///
+  RBTDLL_EXPORT std::size_t GetNumWrittenBlocks();
+
+  ///
+  /// \brief Queues block \p iBlock for writing.
+  ///
+  /// \throw FileWriteError if writing a previous block failed
+  ///
+  RBTDLL_EXPORT void Submit(std::size_t iBlock, std::string text);
+
+  ///
+  /// \brief Queues \p text for writing to the file \p fileName, which is
+  /// overwritten, after the blocks submitted before it.
+  ///
+  /// \throw FileWriteError if writing a previous block failed, or if the
+  /// writer has a file of its own
+  ///
+  RBTDLL_EXPORT void SubmitFile(const std::string &fileName, std::string text);
+
+  ///
+  /// \brief Calls \p checkpoint from the writer thread at most every
+  /// \p interval, and once more when the file is closed.
+  ///
+  /// Only called while the blocks have been written without a gap, so that
+  /// the file can be resumed from the last checkpoint (see the constructor).
+  /// \throw FileWriteError if the file is compressed, or if the writer has no
+  /// file of its own
+  ///
+  RBTDLL_EXPORT void SetCheckpoint(CheckpointFunction checkpoint,
+                                   std::chrono::duration<double> interval);
+
+  ///
+  /// \brief Writes the remaining blocks and closes the file.
+  ///
+  /// Blocks that are still waiting for a previous block, which will never be
+  /// submitted, are written in block order.
+  /// \throw FileWriteError if writing any block failed
+  ///
+  RBTDLL_EXPORT void Close();
+
+  ///
+  /// \brief Stops waiting for missing blocks.
+  ///
+  /// Used when docking is aborted: threads waiting in Submit are released,
+  /// and the blocks submitted from now on are written as soon as possible.
+  ///
+  RBTDLL_EXPORT void Abort();
+
+  ///
+  /// \brief Stops writing, when the file has been taken over by another
+  /// process.
+  ///
+  /// The blocks waiting to be written and those submitted from now on are
+  /// dropped, and the checkpoint function is no longer called.
+  ///
+  RBTDLL_EXPORT void Discard();
+
+private:
+  AsyncFileWriter(const AsyncFileWriter &);            // Copy constructor
+                                                       // disabled
+  AsyncFileWriter &operator=(const AsyncFileWriter &); // Copy assignment
+                                                       // disabled
+
+  struct Block {
+    std::string strFileName; // File of its own, if not empty
+    std::string text;
+  };
+
+  void Queue(std::size_t iBlock, Block &block);
+  void Open(const std::string &fileName, std::size_t nBytes);
+  void WriteText(const std::string &text);
+  void FlushFile();
+  void CloseFile();
+  void WriterLoop();
+
+  std::string m_strFileName;
+  std::size_t m_nWindowBytes;
+  bool m_bFiles;  // Writing each block to a file of its own
+  bool m_bStream; // Writing to a stream owned by the caller
+  // Only used by the constructor and the writer thread
+  std::string m_strOpenFileName;
+  bool m_bCompress;
+  std::FILE *m_file;
+  void *m_gzFile;
+
+  std::mutex m_mutex;
+  std::condition_variable m_blockReady; // Signalled to the writer thread
+  std::condition_variable m_blockDone;  // Signalled to the submitting threads
+  std::map<std::size_t, Block> m_pendingBlocks;
+  std::size_t m_nPendingBytes; // Text in m_pendingBlocks
+  std::size_t m_nSubmitted;    // Blocks submitted with SubmitFile
+  std::size_t m_iNextBlock;    // Next block to write
+  std::size_t m_nBytes;        // Bytes in the file
+  bool m_bContiguous;          // No block has been skipped
+  CheckpointFunction m_checkpoint;
+  std::chrono::duration<double> m_checkpointInterval;
+  bool m_bClosing;
+  bool m_bAbort;
+  bool m_bDiscard;
+  std::exception_ptr m_writeError;
+  std::thread m_thread;
+};
+
+typedef SmartPtr<AsyncFileWriter> AsyncFileWriterPtr;
+
+} // namespace rxdock
+
+#endif // RXDOCK_ASYNCFILEWRITER_H
@@ -20,6 +20,7 @@
 
 #include <fstream>
 
+#include "rxdock/AsyncFileWriter.h"
 #include "rxdock/Config.h"
 
 namespace rxdock {
@@ -45,6 +46,19 @@ public:
   // PURE VIRTUAL - MUST BE OVERRIDDEN IN DERIVED CLASSES
   virtual void Render() = 0;
 
+  // With a writer, Write() keeps the text in memory instead of writing the
+  // file, and SubmitBlock hands it over to the writer as block iBlock,
+  // preceded by strHeader. The file name and append status are ignored, the
+  // writer owns the file. Alternatively, SubmitFile hands the text over to a
+  // writer without a file of its own, to overwrite the file of the sink
+  AsyncFileWriterPtr GetWriter() const { return m_spWriter; }
+  RBTDLL_EXPORT void SetWriter(AsyncFileWriterPtr spWriter);
+  RBTDLL_EXPORT void SubmitBlock(std::size_t iBlock,
+                                 const std::string &strHeader = "");
+  RBTDLL_EXPORT void SubmitFile();
+  // Returns the text of the block that SubmitBlock would submit next
+  const std::string &GetWriterText() const { return m_strWriterText; }
+
 protected:
   ////////////////////////////////////////
   // Protected methods
@@ -95,6 +109,8 @@ private:
   std::string m_strFileName;
   std::ofstream m_fileOut;
   bool m_bAppend; // If true, Write() appends to file rather than overwriting
+  AsyncFileWriterPtr m_spWriter;
+  std::string m_strWriterText; // Text written but not yet submitted
 };
 
 // Useful typedefs
@@ -58,6 +58,26 @@ public:
   RBTDLL_EXPORT void NextRecord();
   void Rewind();
   RBTDLL_EXPORT std::size_t GetEstimatedNumRecords();
+  // Returns the byte offset in the file of the record following the current
+  // record, reading the current record if needed
+  RBTDLL_EXPORT std::size_t GetNextRecordOffset();
+  // Makes the record starting at byte offset in the file the next record to be
+  // read. The offset must have been obtained from GetNextRecordOffset
+  RBTDLL_EXPORT void SeekRecord(std::size_t offset);
+  // Returns the offset of the first record following a record delimiter line
+  // that starts at or after byte offset in the file (0 for offset 0, the file
+  // size if there is none). Only the lines from offset on are read, so this is
+  // a cheap way to split a large file into ranges of whole records
+  RBTDLL_EXPORT std::size_t FindRecordBoundary(std::size_t offset);
+  // Size of the file in bytes
+  std::size_t GetFileSize() const { return m_fileSize; }
+
+  // Returns the raw line records of the current record, reading it if needed
+  RBTDLL_EXPORT FileRecList GetRecordLines();
+  // Replaces the current record with the given line records, as if they had
+  // just been read from the file. Allows a record read by one source to be
+  // parsed by another (e.g. by a docking thread)
+  RBTDLL_EXPORT void SetRecordLines(const FileRecList &lineRecs);
 
 protected:
   //////////////////////////////////////////////////////
@@ -92,6 +112,7 @@ private:
   bool m_bReadOK; // For use by Read
   std::size_t m_numReads;
   std::size_t m_bytesRead;
+  std::size_t m_nextRecordOffset; // Offset of the record after the cache
   std::ifstream m_fileIn;
   char *m_szBuf;    // Line buffer
   bool m_bFileOpen; // Keep track of whether we've opened the file or not
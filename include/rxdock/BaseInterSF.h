@@ -53,6 +53,10 @@ protected:
   virtual void SetupSolvent() {}    // Called by Update when solvent is changed
   virtual void
   SetupScore() = 0; // Called by Update when either model has changed
+  // Hands the current receptor to a clone, so that the clone skips
+  // SetupReceptor when registered with a workspace holding the same receptor.
+  // Only call from ShareReceptorData, after copying the receptor data
+  void ShareReceptor(BaseInterSF *pClone) const;
 
 private:
   ////////////////////////////////////////
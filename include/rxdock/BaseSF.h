@@ -57,6 +57,18 @@ public:
 
   // Main public method - returns current weighted score
   RBTDLL_EXPORT double Score() const;
+  // Creates an unregistered scoring function of the same class, with the same
+  // name and parameter values. Read-only receptor data (e.g. indexing grids)
+  // is shared with the clone rather than copied, and is reused if the clone is
+  // registered with a workspace containing the same receptor model
+  virtual BaseSF *Clone() const;
+  // Returns false if scoring writes to the receptor model, in which case a
+  // receptor model must not be shared by workspaces that score concurrently
+  virtual bool isReceptorReadOnly() const;
+  // Copies the parameter values of sf to this scoring function, and of each
+  // child of sf to the child of this scoring function with the same index
+  // (e.g. from the scoring function a clone was made from)
+  void CopyTreeParameters(const BaseSF &sf);
   // Returns all child component scores as a string-variant map
   // Key = fully qualified component name, value = weighted score
   //(for saving in a Model's data fields)
@@ -84,6 +96,9 @@ protected:
   void ParameterUpdated(const std::string &strName);
   // Helper method for ScoreMap
   void AddToParentMapEntry(StringVariantMap &scoreMap, double rs) const;
+  // Hands read-only receptor data to a clone of this scoring function
+  // Base class does nothing, so the clone sets up the receptor itself
+  virtual void ShareReceptorData(BaseSF *pClone) const;
 
 private:
   ////////////////////////////////////////
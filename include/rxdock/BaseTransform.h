@@ -47,6 +47,10 @@ public:
   // then calls private virtual method Execute() to apply the transform
   void Go();
 
+  // Creates an unregistered transform of the same class, with the same name,
+  // parameter values and scoring function requests
+  virtual BaseTransform *Clone() const;
+
   // Aggregate handling methods
   virtual void Add(BaseTransform *);
   virtual void Remove(BaseTransform *);
@@ -41,6 +41,8 @@ public:
   virtual void SyncFromModel();
   virtual void SyncToModel();
   virtual ChromElement *clone() const;
+  virtual void CopyValues(const ChromElement &c);
+  virtual void CopyXOverGenes(const ChromElement &c, int iBegin, int iEnd);
   virtual int GetLength() const;
   virtual int GetXOverLength() const;
   virtual void GetVector(std::vector<double> &v) const;
@@ -55,11 +57,18 @@ public:
   // Appends a new chromosome element to the vector
   // Chrom destructor is responsible for deleting the new element
   // Null operation if pChromElement is nullptr
+  // The elements of a Chrom are appended in its place, so that the element
+  // list stays flat however the chromosome was assembled (e.g. from the
+  // per-model chromosomes), and pChromElement itself is deleted
   virtual void Add(ChromElement *pChromElement);
 
 protected:
 private:
   ChromElementList m_elementList;
+  // Total length and crossover length of the elements, kept up to date by
+  // Add so that they are not summed over the elements on every call
+  int m_length;
+  int m_xOverLength;
   // We need to store the model list so that
   // we can call UpdatePseudoAtoms() on each model following
   // a SyncToModel
@@ -46,6 +46,8 @@ public:
   virtual void SyncFromModel();
   virtual void SyncToModel();
   virtual ChromElement *clone() const;
+  virtual void CopyValues(const ChromElement &c);
+  virtual void CopyXOverGenes(const ChromElement &c, int iBegin, int iEnd);
   virtual int GetLength() const { return 1; }
   virtual int GetXOverLength() const { return 1; }
   virtual void GetVector(std::vector<double> &v) const;
@@ -71,6 +71,16 @@ public:
   // The current value of the cloned element should match the current value
   // of this element.
   virtual ChromElement *clone() const = 0;
+  // Sets the current value of this element to that of c, which must be a
+  // clone of this element or of the element it was cloned from. Unlike
+  // replacing this element by a clone of c, nothing is allocated
+  virtual void CopyValues(const ChromElement &c) = 0;
+  // Sets the crossover genes [iBegin, iEnd) of this element (numbered as in
+  // GetVector(XOverList&)) to those of c, with the same requirements on c as
+  // CopyValues. Used by Crossover to cross over without going through
+  // temporary XOverLists
+  virtual void CopyXOverGenes(const ChromElement &c, int iBegin,
+                              int iEnd) = 0;
   // Gets the number of double values needed to represent this
   // chromosome element
   virtual int GetLength() const = 0;
@@ -40,6 +40,8 @@ public:
   virtual void SyncFromModel();
   virtual void SyncToModel();
   virtual ChromElement *clone() const;
+  virtual void CopyValues(const ChromElement &c);
+  virtual void CopyXOverGenes(const ChromElement &c, int iBegin, int iEnd);
   virtual int GetLength() const { return m_spRefData->GetLength(); }
   virtual int GetXOverLength() const { return m_spRefData->GetXOverLength(); }
   virtual void GetVector(std::vector<double> &v) const;
@@ -45,6 +45,23 @@ public:
   static const std::string _NCONVERGENCE;
   // Output the best pose every _HISTORY_FREQ cycles.
   static const std::string _HISTORY_FREQ;
+  // If positive, run a steady-state GA: the new individuals of each cycle are
+  // created and inserted into the population _STEADY_STATE_BATCH at a time
+  // (see Population::SteadyStateStep) instead of all together. Even values
+  // let every new individual be created by crossover
+  static const std::string _STEADY_STATE_BATCH;
+  // Island model: if _NISLANDS > 1, the population is split into that many
+  // islands of equal size, evolved independently, each with its own random
+  // number substream of the run. Every _MIGRATION_FREQ cycles, the best
+  // _NMIGRANTS individuals of each island are copied to the next island (in a
+  // ring). The islands are merged back into the population at the end.
+  // The islands can only be scored concurrently on the scoring replicas of
+  // the workspace (one per scoring thread after the first): with a single
+  // scoring thread they are stepped in turn, and with n scoring threads up to
+  // n islands are stepped at once
+  static const std::string _NISLANDS;
+  static const std::string _MIGRATION_FREQ;
+  static const std::string _NMIGRANTS;
 
   ////////////////////////////////////////
   // Constructors/destructors
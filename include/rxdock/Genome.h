@@ -35,6 +35,10 @@ public:
   Genome &operator=(const Genome &);
   Genome *clone() const;
   virtual ~Genome();
+  // Copies the chromosome values and scores of g, which must have the same
+  // chromosome layout. Same result as assignment, but the underlying
+  // chromosome is updated in place rather than cloned.
+  void CopyFrom(const Genome &g);
 
   // Gets the underlying chromosome
   ChromElement *GetChrom() const { return m_chrom; }
@@ -45,6 +49,12 @@ public:
   // is a pointer to a scoring function object. If pSF is null, a zero score is
   // set.
   void SetScore(BaseSF *pSF);
+  // Sets the raw score from the scoring function, evaluated on the models
+  // manipulated by pChrom instead of those of the underlying chromosome.
+  // pChrom must have the same layout as the underlying chromosome and pSF
+  // must score the models manipulated by pChrom. The models of the underlying
+  // chromosome are not changed.
+  void SetScore(BaseSF *pSF, ChromElement *pChrom);
   // Gets the stored raw score (without re-evaluation of the scoring function).
   double GetScore() const { return m_score; }
 
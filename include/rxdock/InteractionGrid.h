@@ -17,6 +17,7 @@
 
 #include "rxdock/Atom.h"
 #include "rxdock/BaseGrid.h"
+#include "rxdock/support/HugePages.h"
 
 namespace rxdock {
 
@@ -97,6 +98,24 @@ public:
   void operator()(InteractionCenter *pIC);
 };
 
+// Owns a list of interaction centers, so that receptor interaction centers
+// can be shared between a scoring function and its clones. The interaction
+// centers are deleted along with the last smart pointer to the owner
+class InteractionCenterOwner {
+public:
+  InteractionCenterOwner(const InteractionCenterList &icList1,
+                         const InteractionCenterList &icList2);
+  ~InteractionCenterOwner();
+
+private:
+  InteractionCenterOwner(const InteractionCenterOwner &);
+  InteractionCenterOwner &operator=(const InteractionCenterOwner &);
+
+  InteractionCenterList m_centers;
+};
+
+typedef SmartPtr<InteractionCenterOwner> InteractionCenterOwnerPtr;
+
 // A map of interaction centers indexed by unsigned int
 // Used to store the receptor atom lists at each grid point
 // DM 11 Jul 2000 - use map of regular Atom* list (not AtomPtr smart
@@ -104,7 +123,10 @@ public:
 
 // DM 3 Nov 2000 - replace map by vector for faster lookup
 // typedef std::map<UInt,InteractionCenterList> InteractionListMap;
-typedef std::vector<InteractionCenterList> InteractionListMap;
+// The vector has an entry per grid point, so may be backed by huge pages
+typedef std::vector<InteractionCenterList,
+                    support::HugePageAllocator<InteractionCenterList>>
+    InteractionListMap;
 
 typedef InteractionListMap::iterator InteractionListMapIter;
 typedef InteractionListMap::const_iterator InteractionListMapConstIter;
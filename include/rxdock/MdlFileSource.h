@@ -18,6 +18,8 @@
 #include "rxdock/BaseMolecularFileSource.h"
 #include "rxdock/ElementFileSource.h"
 
+#include <cstdint>
+
 namespace rxdock {
 
 const std::string IDS_MDL_RECDELIM = "$$$$";
@@ -43,6 +45,25 @@ public:
   // DM 12 May 1999 - support for data records
   virtual bool isDataSupported() { return true; }
 
+  // Which records count as the same structure for GetStructureHash
+  enum eStructureMatch {
+    EXACT_MATCH,   // Same connectivity, bond orders, charges, hydrogen counts,
+                   // and tetrahedral and double bond stereochemistry (taken
+                   // from the coordinates)
+    STEREO_MATCH,  // As EXACT_MATCH, ignoring stereochemistry
+    TAUTOMER_MATCH // As STEREO_MATCH, but the hydrogens on N, O and S atoms of
+                   // a conjugated system may move within it, and so may its
+                   // double bonds; the other double bonds are kept
+  };
+
+  // Returns a hash of the canonical labelling of the heavy atom graph of the
+  // current record (after the segment filter), which does not depend on the
+  // order of the atoms or, apart from the stereochemistry, on the
+  // coordinates. Records that match according to eMatch have the same hash.
+  // For very symmetric graphs the search for the canonical labelling is cut
+  // short, which may miss a duplicate but never merges different structures
+  RBTDLL_EXPORT std::uint64_t GetStructureHash(eStructureMatch eMatch);
+
 protected:
   // Pure virtual in BaseFileSource - needs to be defined here
   virtual void Parse();
@@ -48,13 +48,16 @@ private:
   State<DataType, ParameterType> m_state;
   Criterion m_criterion;
 
-  void InitializePolytope(const ParameterType &start_point, DataType delta,
+  // start_value is the value of fun at start_point, which is not evaluated
+  // again
+  void InitializePolytope(const ParameterType &start_point,
+                          DataType start_value, DataType delta,
                           Function &fun) // const
   {
     m_polytopePoints.resize(start_point.size(), start_point.size() + 1);
     m_polytopeValues.resize(1, start_point.size() + 1);
     m_polytopePoints.col(0) = start_point;
-    m_polytopeValues(0, 0) = fun(start_point);
+    m_polytopeValues(0, 0) = start_value;
     Display(fun, m_polytopePoints.col(0));
     for (int i = 1; i < start_point.size() + 1; ++i) {
       m_polytopePoints.col(i) = start_point;
@@ -65,12 +68,13 @@ private:
   }
 
   void InitializePolytope(const ParameterType &start_point,
-                          ParameterType deltas, Function &fun) // const
+                          DataType start_value, ParameterType deltas,
+                          Function &fun) // const
   {
     m_polytopePoints.resize(start_point.size(), start_point.size() + 1);
     m_polytopeValues.resize(1, start_point.size() + 1);
     m_polytopePoints.col(0) = start_point;
-    m_polytopeValues(0, 0) = fun(start_point);
+    m_polytopeValues(0, 0) = start_value;
     Display(fun, m_polytopePoints.col(0));
     for (int i = 1; i < start_point.size() + 1; ++i) {
       m_polytopePoints.col(i) = start_point;
@@ -136,9 +140,11 @@ public:
     m_state.bestValue = std::numeric_limits<DataType>::max();
 
     if (use_deltas) {
-      InitializePolytope(m_state.currentParameters, m_deltas, fun);
+      InitializePolytope(m_state.currentParameters, m_state.currentValue,
+                         m_deltas, fun);
     } else {
-      InitializePolytope(m_state.currentParameters, m_delta, fun);
+      InitializePolytope(m_state.currentParameters, m_state.currentValue,
+                         m_delta, fun);
     }
 
     while (m_criterion(m_state)) {
@@ -192,8 +198,11 @@ public:
               ((m_polytopePoints.colwise() - best_parameters.array()) / 2)
                   .colwise() +
               best_parameters.array();
+          // The best point stays where it is, and so does its value
           for (int i = 0; i < m_polytopePoints.cols(); ++i) {
-            m_polytopeValues(0, i) = fun(m_polytopePoints.col(i));
+            if (i != best) {
+              m_polytopeValues(0, i) = fun(m_polytopePoints.col(i));
+            }
           }
         } else {
           m_state.currentValue = m_polytopeValues(0, worst) = contraction_value;
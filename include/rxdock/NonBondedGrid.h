@@ -17,6 +17,7 @@
 
 #include "rxdock/Atom.h"
 #include "rxdock/BaseGrid.h"
+#include "rxdock/support/HugePages.h"
 
 namespace rxdock {
 
@@ -27,7 +28,9 @@ namespace rxdock {
 
 // DM 3 Nov 2000 - replace map by vector for faster lookup
 // typedef std::map<UInt,AtomRList> AtomListMap;
-typedef std::vector<AtomRList> AtomListMap;
+// The vector has an entry per grid point, so may be backed by huge pages
+typedef std::vector<AtomRList, support::HugePageAllocator<AtomRList>>
+    AtomListMap;
 
 typedef AtomListMap::iterator AtomListMapIter;
 typedef AtomListMap::const_iterator AtomListMapConstIter;
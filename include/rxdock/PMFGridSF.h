@@ -40,6 +40,8 @@ protected:
   virtual void SetupLigand();
   virtual void SetupScore() {}
   virtual double RawScore() const;
+  // Shares the read-only receptor grids with a clone
+  virtual void ShareReceptorData(BaseSF *pClone) const;
   unsigned int GetCorrectedType(PMFType aType) const;
 };
 
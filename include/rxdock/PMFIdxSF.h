@@ -67,6 +67,11 @@ public:
    *  overloaded.
    */
   virtual void Update(Subject *theChangedSubject);
+  /**
+   * The receptor atom contributions to the score are accumulated in the
+   * receptor atoms
+   */
+  virtual bool isReceptorReadOnly() const;
 
 protected:
   /**
@@ -62,6 +62,10 @@ public:
 
   RBTDLL_EXPORT ModelPtr CreateReceptor();
   RBTDLL_EXPORT ModelPtr CreateLigand(BaseMolecularFileSource *pSource);
+  // Makes a ligand flexible within the docking site, replacing any flexibility
+  // it had within another docking site. The ligand can then be docked in turn
+  // against several receptors without being created again
+  RBTDLL_EXPORT void SetLigandFlexData(ModelPtr spLigand);
   RBTDLL_EXPORT ModelList CreateSolvent();
 
 private:
@@ -46,6 +46,9 @@ public:
   // Set named parameter to new value, throws error if name not found
   RBTDLL_EXPORT void SetParameter(const std::string &strName,
                                   const Variant &vValue);
+  // Set each parameter that is also defined in ph to its value in ph.
+  // SetParameter is only called for the values that differ
+  void CopyParameters(const ParamHandler &ph);
 
   // Virtual function for dumping parameters to an output stream
   // Called by operator <<
@@ -48,6 +48,8 @@ protected:
   virtual void SetupSolvent();
   virtual void SetupScore();
   virtual double RawScore() const;
+  // Shares the read-only receptor data with a clone
+  virtual void ShareReceptorData(BaseSF *pClone) const;
 
   // Clear the receptor and ligand grids and lists respectively
   // As we are not using smart pointers, there is some memory management to do
@@ -70,6 +72,7 @@ private:
 
   double InterScore(const InteractionCenterList &posList,
                     const InteractionCenterList &negList, bool bCount) const;
+  InteractionCenterOwnerPtr m_spRecepOwner; // Owns the receptor centers
   InteractionGridPtr m_spPosGrid;
   InteractionGridPtr m_spNegGrid;
   InteractionCenterList m_recepPosList;
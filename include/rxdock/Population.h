@@ -22,10 +22,21 @@ namespace rxdock {
 
 class BaseSF; // forward definition
 
+// A scoring function and a chromosome for the models it scores, independent
+// of those of a population. Used to score the genomes of a population
+// concurrently; the chromosome must have the same layout as the genomes and
+// the scoring function must be set up identically to that of the population.
+struct ScoringReplica {
+  ChromElementPtr spChrom;
+  BaseSF *pSF;
+};
+
+typedef std::vector<ScoringReplica> ScoringReplicaList;
+
 class Population {
 public:
   static const std::string _CT;
-  // Sole constructor to create a randomised genome population of a fixed size.
+  // Constructor to create a randomised genome population of a fixed size.
   // pChr is the seed chromosome to clone to create each genome.
   // size is the population size to create.
   // pSF is the scoring function used to rank the genomes.
@@ -38,7 +49,23 @@ public:
   // 5) Model coords are updated to match the fittest chromosome
   // An BadArgument error is thrown if size is <=0, or if pChr or pSF is
   // null.
-  RBTDLL_EXPORT Population(ChromElement *pChr, int size, BaseSF *pSF);
+  // replicas are optional scoring replicas; if any are given, the genomes are
+  // scored concurrently by one thread using pSF plus one thread per replica.
+  // The first nSeeded genomes (at most size) start from pChr as it is instead
+  // of being randomised: the first is an exact copy, the others are mutated
+  // with relative step size seedStepSize. Used to refine known poses.
+  RBTDLL_EXPORT
+  Population(ChromElement *pChr, int size, BaseSF *pSF,
+             const ScoringReplicaList &replicas = ScoringReplicaList(),
+             int nSeeded = 0, double seedStepSize = 1.0);
+  // Constructor to create a population of a fixed size from copies of the
+  // genomes (e.g. part of another population, as an island of an island-model
+  // GA). The genomes must already be scored with pSF: their scores are kept.
+  // The copies are made with the random number generator of the calling
+  // thread (see GetRandInstance), which the population also uses.
+  // An BadArgument error is thrown if size is <=0, if there are no genomes,
+  // or if pSF is null.
+  RBTDLL_EXPORT Population(const GenomeList &genomes, int size, BaseSF *pSF);
   virtual ~Population();
 
   // Gets the maximum size of the population as defined in the constructor.
@@ -62,6 +89,11 @@ public:
   // changed e.g. in between GA stages. An BadArgument error is thrown if pSF
   // is null. Model coords are updated to match the fittest chromosome
   void SetSF(BaseSF *pSF);
+  // Scores the new genomes with replica.pSF on the models manipulated by
+  // replica.spChrom from now on, without rescoring the population; if
+  // replica.spChrom is null, the models of the genomes are scored. Used to
+  // step populations concurrently, each on its own models
+  void SetScoringReplica(const ScoringReplica &replica);
 
   // Main method for performing a GA iteration
   RBTDLL_EXPORT void
@@ -72,24 +104,68 @@ public:
          bool xovermut, // if true, perform cauchy mutation following crossover
          bool cmutate   // true=cauchy mutations, false=regular mutations
   );
+  // Steady-state alternative to GAstep: the new genomes are created as in
+  // GAstep, scored together, then inserted one at a time into the sorted
+  // population, each displacing the worst genome if the population is full.
+  // Genomes that are worse than the whole of a full population, or equal to
+  // their better neighbour, are discarded. Small batches of new genomes let
+  // the later ones be bred from the best of the earlier ones without waiting
+  // for a whole generation.
+  RBTDLL_EXPORT void
+  SteadyStateStep(int nReplicates, double relStepSize,
+                  double equalityThreshold, double pcross, bool xovermut,
+                  bool cmutate);
+  // Inserts copies of the genomes, which must already be scored with the
+  // scoring function of the population, as SteadyStateStep inserts new
+  // genomes. The copies are made with the random number generator of the
+  // calling thread, or reuse spare genomes of the population.
+  RBTDLL_EXPORT void Insert(const GenomeList &genomes,
+                            double equalityThreshold);
   RBTDLL_EXPORT GenomePtr RouletteWheelSelect() const;
 
   void Print(std::ostream &) const;
   friend std::ostream &operator<<(std::ostream &, const Population &);
 
 private:
+  // Returns the index in the population of a genome chosen by roulette wheel
+  // selection
+  int RouletteWheelSelectIndex() const;
+  // Returns a copy of parent, reusing a spare genome if there is one
+  GenomePtr NewChild(const Genome &parent);
+  // Creates nReplicates new genomes from parents of the population, by
+  // crossover and/or mutation, into m_children
+  void CreateChildren(int nReplicates, double relStepSize, double pcross,
+                      bool xovermut, bool cmutate);
+  // Inserts a scored genome at its place in the sorted population, unless it
+  // is discarded (see SteadyStateStep). Displaced genomes go to m_mergedPop
+  void InsertGenome(const GenomePtr &genome, double equalityThreshold);
+  // Moves the genomes of the list that are referenced nowhere else to the
+  // spare genomes, and clears the list
+  void RecycleGenomes(GenomeList &genomes);
   // Merges the new individuals created into the main population
   // Duplicate genomes are removed (based on equality of chromosome elements,
-  // not scores)
+  // not scores). The genomes that are not kept are recycled
   void MergeNewPop(GenomeList &newPop, double equalityThreshold);
+  // Sets the scores of all genomes in the list using the scoring function and
+  // the scoring replicas
+  void ScoreGenomes(GenomeList &genomes);
   void EvaluateRWFitness();
   Population(const Population &);            // Disable
   Population &operator=(const Population &); // Disable
 
   GenomeList m_pop;       // The population of genomes
+  // Genomes discarded by previous GA steps, reused for the children of the
+  // next ones instead of cloning the chromosome of a parent. The lists of
+  // children and of merged genomes are also kept between steps
+  GenomeList m_spareGenomes;
+  GenomeList m_children;
+  GenomeList m_mergedPop;
   unsigned int m_size;    // The maximum size of the population
   double m_c;             // Sigma Truncation Multiplier
   BaseSF *m_pSF;          // The scoring function
+  ChromElementPtr m_spScoringChrom; // Chromosome of the models scored, if not
+                                    // those of the genomes
+  ScoringReplicaList m_replicas; // Replicas for concurrent scoring
   Rand &m_rand;           // reference to the singleton random number generator
   double m_scoreMean;     // the average raw score across all genomes
   double m_scoreVariance; // the variance of raw scores across all genomes
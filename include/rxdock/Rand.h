@@ -11,7 +11,7 @@
  ***********************************************************************/
 
 // Wrapper around Randint class
-// Function provided to return reference to single instance (singleton) of
+// Function provided to return reference to the calling thread's instance of
 // Rand
 
 #ifndef _RBTRAND_H_
@@ -23,9 +23,11 @@
 #if !defined(__sun) && !(defined(_WIN32) && defined(_MSC_VER))
 #include <pcg_random.hpp>
 #endif
+#include <cstdint>
 #include <random>
 
 #include "rxdock/Coord.h"
+#include "rxdock/SmartPointer.h"
 
 namespace rxdock {
 
@@ -45,6 +47,22 @@ public:
   RBTDLL_EXPORT void Seed(int seed = 0);
   // Seed the random number generator from the random device
   void SeedFromRandomDevice();
+  // Seed the random number generator with the stream of numbers derived from
+  // the seed for run iRun of ligand iLigand. The stream only depends on the
+  // three arguments, so a run draws the same numbers whichever generator and
+  // thread docks it, and whatever was docked before
+  RBTDLL_EXPORT void SeedStream(int seed, std::uint64_t iLigand,
+                                std::uint64_t iRun);
+  // Returns the key of a new set of substreams of the stream of this
+  // generator. The key depends on how the generator was seeded and on the
+  // number of keys returned since, but not on the numbers drawn, and no
+  // number is drawn for it
+  RBTDLL_EXPORT std::uint64_t GetSubstreamKey();
+  // Seed the random number generator with substream iSubstream of the set of
+  // substreams nKey (see GetSubstreamKey), e.g. for one of several islands of
+  // a run to draw from
+  RBTDLL_EXPORT void SeedSubstream(std::uint64_t nKey,
+                                   std::uint64_t iSubstream);
   // Returns current seed
   RBTDLL_EXPORT int GetSeed();
   // Get a random double between 0 and 1
@@ -57,18 +75,32 @@ public:
   double GetCauchyRandom(double, double);
 
 private:
+  // Sets the state and stream of the generator from key
+  void SeedKey(std::uint64_t key);
+
 #if defined(__sun) || (defined(_WIN32) && defined(_MSC_VER))
   std::default_random_engine m_rng;
 #else
   pcg32 m_rng; // Random number generator
 #endif
+  std::uint64_t m_key;            // Key the generator was last seeded with
+  std::uint64_t m_nSubstreamKeys; // Substream keys returned since
 };
 
+// Useful typedefs
+typedef SmartPtr<Rand> RandPtr; // Smart pointer
+
 ///////////////////////////////////////
 // Non-member functions in rxdock namespace
 
-// Returns reference to single instance of Rand class (singleton)
+// Returns reference to the instance of Rand class belonging to the calling
+// thread (one generator per thread), or to the instance installed for the
+// calling thread by SetRandInstance
 RBTDLL_EXPORT Rand &GetRandInstance();
+// Installs pRand as the instance returned by GetRandInstance in the calling
+// thread; nullptr restores the calling thread's own instance. The caller
+// retains ownership of pRand. Returns the previously installed instance
+RBTDLL_EXPORT Rand *SetRandInstance(Rand *pRand);
 
 } // namespace rxdock
 
@@ -24,6 +24,13 @@ public:
   static const std::string _CT;
   static const std::string _POP_SIZE;
   static const std::string _SCALE_CHROM_LENGTH;
+  // Fraction of the population started from the current pose of the models
+  // (e.g. a docked pose read from the ligand file, with its chromosome data
+  // fields) instead of from random poses, for refining known poses
+  static const std::string _SEED_FRACTION;
+  // Relative step size of the mutations of the seeded genomes, all but the
+  // first of which are mutated once
+  static const std::string _SEED_STEP_SIZE;
 
   ////////////////////////////////////////
   // Constructors/destructors
@@ -24,6 +24,7 @@
 #include <unsupported/Eigen/CXX11/Tensor>
 
 #include "rxdock/BaseGrid.h"
+#include "rxdock/support/HugePages.h"
 
 namespace rxdock {
 
@@ -71,7 +72,7 @@ public:
   // Get attribute functions
   /////////////////////////
   float *GetGridData() {
-    float *data = m_grid.data();
+    float *data = m_data.data();
     return data;
   }
 
@@ -85,15 +86,15 @@ public:
 
   // Get/Set single grid point value with bounds checking
   double GetValue(const Coord &c) const {
-    return isValid(c) ? m_grid(GetIX(c), GetIY(c), GetIZ(c)) : 0.0;
+    return isValid(c) ? Grid()(GetIX(c), GetIY(c), GetIZ(c)) : 0.0;
   }
 
   double GetValue(unsigned int iX, unsigned int iY, unsigned int iZ) const {
-    return isValid(iX, iY, iZ) ? m_grid(iX, iY, iZ) : 0.0;
+    return isValid(iX, iY, iZ) ? Grid()(iX, iY, iZ) : 0.0;
   }
 
   double GetValue(unsigned int iXYZ) const {
-    const float *data = m_grid.data();
+    const float *data = m_data.data();
     return isValid(iXYZ) ? data[iXYZ] : 0.0;
   }
 
@@ -103,16 +104,16 @@ public:
 
   void SetValue(const Coord &c, double val) {
     if (isValid(c))
-      m_grid(GetIX(c), GetIY(c), GetIZ(c)) = val;
+      Grid()(GetIX(c), GetIY(c), GetIZ(c)) = val;
   }
 
   void SetValue(unsigned int iX, unsigned int iY, unsigned int iZ, double val) {
     if (isValid(iX, iY, iZ))
-      m_grid(iX, iY, iZ) = val;
+      Grid()(iX, iY, iZ) = val;
   }
 
   void SetValue(unsigned int iXYZ, double val) {
-    float *data = m_grid.data();
+    float *data = m_data.data();
     if (isValid(iXYZ))
       data[iXYZ] = val;
   }
@@ -221,11 +222,24 @@ protected:
   ////////////////
 
 private:
+  typedef Eigen::TensorMap<Eigen::Tensor<float, 3, Eigen::RowMajor>> GridMap;
+  typedef Eigen::TensorMap<const Eigen::Tensor<float, 3, Eigen::RowMajor>>
+      ConstGridMap;
+
+  // 3-D array view of the grid values, accessed as Grid()(i, j, k), indicies
+  // from 0
+  GridMap Grid() { return GridMap(m_data.data(), GetNX(), GetNY(), GetNZ()); }
+  ConstGridMap Grid() const {
+    return ConstGridMap(m_data.data(), GetNX(), GetNY(), GetNZ());
+  }
+
   ////////////////////////////////////////
   // Private data
   //////////////
-  Eigen::Tensor<float, 3, Eigen::RowMajor>
-      m_grid;   // 3-D array, accessed as m_grid(i, j, k), indicies from 0
+  // Grid values, in row-major order. They may span hundreds of MB and are
+  // read at random while scoring, so they may be backed by huge pages (see
+  // support::setHugePageMode)
+  std::vector<float, support::HugePageAllocator<float>> m_data;
   double m_tol; // Tolerance for comparing grid values;
 };
 
@@ -0,0 +1,116 @@
+//===-- ResultCache.h - On-disk store of docking results --------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// On-disk store of docking results.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef RXDOCK_RESULTCACHE_H
+#define RXDOCK_RESULTCACHE_H
+
+#include "rxdock/Config.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rxdock {
+
+///
+/// \brief Keeps the docked poses of ligands in a directory, so that a ligand
+/// docked again by the same job does not need docking.
+///
+/// A job is identified by its key, the text of everything the poses depend on
+/// other than the ligand: the receptor, docking site, scoring function, grids,
+/// protocol, options and seed. The key of each job using the cache is kept in
+/// jobs/<hash>.txt, named after its 64-bit hash, and a job whose key has the
+/// hash of the key of another job is rejected.
+///
+/// Each entry holds the text of the SD records of the poses of a ligand, after
+/// the hash of the job and the input record the ligand was docked from. It is
+/// stored in a file named after the hash of the job and of the connection
+/// table of the ligand (see GetConnectionTable), and only found by the same
+/// job for a ligand with the same connection table.
+///
+/// Entries are written to a temporary file and renamed into place, so the
+/// cache can be shared by processes docking at the same time, on any
+/// filesystem with atomic rename.
+///
+class ResultCache {
+public:
+  ///
+  /// \brief Opens the cache in directory \p dirName for the job with key
+  /// \p strJobKey, creating the directory and storing the key if needed.
+  ///
+  /// \throw FileWriteError if the directory or the key can not be written
+  /// \throw InvalidRequest if the cache holds another job key with the same
+  /// hash
+  ///
+  RBTDLL_EXPORT ResultCache(const std::string &dirName,
+                            const std::string &strJobKey);
+
+  std::string GetDirName() const { return m_strDirName; }
+  std::uint64_t GetJobHash() const { return m_nJobHash; }
+
+  ///
+  /// \brief Returns true and the text stored for the ligand of the SD record
+  /// lines \p lineRecs, if there is any, with the lines of the record it was
+  /// docked from in \p storedLineRecs.
+  ///
+  /// The stored record has the same connection table, but its title and data
+  /// fields may differ.
+  ///
+  RBTDLL_EXPORT bool Lookup(const std::vector<std::string> &lineRecs,
+                            std::vector<std::string> &storedLineRecs,
+                            std::string &text) const;
+
+  ///
+  /// \brief Stores \p text for the ligand of the SD record lines \p lineRecs,
+  /// replacing any previous entry.
+  ///
+  /// \throw FileWriteError if the entry can not be written
+  ///
+  RBTDLL_EXPORT void Store(const std::vector<std::string> &lineRecs,
+                           const std::string &text);
+
+  ///
+  /// \brief Returns the connection table of the lines of an SD record.
+  ///
+  /// The connection table runs from the counts line to the M  END line, with
+  /// the coordinates. It leaves out the header, whose program and comment
+  /// lines differ between exports of the same library, and the data fields,
+  /// and so does not depend on them. Trailing spaces are left out too.
+  ///
+  RBTDLL_EXPORT static std::string
+  GetConnectionTable(const std::vector<std::string> &lineRecs);
+
+private:
+  ResultCache(const ResultCache &);            // Copy constructor disabled
+  ResultCache &operator=(const ResultCache &); // Copy assignment disabled
+
+  // Entries are spread over 256 subdirectories, named after the first two
+  // digits of their keys
+  std::string GetEntryFileName(std::uint64_t key) const;
+
+  // Writes text to fileName through a temporary file renamed into place
+  static void WriteFile(const std::string &fileName, const std::string &text);
+
+  std::string m_strDirName;
+  std::uint64_t m_nJobHash;
+};
+
+typedef SmartPtr<ResultCache> ResultCachePtr;
+
+} // namespace rxdock
+
+#endif // RXDOCK_RESULTCACHE_H
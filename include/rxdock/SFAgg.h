@@ -49,6 +49,11 @@ public:
   //(for saving in a Model's data fields)
   virtual void ScoreMap(StringVariantMap &scoreMap) const;
 
+  // Aggregate version clones all children
+  virtual SFAgg *Clone() const;
+  // Aggregate version checks all children
+  virtual bool isReceptorReadOnly() const;
+
   // Aggregate handling methods
   virtual void Add(BaseSF *);
   virtual void Remove(BaseSF *);
@@ -0,0 +1,125 @@
+//===-- ScreeningProtocol.h - Multi-stage screening protocol ----*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Multi-stage protocol for high-throughput virtual screening.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef RXDOCK_SCREENINGPROTOCOL_H
+#define RXDOCK_SCREENINGPROTOCOL_H
+
+#include "rxdock/Config.h"
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace rxdock {
+
+///
+/// \brief Stops docking the ligands that do not look promising after a few
+/// runs.
+///
+/// A ligand is docked in stages. Stage k ends once the ligand has been docked
+/// GetStages()[k].nRuns times in total, and the ligand goes on to the next
+/// stage only if its best score so far is at most the threshold of the stage.
+/// The ligands that pass all the stages are docked up to GetMaxRuns() times.
+/// Lower scores are better.
+///
+/// The thresholds are calibrated with Calibrate() from the run scores of a
+/// training subset of the library, docked exhaustively.
+///
+class ScreeningProtocol {
+public:
+  struct Stage {
+    std::size_t nRuns; // Runs of the ligand by the end of the stage
+    double dThreshold; // Best score needed to go on to the next stage
+  };
+
+  ///
+  /// \brief Creates a protocol from its stages.
+  ///
+  /// \p strScoreName is the score data field compared to the thresholds,
+  /// without the metadata prefix (e.g. "score.inter").
+  /// \throw BadArgument unless the stages end after an increasing number of
+  /// runs, all less than \p nMaxRuns
+  ///
+  RBTDLL_EXPORT ScreeningProtocol(const std::vector<Stage> &stages,
+                                  std::size_t nMaxRuns,
+                                  const std::string &strScoreName);
+  RBTDLL_EXPORT ScreeningProtocol(json j);
+
+  RBTDLL_EXPORT friend std::ostream &operator<<(std::ostream &s,
+                                                const ScreeningProtocol &p);
+  RBTDLL_EXPORT friend void to_json(json &j, const ScreeningProtocol &p);
+  friend void from_json(const json &j, ScreeningProtocol &p);
+
+  const std::vector<Stage> &GetStages() const { return m_stages; }
+  std::size_t GetMaxRuns() const { return m_nMaxRuns; }
+  std::string GetScoreName() const { return m_strScoreName; }
+
+  /// Returns the number of runs done by the end of the stage of run iRun
+  /// (counting from 0)
+  RBTDLL_EXPORT std::size_t GetStageEnd(std::size_t iRun) const;
+
+  /// Returns true if a ligand with best score dBestScore after nRuns runs is
+  /// to be docked again
+  RBTDLL_EXPORT bool Continue(std::size_t nRuns, double dBestScore) const;
+
+  ///
+  /// \brief Simulates the protocol on the run scores of ligands docked
+  /// exhaustively, in run order.
+  ///
+  /// \param passFractions fraction of the ligands passing each stage
+  /// \return the average number of runs per ligand
+  ///
+  RBTDLL_EXPORT double
+  Simulate(const std::vector<std::vector<double>> &runScores,
+           std::vector<double> &passFractions) const;
+
+  ///
+  /// \brief Sets the thresholds from the run scores of ligands docked
+  /// exhaustively, in run order.
+  ///
+  /// The threshold of stage k is chosen so that a fraction
+  /// \p keepFractions[k] of all the ligands pass it, given the ligands
+  /// that passed the previous stages.
+  /// \throw BadArgument if there are no ligands, or if the fractions are not
+  /// in (0, 1] and non-increasing
+  ///
+  RBTDLL_EXPORT static ScreeningProtocol
+  Calibrate(const std::vector<std::vector<double>> &runScores,
+            const std::vector<std::size_t> &stageRuns,
+            const std::vector<double> &keepFractions, std::size_t nMaxRuns,
+            const std::string &strScoreName);
+
+private:
+  ScreeningProtocol(); // Default constructor disabled
+
+  void Validate() const;
+
+  std::vector<Stage> m_stages;
+  std::size_t m_nMaxRuns;
+  std::string m_strScoreName;
+};
+
+typedef SmartPtr<ScreeningProtocol> ScreeningProtocolPtr;
+
+std::ostream &operator<<(std::ostream &s, const ScreeningProtocol &p);
+
+RBTDLL_EXPORT void to_json(json &j, const ScreeningProtocol &p);
+void from_json(const json &j, ScreeningProtocol &p);
+
+} // namespace rxdock
+
+#endif // RXDOCK_SCREENINGPROTOCOL_H
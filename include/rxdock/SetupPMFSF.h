@@ -32,6 +32,8 @@ protected:
   virtual void SetupLigand();
   virtual void SetupScore();
   virtual double RawScore() const;
+  // Shares the read-only receptor data with a clone
+  virtual void ShareReceptorData(BaseSF *pClone) const;
 
   void SetupReceptorPMFTypes(void);
   void SetupLigandPMFTypes(void);
@@ -44,6 +44,8 @@ protected:
   virtual void SetupSolvent();
   virtual void SetupScore();
   virtual double RawScore() const;
+  // Shares the read-only receptor data with a clone
+  virtual void ShareReceptorData(BaseSF *pClone) const;
 
 private:
   void SetupAtomList(AtomList &atomList, const AtomList &neighbourList);
@@ -32,9 +32,8 @@ public:
   typedef Eigen::VectorXd ParameterType;
   double operator()(const ParameterType &parameters) { // const
     nCalls++;
-    std::vector<double> vec(parameters.data(),
-                            parameters.data() + parameters.size());
-    m_chrom->SetVector(vec);
+    m_vec.assign(parameters.data(), parameters.data() + parameters.size());
+    m_chrom->SetVector(m_vec);
     m_chrom->SyncToModel();
     return m_pSF->Score();
   }
@@ -43,6 +42,7 @@ public:
 private:
   BaseSF *m_pSF;
   ChromElementPtr m_chrom;
+  std::vector<double> m_vec; // Reused for the parameters of each call
 };
 
 } // namespace rxdock
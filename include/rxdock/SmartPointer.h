@@ -18,7 +18,7 @@
 // We don't use a separate reference counting object, but rather store two
 // pointers in each smart pointer:
 // 1) Pointer to underlying object
-// 2) Pointer to unsigned int (reference counter)
+// 2) Pointer to atomic unsigned int (reference counter)
 //
 // Pros: the only way I could think of to be able to implement assignment of
 //      subclass smart pointer to base class smart pointer
@@ -36,6 +36,8 @@
 
 //#include "rxdock/Error.h"
 
+#include <atomic>
+
 namespace rxdock {
 
 // Only check smart pointer assertions in debug build
@@ -55,7 +57,7 @@ public:
 
   // Parameterised constructor
   // Create new counter, initialise to 1
-  SmartPtr(T *pT) : m_pT(pT), m_pCount(new unsigned int(1)) {}
+  SmartPtr(T *pT) : m_pT(pT), m_pCount(new std::atomic<unsigned>(1)) {}
 
   // Copy constructor - copy both pointers, increment counter
   SmartPtr(const SmartPtr<T> &sp) : m_pT(sp.m_pT), m_pCount(sp.m_pCount) {
@@ -118,7 +120,10 @@ public:
   bool Null() const { return m_pCount == nullptr; }
 
   // Returns pointer to counter
-  unsigned *GetCountPtr() const { return m_pCount; }
+  std::atomic<unsigned> *GetCountPtr() const { return m_pCount; }
+
+  // Tests if this is the only smart pointer to the underlying object
+  bool IsUnique() const { return !Null() && *m_pCount == 1; }
 
   // Returns underlying pointer
   T *Ptr() { return m_pT; }
@@ -174,8 +179,11 @@ private:
     m_pCount = nullptr;
   }
 
-  T *m_pT;            // Pointer to the underlying object
-  unsigned *m_pCount; // Pointer to counter
+  T *m_pT; // Pointer to the underlying object
+  // Pointer to counter. The counter is atomic so that objects shared between
+  // docking threads (docking site, file sinks, grids) can be safely referenced
+  // from several threads at once
+  std::atomic<unsigned> *m_pCount;
 };
 
 /////////////////////////////////////////////////////
@@ -49,6 +49,9 @@ public:
   virtual unsigned int GetNumTransforms() const;
   virtual BaseTransform *GetTransform(unsigned int iTransform) const;
 
+  // Aggregate version clones all children
+  virtual TransformAgg *Clone() const;
+
   // WorkSpace handling methods
   // Register scoring function with a workspace
   // Aggregate version registers all children, but NOT itself
@@ -41,6 +41,8 @@ protected:
   virtual void SetupSolvent();
   virtual void SetupScore();
   virtual double RawScore() const;
+  // Shares the read-only receptor data with a clone
+  virtual void ShareReceptorData(BaseSF *pClone) const;
   // DM 25 Oct 2000 - track changes to parameter values in local data members
   // ParameterUpdated is invoked by ParamHandler::SetParameter
   void ParameterUpdated(const std::string &strName);
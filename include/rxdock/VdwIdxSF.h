@@ -52,6 +52,8 @@ protected:
   virtual void SetupSolvent();
   virtual void SetupScore();
   virtual double RawScore() const;
+  // Shares the read-only receptor data with a clone
+  virtual void ShareReceptorData(BaseSF *pClone) const;
   double InterScore() const;
   double ReceptorScore() const;
   double SolventScore() const;
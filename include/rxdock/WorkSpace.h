@@ -28,6 +28,7 @@
 #include "rxdock/Model.h"
 #include "rxdock/ParamHandler.h"
 #include "rxdock/Population.h"
+#include "rxdock/Rand.h"
 #include "rxdock/Subject.h"
 
 namespace rxdock {
@@ -82,6 +83,14 @@ public:
   // Removes a number of models from the workspace
   // Removes from index iModel to end of model list
   void RemoveModels(unsigned int iModel);
+  // Returns the coordinates of the models that move during docking: the
+  // ligand, any solvent and a flexible receptor. The coordinate lists of the
+  // other models are left empty
+  RBTDLL_EXPORT std::vector<CoordList> GetMobileCoords() const;
+  // Restores the coordinates returned by GetMobileCoords. The mapping of a
+  // chromosome to the model coordinates depends on the coordinates it starts
+  // from, so these are restored to score a chromosome reproducibly
+  RBTDLL_EXPORT void SetMobileCoords(const std::vector<CoordList> &coords);
 
   // Model I/O
   // Get/set the molecular file sink (for outputting ligands)
@@ -111,6 +120,14 @@ public:
   BaseTransform *GetTransform() const;
   RBTDLL_EXPORT void SetTransform(BaseTransform *);
 
+  // Get/Set the random number generator
+  // Run installs the generator as the generator of the calling thread for the
+  // duration of the simulation, so that the transforms, populations and
+  // chromosomes created during the run draw from it. If no generator is set,
+  // the generator of the calling thread is used
+  RandPtr GetRand() const;
+  RBTDLL_EXPORT void SetRand(RandPtr spRand);
+
   // Run the simulation!
   virtual void Run();
 
@@ -120,6 +137,15 @@ public:
   PopulationPtr GetPopulation() const;
   void ClearPopulation();
 
+  // Scoring replica handling
+  // Replicas are workspaces with independent copies of the models and the
+  // scoring function of this workspace, used to score populations
+  // concurrently. The caller retains ownership of the replicas and must keep
+  // their models consistent with the models of this workspace
+  RBTDLL_EXPORT void
+  SetScoringReplicas(const std::vector<WorkSpace *> &replicas);
+  std::vector<WorkSpace *> GetScoringReplicas() const;
+
   // Docking site handling
   // DM 09 Apr 2002 - workspace now manages the docking site
   RBTDLL_EXPORT DockingSitePtr GetDockingSite() const;
@@ -161,6 +187,8 @@ private:
   BaseSF *m_SF;
   BaseTransform *m_transform;
   PopulationPtr m_population;
+  RandPtr m_spRand;
+  std::vector<WorkSpace *> m_scoringReplicas;
   DockingSitePtr m_spDockSite;
   FilterPtr m_spFilter;
 };
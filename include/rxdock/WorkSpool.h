@@ -0,0 +1,135 @@
+//===-- WorkSpool.h - Filesystem lease-based work queue ---------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Distributes chunks of work between processes sharing a spool directory.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef RXDOCK_WORKSPOOL_H
+#define RXDOCK_WORKSPOOL_H
+
+#include "rxdock/Config.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace rxdock {
+
+///
+/// \brief Hands out chunks of a job to processes sharing a spool directory.
+///
+/// The job is split into a fixed number of chunks, recorded in spool.json by
+/// the first process. A process claims chunk i by creating chunk-i.lease
+/// exclusively, and renews the lease by touching it while it works on the
+/// chunk. Once the chunk is complete the lease is renamed to chunk-i.done.
+/// A lease that has not been renewed for the lease timeout belongs to a
+/// process that died, and the chunk is claimed again by another process,
+/// which replaces the lease with its own in one step. The reclaiming
+/// processes take turns by creating chunk-i.reclaim exclusively.
+///
+/// A process that stalls for longer than the lease timeout may lose its
+/// lease to another process. It finds out when it next renews the lease, and
+/// must then stop working on the chunk, which is reported by LeaseLost and to
+/// the function set with SetLeaseLost.
+///
+/// Only needs a filesystem with atomic exclusive create and rename (any
+/// local filesystem, NFS version 3 or later). The clocks of the hosts must
+/// agree to well within the lease timeout.
+///
+class WorkSpool {
+public:
+  /// Called by the renewing thread when the lease of the current chunk is lost
+  typedef std::function<void()> LeaseLostFunction;
+
+  ///
+  /// \brief Joins the spool in directory \p dirName, creating it if needed.
+  ///
+  /// \p strJob identifies the job (e.g. the input file name and a hash of
+  /// the options the results depend on); the processes of a spool must all
+  /// be given the same job and \p nChunks.
+  /// \throw FileWriteError if the spool directory can not be used
+  /// \throw BadArgument if the spool is for a different job
+  ///
+  RBTDLL_EXPORT WorkSpool(const std::string &dirName,
+                          const std::string &strJob, std::size_t nChunks,
+                          double dLeaseTimeout);
+
+  /// Stops renewing and releases the lease of the current chunk, if any
+  RBTDLL_EXPORT ~WorkSpool();
+
+  std::size_t GetNumChunks() const { return m_nChunks; }
+
+  /// Returns the name of a file in the spool directory for chunk \p iChunk
+  RBTDLL_EXPORT std::string GetChunkFileName(std::size_t iChunk,
+                                             const std::string &suffix) const;
+
+  ///
+  /// \brief Claims a chunk that is neither done nor leased by a live process.
+  ///
+  /// If all the remaining chunks are leased, waits for them to be done or for
+  /// their leases to expire.
+  /// \return false if all the chunks are done
+  ///
+  RBTDLL_EXPORT bool Claim(std::size_t &iChunk);
+
+  /// Sets the function called when the lease of the current chunk is lost
+  RBTDLL_EXPORT void SetLeaseLost(LeaseLostFunction leaseLost);
+
+  /// Returns true if the lease of the current chunk has been lost
+  bool LeaseLost() const { return m_bLeaseLost; }
+
+  ///
+  /// \brief Marks the current chunk as done.
+  ///
+  /// \return false if the lease of the chunk has been lost, in which case
+  /// the chunk is left to the process that reclaimed it
+  ///
+  RBTDLL_EXPORT bool Complete();
+
+  /// Gives the current chunk up so that another process can claim it, unless
+  /// its lease has been lost
+  RBTDLL_EXPORT void Release();
+
+private:
+  WorkSpool(const WorkSpool &);            // Copy constructor disabled
+  WorkSpool &operator=(const WorkSpool &); // Copy assignment disabled
+
+  bool TryClaim(std::size_t iChunk);
+  bool ReclaimExpired(std::size_t iChunk);
+  bool WriteLease(const std::string &strLeaseFile, bool bReplace);
+  bool OwnsLease(const std::string &strLeaseFile) const;
+  void StartRenewing(std::size_t iChunk);
+  void StopRenewing();
+  void RenewLoop(std::string strLeaseFile);
+
+  std::string m_strDirName;
+  std::string m_strWorkerId; // Written to the leases of this process
+  std::size_t m_nChunks;
+  double m_dLeaseTimeout;
+  bool m_bHasChunk;
+  std::size_t m_iChunk;
+
+  std::mutex m_mutex;
+  std::condition_variable m_stopRenewing;
+  bool m_bStopRenewing;
+  std::atomic<bool> m_bLeaseLost;
+  LeaseLostFunction m_leaseLost;
+  std::thread m_renewThread;
+};
+
+} // namespace rxdock
+
+#endif // RXDOCK_WORKSPOOL_H
@@ -0,0 +1,51 @@
+//===-- CalibrateScreening.h - Calibrate screening operation ----*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Calibrate screening operation.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef RXDOCK_OPERATION_CALIBRATESCREENING_H
+#define RXDOCK_OPERATION_CALIBRATESCREENING_H
+
+#include "rxdock/support/Export.h"
+
+#include <string>
+#include <vector>
+
+namespace rxdock {
+namespace operation {
+
+///
+/// \brief Calibrates a multi-stage screening protocol for dock.
+///
+/// \p inputSDFile holds the poses of a training subset of the library,
+/// docked exhaustively with all the poses written, in run order (the poses
+/// of a ligand are the consecutive records with the same title). Stage k of
+/// the protocol ends after \p stageRuns[k] runs, with the threshold on
+/// \p scoreName that a fraction \p keepFractions[k] of the training ligands
+/// pass; the ligands that pass all the stages get up to \p nMaxRuns runs.
+/// The protocol is written to \p outputFile, and its simulated cost on the
+/// training ligands is printed.
+///
+RBTDLL_EXPORT int calibrateScreening(std::string inputSDFile,
+                                     std::string outputFile,
+                                     std::vector<std::size_t> stageRuns,
+                                     std::vector<double> keepFractions,
+                                     std::size_t nMaxRuns,
+                                     std::string scoreName);
+
+} // namespace operation
+} // namespace rxdock
+
+#endif // RXDOCK_OPERATION_CALIBRATESCREENING_H
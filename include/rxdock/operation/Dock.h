@@ -21,21 +21,270 @@
 #include "rxdock/support/Export.h"
 
 #include <string>
+#include <vector>
 
 namespace rxdock {
 namespace operation {
 
 ///
-/// \brief Docks ligand(s) to the receptor.
+/// \brief Options of the dock, serve and crossDock operations.
+///
+/// The defaults are those of rxcmd dock, apart from the file names, which
+/// must be given.
+///
+struct DockOptions {
+  /// Input ligand SD file
+  std::string strLigandMdlFile;
+  /// Output SD file, compressed with gzip if its name ends with ".gz"
+  std::string strOutputMdlFile;
+  /// Whether to write the receptor to the CRD file strOutputCrdFile
+  bool bOutputCrd = false;
+  std::string strOutputCrdFile;
+  /// Whether to write the history of each run to an SD file whose name
+  /// starts with strOutputHistoryFilePrefix
+  bool bOutputHistory = false;
+  std::string strOutputHistoryFilePrefix;
+  /// Receptor parameter file
+  std::string strReceptorPrmFile;
+  /// Docking protocol parameter file
+  std::string strParamFile;
+  /// Whether to use the termination filter of strFilterFile instead of the
+  /// one built from the options below
+  bool bFilter = false;
+  std::string strFilterFile;
+  /// Whether to dock at most nDockingRuns runs of each ligand
+  bool bDockingRuns = false;
+  std::size_t nDockingRuns = 50;
+  /// Whether to protonate positive and deprotonate negative ionisable groups
+  bool bPosIonise = false;
+  bool bNegIonise = false;
+  /// Whether to read all the hydrogens instead of only the polar ones
+  bool bExplH = false;
+  /// Whether to stop docking a ligand once its intermolecular score reaches
+  /// dTargetScore, unless bContinue
+  bool bTarget = false;
+  double dTargetScore = 0.0;
+  bool bContinue = false;
+  /// Whether to seed the random number generator with nSeed instead of
+  /// std::random_device. With a seed, the poses do not depend on the number
+  /// of docking, run and scoring threads below
+  bool bSeed = false;
+  std::size_t nSeed = 0;
+
+  /// Number of threads docking different ligands (0 = all available cores),
+  /// each with its own workspace
+  std::size_t nThreads = 1;
+  /// Number of runs of each ligand docked concurrently by each docking thread
+  /// (0 = all available cores), in additional workspaces. The runs are then
+  /// filtered and saved in run order
+  std::size_t nRunThreads = 1;
+  /// Number of threads scoring the genetic algorithm populations of each run
+  /// (0 = all available cores)
+  std::size_t nScoringThreads = 1;
+
+  ///
+  /// \brief Size in MiB of the docked poses kept in memory for writing the
+  /// output in input order (0 = 64).
+  ///
+  /// The docked poses are written by a background thread, in the order of the
+  /// input ligands. The poses of the ligands that are done while an earlier
+  /// ligand is still docking are kept in memory; once the window is full, the
+  /// docking threads wait for the earlier ligand. The history files are
+  /// written by a background thread too, with a window of the same size.
+  ///
+  std::size_t nOutputWindow = 0;
+
+  ///
+  /// \brief File the number of ligands written so far and the matching input
+  /// and output file offsets are saved to every dCheckpointInterval seconds,
+  /// if not empty.
+  ///
+  /// With bResume, docking continues from the checkpoint, if it exists: the
+  /// output is truncated to the last ligand written and the following ligands
+  /// are appended to it.
+  ///
+  std::string strCheckpointFile;
+  double dCheckpointInterval = 60.0;
+  bool bResume = false;
+
+  ///
+  /// \brief With nShards > 1, only shard iShard (counting from 0) of the
+  /// ligands is docked.
+  ///
+  /// The shards split the input file into contiguous ranges of records of
+  /// about the same size in bytes, found by seeking rather than by reading the
+  /// records of the other shards. The ligands of a shard are numbered from
+  /// its first record.
+  ///
+  std::size_t iShard = 0;
+  std::size_t nShards = 1;
+
+  ///
+  /// \brief Spool directory, if not empty.
+  ///
+  /// The ligands are split into nSpoolChunks shards, which are docked by all
+  /// the processes sharing the spool directory as they claim them (see
+  /// WorkSpool), until all of them are done. Each process sets the receptor
+  /// and scoring function up once for all the chunks it docks. A chunk whose
+  /// process stops renewing its lease for dLeaseTimeout seconds is claimed
+  /// again and resumed from its checkpoint; the process that stalled stops
+  /// docking it and goes on with the other chunks. The processes of a spool
+  /// must dock the same input with the same receptor, protocol, run options
+  /// and seed. Chunk i is written to strOutputMdlFile with "_chunk<i>"
+  /// inserted before the extension.
+  ///
+  std::string strSpoolDir;
+  std::size_t nSpoolChunks = 100;
+  double dLeaseTimeout = 600.0;
+
+  ///
+  /// \brief Multi-stage screening protocol file, if not empty (see
+  /// ScreeningProtocol, and calibrateScreening).
+  ///
+  /// A ligand is only docked again while its best score beats the threshold of
+  /// each stage it completes. The maximum number of runs of the protocol
+  /// replaces nDockingRuns.
+  ///
+  std::string strScreeningFile;
+
+  ///
+  /// \brief With nConvergence > 0, docking a ligand stops once the best
+  /// scoring pose of its runs has been found nConvergence times.
+  ///
+  /// The runs whose pose is within dConvergenceRMSD (heavy atoms, no
+  /// symmetry) of the best pose count as finding it.
+  ///
+  std::size_t nConvergence = 0;
+  double dConvergenceRMSD = 1.0;
+
+  ///
+  /// \brief With nScheduleWindow > 1, the input is read nScheduleWindow
+  /// records at a time and the ligands of each window are docked in order of
+  /// decreasing predicted cost (heavy atoms times chromosome length).
+  ///
+  /// The largest ligands then do not start last and hold up the end of a
+  /// parallel job. The poses are still written in input order.
+  ///
+  std::size_t nScheduleWindow = 0;
+
+  ///
+  /// \brief Result cache directory, if not empty (see ResultCache).
+  ///
+  /// The poses of each ligand that docks are stored in the cache, and a ligand
+  /// found in it is not docked again: its stored poses are written instead,
+  /// with the title and input data fields of its record. The entries are
+  /// keyed by the connection table of the ligand, and by the receptor,
+  /// docking site, scoring function, grids, protocol, run options and seed of
+  /// the job, so a cache can be shared by jobs that differ in any of them.
+  /// The cache is only used with a seed, as the poses are not reproducible
+  /// without one.
+  ///
+  std::string strCacheDir;
+
+  ///
+  /// \brief How duplicate ligands are matched, if not empty: "exact" to match
+  /// identical structures, "stereo" to also match stereoisomers, or
+  /// "tautomer" to also match tautomers and stereoisomers.
+  ///
+  /// The ligand of each record is hashed as the record is read (see
+  /// MdlFileSource::GetStructureHash), and only the first record of each
+  /// structure is docked. Its poses are also written for each of its
+  /// duplicates, with the title and input data fields of the duplicate and the
+  /// number of the first record in the duplicate_of data field. The poses of
+  /// the first records are kept in a temporary file for the duplicates read
+  /// after they are docked.
+  ///
+  std::string strDuplicateMatch;
+
+  ///
+  /// \brief Whether to replicate the receptor data on the NUMA nodes.
+  ///
+  /// The docking threads are spread over the NUMA nodes of the host in turn
+  /// and bound to the CPUs of their node, and the docking site, receptor and
+  /// scoring function grids are set up once per node, by a thread bound to
+  /// it, so that each thread scores with receptor data in the memory of its
+  /// own node. Otherwise all the threads share one copy.
+  ///
+  bool bNumaReplicas = false;
+};
+
+///
+/// \brief Docks the ligands of options.strLigandMdlFile to the receptor,
+/// writing the poses to options.strOutputMdlFile.
+///
+RBTDLL_EXPORT int dock(const DockOptions &options);
+
+///
+/// \brief Serves docking requests, with the receptor, docking site, scoring
+/// function and grids loaded once for all of them.
+///
+/// Ligands are read as SD records from the Unix domain socket \p strSocket,
+/// one client session per connection, or if \p strSocket is empty from
+/// standard input, as a single session. Everything else printed then goes to
+/// standard error, leaving standard output for the responses.
+///
+/// A session starts with the line {"ready": true}. Each ligand then gets a
+/// response, in the order the ligands were sent: a JSON header line
+/// {"record": n, "name": title, "docked": true or false, "poses": k} followed
+/// by the k docked poses as SD records, with their score fields. The session
+/// ends when the client closes its end of the connection (or standard input).
+/// The ligands of a session are docked as by dock, with the same options;
+/// the socket server runs until it is killed. The file, checkpoint, shard,
+/// spool, schedule, cache and duplicate options are not used.
+///
+/// The socket sessions are served one at a time, each with all the docking
+/// threads. The ligands are read by a thread of their own, so a slow client
+/// does not hold up the docking of the ligands it has sent. A client that
+/// sends nothing for \p dTimeout seconds while all its ligands are answered
+/// has its session ended, so that the next client gets its turn (0 = never).
+/// The socket is created with permissions for the user only.
+///
+RBTDLL_EXPORT int serve(const DockOptions &options,
+                        const std::string &strSocket,
+                        double dTimeout = 600.0);
+
+///
+/// \brief Docks each ligand against several receptors in turn.
+///
+/// Each ligand record is read and its model created once, then made flexible
+/// within the docking site of each receptor of \p receptorPrmFiles in turn and
+/// docked against it as by dock, with the same docking protocol. The workspace
+/// of each receptor, with its scoring function and grids, is set up once by
+/// each docking thread and kept for all the ligands.
+///
+/// The poses of a ligand against all the receptors are written together to
+/// options.strOutputMdlFile, in the order of \p receptorPrmFiles, with the
+/// receptor in the rxdock.program.receptor data field. With a seed, the poses
+/// of a ligand against a receptor are the same as those docked by dock. Only
+/// the input, output, filter, run, ionisation, hydrogen, seed, thread and
+/// output window options are used.
 ///
 RBTDLL_EXPORT int
-dock(std::string strLigandMdlFile, std::string strOutputMdlFile,
-     bool bOutputCrd, std::string strOutputCrdFile, bool bOutputHistory,
-     std::string strOutputHistoryFilePrefix, std::string strReceptorPrmFile,
-     std::string strParamFile, bool bFilter, std::string strFilterFile,
-     bool bDockingRuns, std::size_t nDockingRuns, bool bPosIonise,
-     bool bNegIonise, bool bExplH, bool bTarget, double dTargetScore,
-     bool bContinue, bool bSeed, std::size_t nSeed);
+crossDock(const DockOptions &options,
+          const std::vector<std::string> &receptorPrmFiles);
+
+///
+/// \brief Rescores existing poses, without docking them.
+///
+/// The poses of \p strInputMdlFile are scored by \p nThreads threads (0 = all
+/// available cores) with the scoring function of the protocol \p strParamFile,
+/// after running its transforms on them: with score.json a pose is scored as
+/// it is, with minimise.json it is minimised first. Each pose is done once,
+/// without the termination filter, history or per-pose messages of dock;
+/// only the poses that fail are reported.
+///
+/// \p strOutputFile gets the SD records of the poses with their score fields,
+/// in input order, or with \p bScoresOnly a JSON line per pose:
+/// {"record": n, "name": title, "rxdock.score": ..., ...}. Up to
+/// \p nOutputWindow MiB of them (0 = 64) are kept in memory to write them in
+/// input order.
+///
+RBTDLL_EXPORT int rescore(std::string strInputMdlFile,
+                          std::string strOutputFile,
+                          std::string strReceptorPrmFile,
+                          std::string strParamFile, bool bPosIonise,
+                          bool bNegIonise, bool bExplH, bool bScoresOnly,
+                          std::size_t nThreads, std::size_t nOutputWindow = 0);
 
 } // namespace operation
 } // namespace rxdock
@@ -0,0 +1,71 @@
+//===-- Hash.h - Non-cryptographic hashing ----------------------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Non-cryptographic hashing.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef RXDOCK_SUPPORT_HASH_H
+#define RXDOCK_SUPPORT_HASH_H
+
+#include "rxdock/support/Export.h"
+
+#include <cstdint>
+#include <string>
+
+namespace rxdock {
+namespace support {
+
+/// Initial value of a 64-bit FNV-1a hash
+const std::uint64_t fnv1aOffsetBasis = 14695981039346656037ULL;
+
+/// Prime a 64-bit FNV-1a hash is multiplied by after each byte
+const std::uint64_t fnv1aPrime = 1099511628211ULL;
+
+///
+/// \brief Computes the 64-bit FNV-1a hash of a string.
+/// \param text the string to hash.
+/// \param hash the hash to continue from, so that several strings can be
+/// hashed in turn as if they were one.
+/// \return the hash
+///
+RBTDLL_EXPORT std::uint64_t hashFNV1a(const std::string &text,
+                                      std::uint64_t hash = fnv1aOffsetBasis);
+
+///
+/// \brief Computes the 64-bit FNV-1a hash of the 8 bytes of an integer, least
+/// significant first.
+/// \param value the integer to hash.
+/// \param hash the hash to continue from.
+/// \return the hash
+///
+inline std::uint64_t hashFNV1a(std::uint64_t value,
+                               std::uint64_t hash = fnv1aOffsetBasis) {
+  for (int iByte = 0; iByte < 8; iByte++) {
+    hash ^= (value >> (8 * iByte)) & 0xff;
+    hash *= fnv1aPrime;
+  }
+  return hash;
+}
+
+///
+/// \brief Formats a hash as 16 lowercase hexadecimal digits.
+/// \param hash a hash.
+/// \return the hexadecimal digits
+///
+RBTDLL_EXPORT std::string formatHash(std::uint64_t hash);
+
+} // namespace support
+} // namespace rxdock
+
+#endif // RXDOCK_SUPPORT_HASH_H
@@ -0,0 +1,95 @@
+//===-- HugePages.h - Huge page backed allocation ---------------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Huge page backed allocation for large, randomly accessed arrays.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef RXDOCK_SUPPORT_HUGEPAGES_H
+#define RXDOCK_SUPPORT_HUGEPAGES_H
+
+#include "rxdock/support/Export.h"
+
+#include <cstddef>
+#include <limits>
+#include <new>
+
+namespace rxdock {
+namespace support {
+
+/// How the memory of large arrays is backed by huge pages
+enum HugePageMode {
+  HUGE_PAGES_OFF,         // Regular heap allocation
+  HUGE_PAGES_TRANSPARENT, // 2 MB aligned memory advised as transparent huge
+                          // pages
+  HUGE_PAGES_EXPLICIT     // Reserved huge pages, falling back to transparent
+                          // huge pages once none are left
+};
+
+/// Sets the mode of the allocations made from now on (default: off)
+RBTDLL_EXPORT void setHugePageMode(HugePageMode mode);
+
+RBTDLL_EXPORT HugePageMode getHugePageMode();
+
+///
+/// \brief Allocates memory, backed by huge pages as set by setHugePageMode.
+///
+/// Only allocations of at least one huge page (2 MB) are backed by huge pages,
+/// and only on Linux; the others, and those for which the memory can not be
+/// mapped, come from the heap.
+/// \param nBytes the size of the memory.
+/// \return the memory, aligned for any fundamental type
+/// \throw std::bad_alloc if the memory can not be allocated
+///
+RBTDLL_EXPORT void *allocateHugePages(std::size_t nBytes);
+
+/// Frees memory allocated by allocateHugePages
+RBTDLL_EXPORT void deallocateHugePages(void *p);
+
+///
+/// \brief Standard allocator allocating with allocateHugePages.
+///
+/// Meant for the large arrays of grids, whose random access pattern makes
+/// TLB misses costly with regular pages.
+///
+template <typename T> class HugePageAllocator {
+public:
+  typedef T value_type;
+
+  HugePageAllocator() {}
+  template <typename U> HugePageAllocator(const HugePageAllocator<U> &) {}
+
+  T *allocate(std::size_t n) {
+    if (n > std::numeric_limits<std::size_t>::max() / sizeof(T)) {
+      throw std::bad_alloc();
+    }
+    return static_cast<T *>(allocateHugePages(n * sizeof(T)));
+  }
+
+  void deallocate(T *p, std::size_t) { deallocateHugePages(p); }
+};
+
+template <typename T, typename U>
+bool operator==(const HugePageAllocator<T> &, const HugePageAllocator<U> &) {
+  return true;
+}
+
+template <typename T, typename U>
+bool operator!=(const HugePageAllocator<T> &, const HugePageAllocator<U> &) {
+  return false;
+}
+
+} // namespace support
+} // namespace rxdock
+
+#endif // RXDOCK_SUPPORT_HUGEPAGES_H
@@ -0,0 +1,61 @@
+//===-- Numa.h - NUMA topology and thread placement -------------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// NUMA topology and thread placement.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef RXDOCK_SUPPORT_NUMA_H
+#define RXDOCK_SUPPORT_NUMA_H
+
+#include "rxdock/support/Export.h"
+
+#include <vector>
+
+namespace rxdock {
+namespace support {
+
+///
+/// \brief Finds the CPUs of each NUMA node that the process may run on.
+///
+/// Nodes without any such CPU are left out. On hosts without NUMA topology
+/// information (or other than Linux) all the CPUs are returned as one node,
+/// which is empty if the CPUs cannot be found either.
+/// \return the CPU numbers of each node, in node order
+///
+RBTDLL_EXPORT std::vector<std::vector<int>> getNumaNodeCpus();
+
+///
+/// \brief Restricts the calling thread, and the threads it creates afterwards,
+/// to the given CPUs.
+///
+/// Memory first written by the thread afterwards is then allocated on the
+/// NUMA node of the CPUs under the default first-touch policy.
+/// \param cpus the CPU numbers.
+/// \return false if the CPUs cannot be set on this host
+///
+RBTDLL_EXPORT bool bindThreadToCpus(const std::vector<int> &cpus);
+
+///
+/// \brief Finds the CPUs the calling thread may run on.
+///
+/// A thread bound with bindThreadToCpus can be given them back afterwards.
+/// \return the CPU numbers, which are empty if they cannot be found on this
+/// host
+///
+RBTDLL_EXPORT std::vector<int> getThreadCpus();
+
+} // namespace support
+} // namespace rxdock
+
+#endif // RXDOCK_SUPPORT_NUMA_H
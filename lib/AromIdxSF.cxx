@@ -179,6 +179,22 @@ void AromIdxSF::SetupReceptor() {
       m_spGuanGrid->SetInteractionLists(pIntnCenter, idxIncr);
     }
   }
+  m_spRecepOwner = new InteractionCenterOwner(m_recepAromList, m_recepGuanList);
+}
+
+// Shares the receptor interaction centers and indexing grids with a clone.
+// This also avoids adding the receptor ring pseudo atoms again
+void AromIdxSF::ShareReceptorData(BaseSF *pClone) const {
+  AromIdxSF *pAromClone = dynamic_cast<AromIdxSF *>(pClone);
+  if (pAromClone && !GetReceptor().Null()) {
+    pAromClone->ClearReceptor();
+    pAromClone->m_spRecepOwner = m_spRecepOwner;
+    pAromClone->m_spAromGrid = m_spAromGrid;
+    pAromClone->m_spGuanGrid = m_spGuanGrid;
+    pAromClone->m_recepAromList = m_recepAromList;
+    pAromClone->m_recepGuanList = m_recepGuanList;
+    ShareReceptor(pAromClone);
+  }
 }
 
 void AromIdxSF::SetupLigand() {
@@ -277,17 +293,10 @@ void AromIdxSF::ClearReceptor() {
   // Wipe the grids
   m_spAromGrid = InteractionGridPtr();
   m_spGuanGrid = InteractionGridPtr();
-  // Delete the receptor interaction centers
-  for (InteractionCenterListIter iter = m_recepAromList.begin();
-       iter != m_recepAromList.end(); iter++) {
-    delete *iter;
-  }
+  // The receptor interaction centers are owned by m_spRecepOwner
   m_recepAromList.clear();
-  for (InteractionCenterListIter iter = m_recepGuanList.begin();
-       iter != m_recepGuanList.end(); iter++) {
-    delete *iter;
-  }
   m_recepGuanList.clear();
+  m_spRecepOwner = InteractionCenterOwnerPtr();
 }
 void AromIdxSF::ClearLigand() {
   // Delete the ligand interaction centers
@@ -0,0 +1,348 @@
+//===-- AsyncFileWriter.cxx - Ordered background file writer ----*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+
+#include "rxdock/AsyncFileWriter.h"
+#include "rxdock/FileError.h"
+
+#include <algorithm>
+
+#ifdef RBT_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef _WIN32
+#include <io.h>
+#define fileno _fileno
+#define fsync _commit
+#define ftruncate _chsize_s
+#else
+#include <unistd.h> // For POSIX fsync and ftruncate
+#endif
+
+using namespace rxdock;
+
+AsyncFileWriter::AsyncFileWriter(const std::string &fileName,
+                                 std::size_t nWindowBytes,
+                                 std::size_t iFirstBlock, std::size_t nBytes)
+    : m_strFileName(fileName), m_nWindowBytes(nWindowBytes), m_bFiles(false),
+      m_bStream(false), m_bCompress(false), m_file(nullptr),
+      m_gzFile(nullptr), m_nPendingBytes(0), m_nSubmitted(0),
+      m_iNextBlock(iFirstBlock), m_nBytes(iFirstBlock > 0 ? nBytes : 0),
+      m_bContiguous(true), m_checkpointInterval(0.0), m_bClosing(false),
+      m_bAbort(false), m_bDiscard(false) {
+  // The file is opened here rather than in the writer thread so that the
+  // caller finds out straight away if it can not be written
+  Open(fileName, m_nBytes);
+  m_thread = std::thread(&AsyncFileWriter::WriterLoop, this);
+  _RBTOBJECTCOUNTER_CONSTR_("AsyncFileWriter");
+}
+
+AsyncFileWriter::AsyncFileWriter(std::FILE *stream, std::size_t nWindowBytes)
+    : m_strFileName("stream"), m_nWindowBytes(nWindowBytes), m_bFiles(false),
+      m_bStream(true), m_strOpenFileName("stream"), m_bCompress(false),
+      m_file(stream), m_gzFile(nullptr), m_nPendingBytes(0), m_nSubmitted(0),
+      m_iNextBlock(0), m_nBytes(0), m_bContiguous(true),
+      m_checkpointInterval(0.0), m_bClosing(false), m_bAbort(false),
+      m_bDiscard(false) {
+  m_thread = std::thread(&AsyncFileWriter::WriterLoop, this);
+  _RBTOBJECTCOUNTER_CONSTR_("AsyncFileWriter");
+}
+
+AsyncFileWriter::AsyncFileWriter(std::size_t nWindowBytes)
+    : m_nWindowBytes(nWindowBytes), m_bFiles(true), m_bStream(false),
+      m_bCompress(false), m_file(nullptr), m_gzFile(nullptr),
+      m_nPendingBytes(0), m_nSubmitted(0), m_iNextBlock(0), m_nBytes(0),
+      m_bContiguous(true), m_checkpointInterval(0.0), m_bClosing(false),
+      m_bAbort(false), m_bDiscard(false) {
+  m_thread = std::thread(&AsyncFileWriter::WriterLoop, this);
+  _RBTOBJECTCOUNTER_CONSTR_("AsyncFileWriter");
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+  try {
+    Close();
+  } catch (...) {
+  }
+  _RBTOBJECTCOUNTER_DESTR_("AsyncFileWriter");
+}
+
+std::size_t AsyncFileWriter::GetNumWrittenBlocks() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_iNextBlock;
+}
+
+void AsyncFileWriter::Submit(std::size_t iBlock, std::string text) {
+  if (m_bFiles) {
+    throw FileWriteError(_WHERE_, "Writer has no file to submit block to");
+  }
+  Block block;
+  block.text.swap(text);
+  Queue(iBlock, block);
+}
+
+void AsyncFileWriter::SubmitFile(const std::string &fileName,
+                                 std::string text) {
+  if (!m_bFiles) {
+    throw FileWriteError(_WHERE_, "Can not write " + fileName + " with the "
+                                      "writer of " + m_strFileName);
+  }
+  Block block;
+  block.strFileName = fileName;
+  block.text.swap(text);
+  std::size_t iBlock;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    iBlock = m_nSubmitted++;
+  }
+  Queue(iBlock, block);
+}
+
+void AsyncFileWriter::Queue(std::size_t iBlock, Block &block) {
+  std::size_t nBlockBytes = block.text.size();
+  std::unique_lock<std::mutex> lock(m_mutex);
+  // The next block to write is always accepted, otherwise the window could
+  // fill up with blocks that are all waiting for it
+  m_blockDone.wait(lock, [this, iBlock, nBlockBytes] {
+    return m_writeError || m_bAbort || m_bDiscard || iBlock == m_iNextBlock ||
+           m_nPendingBytes + nBlockBytes <= m_nWindowBytes;
+  });
+  if (m_writeError) {
+    std::rethrow_exception(m_writeError);
+  }
+  if (m_bDiscard) {
+    return;
+  }
+  if (m_bClosing) {
+    throw FileWriteError(_WHERE_, (block.strFileName.empty()
+                                       ? m_strFileName
+                                       : block.strFileName) +
+                                      " is already closed");
+  }
+  Block &pending = m_pendingBlocks[iBlock];
+  m_nPendingBytes += nBlockBytes - pending.text.size();
+  pending.strFileName.swap(block.strFileName);
+  pending.text.swap(block.text);
+  m_blockReady.notify_one();
+}
+
+void AsyncFileWriter::SetCheckpoint(CheckpointFunction checkpoint,
+                                    std::chrono::duration<double> interval) {
+  if (m_bFiles) {
+    throw FileWriteError(_WHERE_, "Can not checkpoint a writer without a "
+                                  "file");
+  }
+  // A truncated gzip stream can not be appended to
+  if (m_bCompress) {
+    throw FileWriteError(_WHERE_, "Can not checkpoint compressed file " +
+                                      m_strFileName);
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_checkpoint = checkpoint;
+  m_checkpointInterval = interval;
+}
+
+void AsyncFileWriter::Close() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bClosing = true;
+  }
+  m_blockReady.notify_one();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+  CloseFile();
+  if (m_writeError) {
+    std::rethrow_exception(m_writeError);
+  }
+}
+
+void AsyncFileWriter::Abort() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bAbort = true;
+  }
+  m_blockReady.notify_one();
+  m_blockDone.notify_all();
+}
+
+void AsyncFileWriter::Discard() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bDiscard = true;
+    m_pendingBlocks.clear();
+    m_nPendingBytes = 0;
+  }
+  m_blockDone.notify_all();
+}
+
+void AsyncFileWriter::Open(const std::string &fileName, std::size_t nBytes) {
+  const std::string gzSuffix(".gz");
+  m_strOpenFileName = fileName;
+  m_bCompress =
+      fileName.size() > gzSuffix.size() &&
+      fileName.compare(fileName.size() - gzSuffix.size(), gzSuffix.size(),
+                       gzSuffix) == 0;
+  if (m_bCompress && nBytes > 0) {
+    throw FileWriteError(_WHERE_, "Can not resume compressed file " +
+                                      fileName);
+  } else if (m_bCompress) {
+#ifdef RBT_HAVE_ZLIB
+    m_gzFile = gzopen(fileName.c_str(), "wb");
+#else
+    throw FileWriteError(_WHERE_, "Error opening " + fileName +
+                                      ": built without zlib support");
+#endif
+  } else if (nBytes > 0) {
+    // Drop anything written after the blocks that are kept
+    m_file = std::fopen(fileName.c_str(), "r+b");
+    if (m_file && (ftruncate(fileno(m_file), nBytes) != 0 ||
+                   std::fseek(m_file, 0, SEEK_END) != 0 ||
+                   static_cast<std::size_t>(std::ftell(m_file)) != nBytes)) {
+      std::fclose(m_file);
+      m_file = nullptr;
+      throw FileWriteError(_WHERE_, "Error truncating " + fileName);
+    }
+  } else {
+    m_file = std::fopen(fileName.c_str(), "wb");
+  }
+  if (!m_file && !m_gzFile) {
+    throw FileWriteError(_WHERE_, "Error opening " + fileName);
+  }
+}
+
+void AsyncFileWriter::WriteText(const std::string &text) {
+  bool bOK = true;
+  if (m_file) {
+    bOK = std::fwrite(text.data(), 1, text.size(), m_file) == text.size();
+    if (m_bStream) {
+      bOK = (std::fflush(m_file) == 0) && bOK;
+    }
+  }
+#ifdef RBT_HAVE_ZLIB
+  else if (m_gzFile) {
+    // gzwrite takes an unsigned int length
+    const std::size_t nChunk = 1 << 20;
+    for (std::size_t iPos = 0; bOK && iPos < text.size(); iPos += nChunk) {
+      unsigned int nLen =
+          static_cast<unsigned int>(std::min(nChunk, text.size() - iPos));
+      bOK = gzwrite(static_cast<gzFile>(m_gzFile), text.data() + iPos, nLen) ==
+            static_cast<int>(nLen);
+    }
+  }
+#endif
+  if (!bOK) {
+    throw FileWriteError(_WHERE_, "Error writing " + m_strOpenFileName);
+  }
+}
+
+void AsyncFileWriter::FlushFile() {
+  if (m_file &&
+      (std::fflush(m_file) != 0 || fsync(fileno(m_file)) != 0)) {
+    throw FileWriteError(_WHERE_, "Error flushing " + m_strOpenFileName);
+  }
+}
+
+void AsyncFileWriter::CloseFile() {
+  bool bOK = true;
+  if (m_file) {
+    bOK = (m_bStream ? std::fflush(m_file) : std::fclose(m_file)) == 0;
+    m_file = nullptr;
+  }
+#ifdef RBT_HAVE_ZLIB
+  if (m_gzFile) {
+    bOK = gzclose(static_cast<gzFile>(m_gzFile)) == Z_OK;
+    m_gzFile = nullptr;
+  }
+#endif
+  if (!bOK && !m_writeError) {
+    throw FileWriteError(_WHERE_, "Error closing " + m_strOpenFileName);
+  }
+}
+
+void AsyncFileWriter::WriterLoop() {
+  std::chrono::steady_clock::time_point lastCheckpoint =
+      std::chrono::steady_clock::now();
+  std::size_t nCheckpointBlocks = m_iNextBlock;
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (true) {
+    m_blockReady.wait(lock, [this] {
+      return m_pendingBlocks.count(m_iNextBlock) || m_bClosing ||
+             (m_bAbort && !m_pendingBlocks.empty());
+    });
+    bool bDone = m_pendingBlocks.empty(); // Closing and nothing left to write
+    if (!bDone) {
+      // When closing or aborting, the blocks are written in order even if
+      // some are missing
+      std::map<std::size_t, Block>::iterator iter =
+          m_pendingBlocks.find(m_iNextBlock);
+      if (iter == m_pendingBlocks.end()) {
+        iter = m_pendingBlocks.begin();
+        m_bContiguous = false;
+      }
+      Block block;
+      block.strFileName.swap(iter->second.strFileName);
+      block.text.swap(iter->second.text);
+      m_iNextBlock = iter->first + 1;
+      m_nPendingBytes -= block.text.size();
+      m_pendingBlocks.erase(iter);
+      m_blockDone.notify_all();
+      // Once writing has failed or been discarded the remaining blocks are
+      // dropped. A block with a file of its own is written even if empty,
+      // to create the file
+      if (!m_writeError && !m_bDiscard &&
+          (!block.text.empty() || !block.strFileName.empty())) {
+        lock.unlock();
+        try {
+          if (!block.strFileName.empty()) {
+            Open(block.strFileName, 0);
+            WriteText(block.text);
+            CloseFile();
+          } else {
+            WriteText(block.text);
+            m_nBytes += block.text.size();
+          }
+          lock.lock();
+        } catch (...) {
+          lock.lock();
+          m_writeError = std::current_exception();
+          m_blockDone.notify_all();
+        }
+      }
+    }
+
+    // The checkpoint function is called with the lock released, so that it
+    // can take its time
+    std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+    if (m_checkpoint && m_bContiguous && !m_writeError && !m_bDiscard &&
+        m_iNextBlock > nCheckpointBlocks &&
+        (bDone || now - lastCheckpoint >= m_checkpointInterval)) {
+      CheckpointFunction checkpoint = m_checkpoint;
+      std::size_t nBlocks = m_iNextBlock;
+      lock.unlock();
+      try {
+        FlushFile();
+        checkpoint(nBlocks, m_nBytes);
+        lock.lock();
+      } catch (...) {
+        lock.lock();
+        m_writeError = std::current_exception();
+        m_blockDone.notify_all();
+      }
+      nCheckpointBlocks = nBlocks;
+      lastCheckpoint = now;
+    }
+    if (bDone) {
+      break;
+    }
+  }
+}
@@ -42,6 +42,10 @@ void BaseFileSink::SetFileName(const std::string &fileName) {
 }
 
 Error BaseFileSink::Status() {
+  // The writer has already opened the file
+  if (!m_spWriter.Null()) {
+    return Error();
+  }
   // For file sinks, all we can is try and open the file for writing and see
   // what we catch
   try {
@@ -58,6 +62,25 @@ Error BaseFileSink::Status() {
   }
 }
 
+void BaseFileSink::SetWriter(AsyncFileWriterPtr spWriter) {
+  Write(); // Just in case there is anything in the cache
+  m_spWriter = spWriter;
+}
+
+void BaseFileSink::SubmitBlock(std::size_t iBlock,
+                               const std::string &strHeader) {
+  std::string text(strHeader);
+  text += m_strWriterText;
+  m_strWriterText.clear();
+  m_spWriter->Submit(iBlock, text);
+}
+
+void BaseFileSink::SubmitFile() {
+  std::string text;
+  text.swap(m_strWriterText);
+  m_spWriter->SubmitFile(m_strFileName, text);
+}
+
 ////////////////////////////////////////
 // Protected methods
 ///////////////////
@@ -68,6 +91,18 @@ void BaseFileSink::Write(bool bClearCache) {
   if (isCacheEmpty())
     return;
 
+  // The file I/O is left to the writer thread
+  if (!m_spWriter.Null()) {
+    for (std::vector<std::string>::const_iterator iter = m_lineRecs.begin();
+         iter != m_lineRecs.end(); iter++) {
+      m_strWriterText += *iter;
+      m_strWriterText += '\n';
+    }
+    if (bClearCache)
+      ClearCache();
+    return;
+  }
+
   try {
     Open(m_bAppend); // DM 06 Apr 1999 - open for append or overwrite, depending
                      // on m_bAppend attribute
@@ -12,6 +12,7 @@
 
 #include "rxdock/BaseFileSource.h"
 #include "rxdock/FileError.h"
+#include <algorithm>
 #include <cstring>
 #include <sys/stat.h>
 
@@ -28,7 +29,8 @@ using namespace rxdock;
 //}
 
 BaseFileSource::BaseFileSource(const std::string &fileName)
-    : m_numReads(0), m_bytesRead(0), m_bFileOpen(false), m_bMultiRec(false) {
+    : m_fileSize(0), m_numReads(0), m_bytesRead(0), m_nextRecordOffset(0),
+      m_bFileOpen(false), m_bMultiRec(false) {
   m_strFileName = fileName;
   struct stat fileStat;
   if (stat(fileName.c_str(), &fileStat) == 0) {
@@ -42,8 +44,8 @@ BaseFileSource::BaseFileSource(const std::string &fileName)
 // Multi-record constructor
 BaseFileSource::BaseFileSource(const std::string &fileName,
                                const std::string &strRecDelim)
-    : m_numReads(0), m_bytesRead(0), m_bFileOpen(false), m_bMultiRec(true),
-      m_strRecDelim(strRecDelim) {
+    : m_fileSize(0), m_numReads(0), m_bytesRead(0), m_nextRecordOffset(0),
+      m_bFileOpen(false), m_bMultiRec(true), m_strRecDelim(strRecDelim) {
   m_strFileName = fileName;
   struct stat fileStat;
   if (stat(fileName.c_str(), &fileStat) == 0) {
@@ -145,6 +147,60 @@ std::size_t BaseFileSource::GetEstimatedNumRecords() {
   return 1;
 }
 
+// Returns the byte offset of the record following the current record
+std::size_t BaseFileSource::GetNextRecordOffset() {
+  Read();
+  return m_nextRecordOffset;
+}
+
+// Positions the file so that the next record is read from the given offset
+void BaseFileSource::SeekRecord(std::size_t offset) {
+  if (m_bMultiRec) {
+    ClearCache();
+    Open();
+    m_fileIn.clear();
+    m_fileIn.seekg(offset);
+    if (!m_fileIn)
+      throw FileReadError(_WHERE_, "Error seeking in " + m_strFileName);
+  }
+}
+
+// Scans forward from the given offset for the end of a record
+std::size_t BaseFileSource::FindRecordBoundary(std::size_t offset) {
+  if (offset == 0 || offset >= m_fileSize)
+    return std::min(offset, m_fileSize);
+  // A separate stream is used so that the current record is not affected
+  std::ifstream fileIn(m_strFileName.c_str(), std::ios_base::in);
+  fileIn.seekg(offset - 1);
+  if (!fileIn)
+    throw FileReadError(_WHERE_, "Error seeking in " + m_strFileName);
+  // Skip the rest of any line started before offset
+  std::string line;
+  if (fileIn.get() != '\n')
+    std::getline(fileIn, line);
+  while (std::getline(fileIn, line)) {
+    if (line.compare(0, m_strRecDelim.size(), m_strRecDelim) == 0)
+      return fileIn.eof() ? m_fileSize
+                          : static_cast<std::size_t>(fileIn.tellg());
+  }
+  return m_fileSize;
+}
+
+// Returns the raw line records of the current record, reading it if needed
+FileRecList BaseFileSource::GetRecordLines() {
+  Read();
+  return m_lineRecs;
+}
+
+// Replaces the current record with the given line records
+// The file itself is not touched, so subsequent calls to Parse() work on the
+// supplied records until NextRecord() or Rewind() is called
+void BaseFileSource::SetRecordLines(const FileRecList &lineRecs) {
+  ClearCache();
+  m_lineRecs = lineRecs;
+  m_bReadOK = true;
+}
+
 // Protected functions
 
 void BaseFileSource::Read(bool aDelimiterAtEnd) {
@@ -169,6 +225,10 @@ void BaseFileSource::Read(bool aDelimiterAtEnd) {
             // to check for CRLF as they are considered unsupported
             m_lineRecs.push_back(m_szBuf);
           }
+          // The stream only fails at the end of the file
+          m_nextRecordOffset =
+              m_fileIn ? static_cast<std::size_t>(m_fileIn.tellg())
+                       : m_fileSize;
         }
         // Single-record read
         // Read entire file and close immediately
@@ -178,6 +238,7 @@ void BaseFileSource::Read(bool aDelimiterAtEnd) {
             m_lineRecs.push_back(m_szBuf);
           }
           Close();
+          m_nextRecordOffset = m_fileSize;
         }
         // DM 25 Mar 1999 - check for end of file (i.e. no lines read)
         if (m_lineRecs.empty())
@@ -210,6 +271,10 @@ void BaseFileSource::Read(bool aDelimiterAtEnd) {
             bytesLastRead += std::strlen(m_szBuf) + 1;
             m_lineRecs.push_back(m_szBuf);
           }
+          // The stream only fails at the end of the file
+          m_nextRecordOffset =
+              m_fileIn ? static_cast<std::size_t>(m_fileIn.tellg())
+                       : m_fileSize;
         }
         // Single-record read
         // Read entire file and close immediately
@@ -219,6 +284,7 @@ void BaseFileSource::Read(bool aDelimiterAtEnd) {
             m_lineRecs.push_back(m_szBuf);
           }
           Close();
+          m_nextRecordOffset = m_fileSize;
         }
         // DM 25 Mar 1999 - check for end of file (i.e. no lines read)
         if (m_lineRecs.empty())
@@ -40,6 +40,11 @@ ModelPtr BaseInterSF::GetReceptor() const { return m_spReceptor; }
 ModelPtr BaseInterSF::GetLigand() const { return m_spLigand; }
 ModelList BaseInterSF::GetSolvent() const { return m_solventList; }
 
+// Hands the current receptor to a clone
+void BaseInterSF::ShareReceptor(BaseInterSF *pClone) const {
+  pClone->m_spReceptor = m_spReceptor;
+}
+
 // Override Observer pure virtual
 // Notify observer that subject has changed
 void BaseInterSF::Update(Subject *theChangedSubject) {
@@ -11,10 +11,13 @@
  ***********************************************************************/
 
 #include "rxdock/BaseSF.h"
+#include "rxdock/SFFactory.h"
 #include "rxdock/SFRequest.h"
 
 #include <loguru.hpp>
 
+#include <algorithm>
+
 using namespace rxdock;
 
 // Static data members
@@ -72,6 +75,26 @@ double BaseSF::Score() const {
   return isEnabled() ? GetWeight() * RawScore() : 0.0;
 }
 
+// Creates an unregistered scoring function of the same class, with the same
+// name and parameter values
+BaseSF *BaseSF::Clone() const {
+  BaseSF *pClone = SFFactory().Create(GetClass(), GetName());
+  pClone->CopyParameters(*this);
+  ShareReceptorData(pClone);
+  return pClone;
+}
+
+bool BaseSF::isReceptorReadOnly() const { return true; }
+
+// Copies the parameter values of sf and of its children
+void BaseSF::CopyTreeParameters(const BaseSF &sf) {
+  CopyParameters(sf);
+  unsigned int nSF = std::min(sf.GetNumSF(), GetNumSF());
+  for (unsigned int iSF = 0; iSF < nSF; ++iSF) {
+    GetSF(iSF)->CopyTreeParameters(*sf.GetSF(iSF));
+  }
+}
+
 // Returns all child component scores as a string-variant map
 // Key = fully qualified component name, value = weighted score
 //(for saving in a Model's data fields)
@@ -106,6 +129,8 @@ void BaseSF::AddToParentMapEntry(StringVariantMap &scoreMap, double rs) const {
   }
 }
 
+void BaseSF::ShareReceptorData(BaseSF *pClone) const {}
+
 // Aggregate handling (virtual) methods
 // Base class throws an InvalidRequest error
 
@@ -12,6 +12,7 @@
 
 #include "rxdock/BaseTransform.h"
 #include "rxdock/BaseSF.h"
+#include "rxdock/TransformFactory.h"
 #include "rxdock/WorkSpace.h"
 
 #include <loguru.hpp>
@@ -56,6 +57,15 @@ void BaseTransform::Go() {
   }
 }
 
+// Creates an unregistered transform of the same class, with the same name,
+// parameter values and scoring function requests
+BaseTransform *BaseTransform::Clone() const {
+  BaseTransform *pClone = TransformFactory().Create(GetClass(), GetName());
+  pClone->CopyParameters(*this);
+  pClone->m_SFRequests = m_SFRequests;
+  return pClone;
+}
+
 // Aggregate handling (virtual) methods
 // Base class throws an InvalidRequest error
 
@@ -16,10 +16,12 @@ using namespace rxdock;
 
 const std::string Chrom::_CT = "Chrom";
 
-Chrom::Chrom() : ChromElement() { _RBTOBJECTCOUNTER_CONSTR_(_CT); }
+Chrom::Chrom() : ChromElement(), m_length(0), m_xOverLength(0) {
+  _RBTOBJECTCOUNTER_CONSTR_(_CT);
+}
 
 Chrom::Chrom(const ModelList &modelList)
-    : ChromElement(), m_modelList(modelList) {
+    : ChromElement(), m_length(0), m_xOverLength(0), m_modelList(modelList) {
   for (ModelListConstIter iter = m_modelList.begin(); iter != m_modelList.end();
        ++iter) {
     if ((*iter).Ptr()) {
@@ -79,7 +81,10 @@ void Chrom::SyncToModel() {
 }
 
 ChromElement *Chrom::clone() const {
-  ChromElement *clone = new Chrom();
+  Chrom *clone = new Chrom();
+  // The clone updates the pseudo atoms of the same models in SyncToModel, so
+  // that a genome scores the same as the chromosome it was cloned from
+  clone->m_modelList = m_modelList;
   for (ChromElementListConstIter iter = m_elementList.begin();
        iter != m_elementList.end(); ++iter) {
     clone->Add((*iter)->clone());
@@ -87,30 +92,60 @@ ChromElement *Chrom::clone() const {
   return clone;
 }
 
-void Chrom::Add(ChromElement *pChromElement) {
-  if (pChromElement) {
-    m_elementList.push_back(pChromElement);
+void Chrom::CopyValues(const ChromElement &c) {
+  const Chrom *pChrom = dynamic_cast<const Chrom *>(&c);
+  if (pChrom == nullptr ||
+      pChrom->m_elementList.size() != m_elementList.size()) {
+    throw BadArgument(_WHERE_, "Chromosome layouts do not match");
+  }
+  for (std::size_t i = 0; i < m_elementList.size(); ++i) {
+    m_elementList[i]->CopyValues(*(pChrom->m_elementList[i]));
   }
 }
 
-int Chrom::GetLength() const {
-  int retVal(0);
-  for (ChromElementListConstIter iter = m_elementList.begin();
-       iter != m_elementList.end(); ++iter) {
-    retVal += (*iter)->GetLength();
+void Chrom::CopyXOverGenes(const ChromElement &c, int iBegin, int iEnd) {
+  const Chrom *pChrom = dynamic_cast<const Chrom *>(&c);
+  if (pChrom == nullptr ||
+      pChrom->m_elementList.size() != m_elementList.size()) {
+    throw BadArgument(_WHERE_, "Chromosome layouts do not match");
+  }
+  // Only the elements overlapping [iBegin, iEnd) are visited, with the range
+  // shifted to the numbering of each element
+  int iOffset(0);
+  for (std::size_t i = 0; i < m_elementList.size() && iOffset < iEnd; ++i) {
+    ChromElement *pElement = m_elementList[i];
+    int length = pElement->GetXOverLength();
+    if (iOffset + length > iBegin) {
+      pElement->CopyXOverGenes(*(pChrom->m_elementList[i]), iBegin - iOffset,
+                               iEnd - iOffset);
+    }
+    iOffset += length;
   }
-  return retVal;
 }
 
-int Chrom::GetXOverLength() const {
-  int retVal(0);
-  for (ChromElementListConstIter iter = m_elementList.begin();
-       iter != m_elementList.end(); ++iter) {
-    retVal += (*iter)->GetXOverLength();
+void Chrom::Add(ChromElement *pChromElement) {
+  Chrom *pChrom = dynamic_cast<Chrom *>(pChromElement);
+  if (pChrom) {
+    // Take over the elements and models of the nested chromosome
+    for (ChromElementListIter iter = pChrom->m_elementList.begin();
+         iter != pChrom->m_elementList.end(); ++iter) {
+      Add(*iter);
+    }
+    pChrom->m_elementList.clear();
+    m_modelList.insert(m_modelList.end(), pChrom->m_modelList.begin(),
+                       pChrom->m_modelList.end());
+    delete pChrom;
+  } else if (pChromElement) {
+    m_elementList.push_back(pChromElement);
+    m_length += pChromElement->GetLength();
+    m_xOverLength += pChromElement->GetXOverLength();
   }
-  return retVal;
 }
 
+int Chrom::GetLength() const { return m_length; }
+
+int Chrom::GetXOverLength() const { return m_xOverLength; }
+
 void Chrom::GetVector(std::vector<double> &v) const {
   for (ChromElementListConstIter iter = m_elementList.begin();
        iter != m_elementList.end(); ++iter) {
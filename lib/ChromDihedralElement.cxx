@@ -88,6 +88,22 @@ ChromElement *ChromDihedralElement::clone() const {
   return new ChromDihedralElement(m_spRefData, m_value);
 }
 
+void ChromDihedralElement::CopyValues(const ChromElement &c) {
+  const ChromDihedralElement *pDihedral =
+      dynamic_cast<const ChromDihedralElement *>(&c);
+  if (pDihedral == nullptr) {
+    throw BadArgument(_WHERE_, "Chromosome element is not a dihedral element");
+  }
+  m_value = pDihedral->m_value;
+}
+
+void ChromDihedralElement::CopyXOverGenes(const ChromElement &c, int iBegin,
+                                          int iEnd) {
+  if (iBegin <= 0 && iEnd > 0) {
+    CopyValues(c);
+  }
+}
+
 void ChromDihedralElement::GetVector(std::vector<double> &v) const {
   v.push_back(m_value);
 }
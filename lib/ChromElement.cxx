@@ -97,7 +97,10 @@ double ChromElement::Compare(const ChromElement &c) const {
   if (GetLength() != c.GetLength()) {
     retVal = -1.0;
   } else {
-    std::vector<double> v;
+    // Reused across calls, as comparisons are made for every genome merged
+    // into a GA population
+    static thread_local std::vector<double> v;
+    v.clear();
     int i(0);
     c.GetVector(v);
     retVal = CompareVector(v, i);
@@ -142,10 +145,6 @@ void rxdock::Crossover(ChromElement *pChr1, ChromElement *pChr2,
       (length1 != pChr4->GetXOverLength())) {
     throw BadArgument(_WHERE_, "Crossover: mismatch in chromosome lengths");
   }
-  // Extract the gene vectors from each parent
-  XOverList v1, v2;
-  pChr1->GetVector(v1);
-  pChr2->GetVector(v2);
   // 2-point crossover
   // In the spirit of STL, ixbegin is the first gene to crossover, ixend is one
   // after the last gene to crossover
@@ -157,9 +156,21 @@ void rxdock::Crossover(ChromElement *pChr1, ChromElement *pChr2,
                   : rand.GetRandomInt(length1 - ixbegin) + ixbegin + 1;
 
   LOG_F(1, "Crossover: ixbegin = {}, ixend = {}", ixbegin, ixend);
-  std::swap_ranges(v1.begin() + ixbegin, v1.begin() + ixend,
-                   v2.begin() + ixbegin);
-  // Now we can update the two children
-  pChr3->SetVector(v1);
-  pChr4->SetVector(v2);
+  if (pChr3 != pChr1 && pChr3 != pChr2 && pChr4 != pChr1 && pChr4 != pChr2) {
+    // Copy each parent into a child, then the crossed over genes of the other
+    // parent, without building the gene vectors
+    pChr3->CopyValues(*pChr1);
+    pChr3->CopyXOverGenes(*pChr2, ixbegin, ixend);
+    pChr4->CopyValues(*pChr2);
+    pChr4->CopyXOverGenes(*pChr1, ixbegin, ixend);
+  } else {
+    // The children overwrite the parents, so go through the gene vectors
+    XOverList v1, v2;
+    pChr1->GetVector(v1);
+    pChr2->GetVector(v2);
+    std::swap_ranges(v1.begin() + ixbegin, v1.begin() + ixend,
+                     v2.begin() + ixbegin);
+    pChr3->SetVector(v1);
+    pChr4->SetVector(v2);
+  }
 }
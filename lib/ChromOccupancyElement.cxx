@@ -62,6 +62,23 @@ ChromElement *ChromOccupancyElement::clone() const {
   return new ChromOccupancyElement(m_spRefData, m_value);
 }
 
+void ChromOccupancyElement::CopyValues(const ChromElement &c) {
+  const ChromOccupancyElement *pOccupancy =
+      dynamic_cast<const ChromOccupancyElement *>(&c);
+  if (pOccupancy == nullptr) {
+    throw BadArgument(_WHERE_,
+                      "Chromosome element is not an occupancy element");
+  }
+  m_value = pOccupancy->m_value;
+}
+
+void ChromOccupancyElement::CopyXOverGenes(const ChromElement &c, int iBegin,
+                                           int iEnd) {
+  if (iBegin <= 0 && iEnd > 0) {
+    CopyValues(c);
+  }
+}
+
 void ChromOccupancyElement::GetVector(std::vector<double> &v) const {
   v.push_back(m_value);
 }
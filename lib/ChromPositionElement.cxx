@@ -172,6 +172,38 @@ ChromElement *ChromPositionElement::clone() const {
   return new ChromPositionElement(m_spRefData, m_com, m_orientation);
 }
 
+void ChromPositionElement::CopyValues(const ChromElement &c) {
+  const ChromPositionElement *pPosition =
+      dynamic_cast<const ChromPositionElement *>(&c);
+  if (pPosition == nullptr) {
+    throw BadArgument(_WHERE_, "Chromosome element is not a position element");
+  }
+  m_com = pPosition->m_com;
+  m_orientation = pPosition->m_orientation;
+}
+
+void ChromPositionElement::CopyXOverGenes(const ChromElement &c, int iBegin,
+                                          int iEnd) {
+  const ChromPositionElement *pPosition =
+      dynamic_cast<const ChromPositionElement *>(&c);
+  if (pPosition == nullptr) {
+    throw BadArgument(_WHERE_, "Chromosome element is not a position element");
+  }
+  // The COM and the orientation are one crossover gene each, if not fixed
+  int iGene(0);
+  if (!m_spRefData->IsTransFixed()) {
+    if (iBegin <= iGene && iGene < iEnd) {
+      m_com = pPosition->m_com;
+    }
+    ++iGene;
+  }
+  if (!m_spRefData->IsRotFixed()) {
+    if (iBegin <= iGene && iGene < iEnd) {
+      m_orientation = pPosition->m_orientation;
+    }
+  }
+}
+
 void ChromPositionElement::GetVector(std::vector<double> &v) const {
   if (!m_spRefData->IsTransFixed()) {
     v.insert(v.end(), m_com.xyz.data(), m_com.xyz.data() + m_com.xyz.size());
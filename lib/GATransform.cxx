@@ -11,14 +11,21 @@
  ***********************************************************************/
 
 #include "rxdock/GATransform.h"
+#include "rxdock/Chrom.h"
 #include "rxdock/Population.h"
 #include "rxdock/SFRequest.h"
 #include "rxdock/WorkSpace.h"
 
 #include <loguru.hpp>
 
+#include <algorithm>
+#include <exception>
 #include <iomanip>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 using namespace rxdock;
 
 const std::string GATransform::_CT = "GATransform";
@@ -31,6 +38,10 @@ const std::string GATransform::_EQUALITY_THRESHOLD = "equality-threshold";
 const std::string GATransform::_NCYCLES = "number-of-cycles";
 const std::string GATransform::_NCONVERGENCE = "number-for-convergence";
 const std::string GATransform::_HISTORY_FREQ = "history-frequency";
+const std::string GATransform::_STEADY_STATE_BATCH = "steady-state-batch-size";
+const std::string GATransform::_NISLANDS = "number-of-islands";
+const std::string GATransform::_MIGRATION_FREQ = "migration-frequency";
+const std::string GATransform::_NMIGRANTS = "number-of-migrants";
 
 GATransform::GATransform(const std::string &strName)
     : BaseBiMolTransform(_CT, strName), m_rand(GetRandInstance()) {
@@ -43,6 +54,10 @@ GATransform::GATransform(const std::string &strName)
   AddParameter(_NCYCLES, 100);
   AddParameter(_NCONVERGENCE, 6);
   AddParameter(_HISTORY_FREQ, 0);
+  AddParameter(_STEADY_STATE_BATCH, 0);
+  AddParameter(_NISLANDS, 1);
+  AddParameter(_MIGRATION_FREQ, 5);
+  AddParameter(_NMIGRANTS, 2);
   _RBTOBJECTCOUNTER_CONSTR_(_CT);
 }
 
@@ -83,28 +98,173 @@ void GATransform::Execute() {
   int nCycles = GetParameter(_NCYCLES);
   int nConvergence = GetParameter(_NCONVERGENCE);
   int nHisFreq = GetParameter(_HISTORY_FREQ);
+  int nBatch = GetParameter(_STEADY_STATE_BATCH);
+  int nIslands = GetParameter(_NISLANDS);
+  int nMigrationFreq = GetParameter(_MIGRATION_FREQ);
+  int nMigrants = GetParameter(_NMIGRANTS);
 
-  double popsize = static_cast<double>(pop->GetMaxSize());
+  // Each island needs two individuals to breed from
+  nIslands = std::max(1, std::min(nIslands, pop->GetActualSize() / 2));
+  std::vector<PopulationPtr> islands;
+  std::vector<RandPtr> islandRands;
+  // The scoring function and models each thread scores the islands with:
+  // those of the workspace for the calling thread, then the replicas
+  ScoringReplicaList scoringSlots;
+  if (nIslands > 1) {
+    ScoringReplica slot;
+    slot.pSF = pSF;
+    scoringSlots.push_back(slot);
+    std::vector<WorkSpace *> replicaWorkSpaces =
+        pWorkSpace->GetScoringReplicas();
+    for (std::vector<WorkSpace *>::const_iterator iter =
+             replicaWorkSpaces.begin();
+         iter != replicaWorkSpaces.end(); ++iter) {
+      BaseSF *pReplicaSF = (*iter)->GetSF();
+      if (pReplicaSF != nullptr) {
+        pReplicaSF->CopyTreeParameters(*pSF);
+        pReplicaSF->HandleRequest(new SFPartitionRequest(0.0));
+        slot.pSF = pReplicaSF;
+        slot.spChrom = new Chrom((*iter)->GetModels());
+        scoringSlots.push_back(slot);
+      }
+    }
+    // The islands are dealt the individuals in turn, so that each gets a
+    // share of the best ones. The random number streams of the islands are
+    // substreams of that of the run, so they are unique to the ligand, run
+    // and GA stage, and the islands evolve the same whichever thread steps
+    // them
+    int islandSize = std::max(2, static_cast<int>(pop->GetMaxSize()) /
+                                     nIslands);
+    std::uint64_t nIslandKey = GetRandInstance().GetSubstreamKey();
+    const GenomeList &genomes = pop->GetGenomeList();
+    for (int iIsland = 0; iIsland < nIslands; ++iIsland) {
+      GenomeList islandGenomes;
+      for (std::size_t i = iIsland; i < genomes.size(); i += nIslands) {
+        islandGenomes.push_back(genomes[i]);
+      }
+      RandPtr spRand = new Rand();
+      spRand->SeedSubstream(nIslandKey, iIsland);
+      // The genomes of an island draw from the generator that is installed
+      // when they are created
+      Rand *pPrevRand = SetRandInstance(spRand.Ptr());
+      islands.push_back(new Population(islandGenomes, islandSize, pSF));
+      SetRandInstance(pPrevRand);
+      islandRands.push_back(spRand);
+    }
+  } else {
+    islands.push_back(pop);
+  }
+
+  double popsize = static_cast<double>(islands.front()->GetMaxSize());
   int nrepl = static_cast<int>(newFraction * popsize);
   bool bHistory = nHisFreq > 0;
 
-  double bestScore = pop->Best()->GetScore();
+  // One GA cycle of a population (an island, or the whole population)
+  auto step = [&](Population &p) {
+    if (nBatch > 0) {
+      // A cycle creates as many individuals as a generational one, so that
+      // the number of cycles and the convergence test keep their meaning
+      for (int nNew = 0; nNew < nrepl; nNew += nBatch) {
+        p.SteadyStateStep(std::min(nBatch, nrepl - nNew), relStepSize,
+                          equalityThreshold, pcross, xovermut, cmutate);
+      }
+    } else {
+      p.GAstep(nrepl, relStepSize, equalityThreshold, pcross, xovermut,
+               cmutate);
+    }
+  };
+  // The best individual of all the islands, and the mean and variance of the
+  // scores of all their individuals
+  GenomePtr best;
+  double scoreMean = 0.0;
+  double scoreVariance = 0.0;
+  auto updateStatistics = [&]() {
+    best = islands.front()->Best();
+    double nTotal = 0.0;
+    double sum = 0.0;
+    double sumSq = 0.0;
+    for (std::vector<PopulationPtr>::const_iterator iter = islands.begin();
+         iter != islands.end(); ++iter) {
+      if ((*iter)->Best()->GetScore() > best->GetScore()) {
+        best = (*iter)->Best();
+      }
+      double n = static_cast<double>((*iter)->GetActualSize());
+      double mean = (*iter)->GetScoreMean();
+      nTotal += n;
+      sum += n * mean;
+      sumSq += n * ((*iter)->GetScoreVariance() + mean * mean);
+    }
+    scoreMean = sum / nTotal;
+    scoreVariance = sumSq / nTotal - scoreMean * scoreMean;
+  };
+  updateStatistics();
+
+  double bestScore = best->GetScore();
   // Number of consecutive cycles with no improvement in best score
   int iConvergence = 0;
 
   LOG_F(INFO, "CYCLE CONV      BEST      MEAN       VAR");
-  LOG_F(INFO, " Init    -{:10.3f}{:10.3f}{:10.3f}", bestScore,
-        pop->GetScoreMean(), pop->GetScoreVariance());
+  LOG_F(INFO, " Init    -{:10.3f}{:10.3f}{:10.3f}", bestScore, scoreMean,
+        scoreVariance);
 
   for (int iCycle = 0; (iCycle < nCycles) && (iConvergence < nConvergence);
        ++iCycle) {
     if (bHistory && ((iCycle % nHisFreq) == 0)) {
-      pop->Best()->GetChrom()->SyncToModel();
+      best->GetChrom()->SyncToModel();
       pWorkSpace->SaveHistory(true);
     }
-    pop->GAstep(nrepl, relStepSize, equalityThreshold, pcross, xovermut,
-                cmutate);
-    double score = pop->Best()->GetScore();
+    if (nIslands == 1) {
+      step(*pop);
+    } else {
+      // Each thread steps its islands on its own scoring slot, whose models
+      // start from the coordinates of the workspace models
+      int nThreads = std::min<int>(nIslands, scoringSlots.size());
+      std::vector<CoordList> coords = pWorkSpace->GetMobileCoords();
+      for (int iThread = 1; iThread < nThreads; ++iThread) {
+        scoringSlots[iThread].pSF->GetWorkSpace()->SetMobileCoords(coords);
+      }
+      std::exception_ptr stepException;
+#pragma omp parallel for num_threads(nThreads) schedule(static, 1)
+      for (int iIsland = 0; iIsland < nIslands; ++iIsland) {
+        int iThread = 0;
+#ifdef _OPENMP
+        iThread = omp_get_thread_num();
+#endif
+        Rand *pPrevRand = SetRandInstance(islandRands[iIsland].Ptr());
+        try {
+          islands[iIsland]->SetScoringReplica(scoringSlots[iThread]);
+          step(*islands[iIsland]);
+        } catch (...) {
+#pragma omp critical(islandStep)
+          if (!stepException) {
+            stepException = std::current_exception();
+          }
+        }
+        SetRandInstance(pPrevRand);
+      }
+      if (stepException) {
+        std::rethrow_exception(stepException);
+      }
+      if (nMigrationFreq > 0 && ((iCycle + 1) % nMigrationFreq) == 0) {
+        // The migrants are all chosen before any island receives any
+        std::vector<GenomeList> migrants(nIslands);
+        for (int iIsland = 0; iIsland < nIslands; ++iIsland) {
+          const GenomeList &genomes = islands[iIsland]->GetGenomeList();
+          migrants[iIsland].assign(
+              genomes.begin(),
+              genomes.begin() + std::min<std::size_t>(std::max(nMigrants, 0),
+                                                      genomes.size()));
+        }
+        for (int iIsland = 0; iIsland < nIslands; ++iIsland) {
+          int iDest = (iIsland + 1) % nIslands;
+          Rand *pPrevRand = SetRandInstance(islandRands[iDest].Ptr());
+          islands[iDest]->Insert(migrants[iIsland], equalityThreshold);
+          SetRandInstance(pPrevRand);
+        }
+      }
+    }
+    updateStatistics();
+    double score = best->GetScore();
     if (score > bestScore) {
       bestScore = score;
       iConvergence = 0;
@@ -112,7 +272,19 @@ void GATransform::Execute() {
       iConvergence++;
     }
     LOG_F(INFO, "{:5d}{:5d}{:10.3f}{:10.3f}{:10.3f}", iCycle, iConvergence,
-          score, pop->GetScoreMean(), pop->GetScoreVariance());
+          score, scoreMean, scoreVariance);
+  }
+  if (nIslands > 1) {
+    // The copies kept by the population draw from the generator of the run
+    // again, as the generators of the islands do not outlive this stage
+    GenomeList genomes;
+    for (std::vector<PopulationPtr>::const_iterator iter = islands.begin();
+         iter != islands.end(); ++iter) {
+      const GenomeList &islandGenomes = (*iter)->GetGenomeList();
+      genomes.insert(genomes.end(), islandGenomes.begin(),
+                     islandGenomes.end());
+    }
+    pop->Insert(genomes, equalityThreshold);
   }
   pop->Best()->GetChrom()->SyncToModel();
   int ri = GetReceptor()->GetCurrentCoords();
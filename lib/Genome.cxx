@@ -31,7 +31,9 @@ Genome::Genome(const Genome &g)
 
 Genome &Genome::operator=(const Genome &g) {
   if (&g != this) {
-    m_chrom = (g.m_chrom)->clone();
+    ChromElement *pChrom = (g.m_chrom)->clone();
+    delete m_chrom;
+    m_chrom = pChrom;
     m_score = g.m_score;
     m_RWFitness = g.m_RWFitness;
   }
@@ -45,6 +47,14 @@ Genome::~Genome() {
 
 Genome *Genome::clone() const { return new Genome(*this); }
 
+void Genome::CopyFrom(const Genome &g) {
+  if (&g != this) {
+    m_chrom->CopyValues(*(g.m_chrom));
+    m_score = g.m_score;
+    m_RWFitness = g.m_RWFitness;
+  }
+}
+
 void Genome::SetScore(BaseSF *pSF) {
   if (pSF != nullptr) {
     m_chrom->SyncToModel();
@@ -55,6 +65,20 @@ void Genome::SetScore(BaseSF *pSF) {
   SetRWFitness(0.0, 0.0);
 }
 
+void Genome::SetScore(BaseSF *pSF, ChromElement *pChrom) {
+  if (pSF != nullptr) {
+    static thread_local std::vector<double> chromVec;
+    chromVec.clear();
+    m_chrom->GetVector(chromVec);
+    pChrom->SetVector(chromVec);
+    pChrom->SyncToModel();
+    m_score = -pSF->Score();
+  } else {
+    m_score = 0.0;
+  }
+  SetRWFitness(0.0, 0.0);
+}
+
 double Genome::SetRWFitness(double sigmaOffset, double partialSum) {
   // Apply sigma truncation to the raw score
   m_RWFitness = std::max(0.0, GetScore() - sigmaOffset);
@@ -60,6 +60,21 @@ void rxdock::SelectInteractionCenter::operator()(InteractionCenter *pIC) {
   std::for_each(atomList.begin(), atomList.end(), SelectAtom(b));
 }
 
+InteractionCenterOwner::InteractionCenterOwner(
+    const InteractionCenterList &icList1,
+    const InteractionCenterList &icList2) {
+  m_centers.reserve(icList1.size() + icList2.size());
+  m_centers.insert(m_centers.end(), icList1.begin(), icList1.end());
+  m_centers.insert(m_centers.end(), icList2.begin(), icList2.end());
+}
+
+InteractionCenterOwner::~InteractionCenterOwner() {
+  for (InteractionCenterListIter iter = m_centers.begin();
+       iter != m_centers.end(); ++iter) {
+    delete *iter;
+  }
+}
+
 // Static data members
 const std::string InteractionGrid::_CT = "InteractionGrid";
 
@@ -10,14 +10,18 @@
  * http://rdock.sourceforge.net/
  ***********************************************************************/
 
+#include <algorithm>
+#include <array>
 #include <functional>
 #include <iomanip>
+#include <set>
 
 #include "rxdock/AtomFuncs.h"
 #include "rxdock/FileError.h"
 #include "rxdock/MdlFileSource.h"
 #include "rxdock/ModelError.h"
 #include "rxdock/Plane.h"
+#include "rxdock/support/Hash.h"
 
 #include <fmt/ostream.h>
 #include <loguru.hpp>
@@ -39,6 +43,408 @@ MdlFileSource::MdlFileSource(const std::string &fileName, bool bPosIonisable,
 // Default destructor
 MdlFileSource::~MdlFileSource() { _RBTOBJECTCOUNTER_DESTR_("MdlFileSource"); }
 
+namespace {
+
+// The molecular graph of the heavy atoms of a record, labelled canonically by
+// individualisation and refinement: the atoms are ranked by their invariants
+// and the ranks are refined with those of the neighbours. While atoms share a
+// rank, each of them in turn gets a rank of its own, and the ranks are refined
+// again. Of the labellings found, the canonical one gives the smallest
+// certificate, which describes the graph completely. Branches that are images
+// of explored ones under the automorphisms found so far are not explored
+class StructureGraph {
+public:
+  StructureGraph(const std::vector<const Atom *> &atoms,
+                 const std::vector<std::array<int, 5>> &invariants,
+                 const std::vector<std::vector<std::pair<std::size_t, int>>>
+                     &neighbours,
+                 const std::vector<char> &tetrahedral, bool bStereo)
+      : m_atoms(atoms), m_invariants(invariants), m_neighbours(neighbours),
+        m_tetrahedral(tetrahedral), m_bStereo(bStereo) {}
+
+  // Returns the certificate of the canonical labelling
+  std::vector<long long> GetCanonicalCertificate() {
+    std::size_t nAtoms = m_atoms.size();
+    std::vector<std::size_t> order(nAtoms);
+    for (std::size_t i = 0; i < nAtoms; i++) {
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) {
+      return m_invariants[a] < m_invariants[b];
+    });
+    std::vector<std::size_t> ranks(nAtoms);
+    for (std::size_t k = 0; k < nAtoms; k++) {
+      ranks[order[k]] =
+          (k > 0 && m_invariants[order[k]] == m_invariants[order[k - 1]])
+              ? ranks[order[k - 1]]
+              : k;
+    }
+    m_best.clear();
+    m_bestLabels.clear();
+    m_automorphisms.clear();
+    m_nLeaves = 0;
+    std::vector<std::size_t> path;
+    Search(ranks, path);
+    return m_best;
+  }
+
+private:
+  // Leaves explored before the first labelling found is kept. Graphs with
+  // that many labellings to explore, which molecules do not have, may then
+  // get different certificates for different atom orders, but never the same
+  // certificate for different graphs
+  static const std::size_t m_nMaxLeaves = 1000;
+
+  // Refines the ranks (the number of atoms of lower rank) until the atoms of
+  // each rank have the same number of neighbours of each rank by bonds of
+  // each order
+  void Refine(std::vector<std::size_t> &ranks) const {
+    std::size_t nAtoms = ranks.size();
+    std::vector<std::vector<std::pair<std::size_t, int>>> keys(nAtoms);
+    std::vector<std::size_t> order(nAtoms);
+    std::size_t nCells =
+        std::set<std::size_t>(ranks.begin(), ranks.end()).size();
+    while (nCells < nAtoms) {
+      for (std::size_t i = 0; i < nAtoms; i++) {
+        keys[i].clear();
+        for (const std::pair<std::size_t, int> &neighbour : m_neighbours[i]) {
+          keys[i].push_back(
+              std::make_pair(ranks[neighbour.first], neighbour.second));
+        }
+        std::sort(keys[i].begin(), keys[i].end());
+        order[i] = i;
+      }
+      std::sort(order.begin(), order.end(),
+                [&ranks, &keys](std::size_t a, std::size_t b) {
+                  return ranks[a] < ranks[b] ||
+                         (ranks[a] == ranks[b] && keys[a] < keys[b]);
+                });
+      std::vector<std::size_t> newRanks(nAtoms);
+      std::size_t nNewCells = 0;
+      for (std::size_t k = 0; k < nAtoms; k++) {
+        std::size_t a = order[k];
+        std::size_t b = (k > 0) ? order[k - 1] : a;
+        if (k > 0 && ranks[a] == ranks[b] && keys[a] == keys[b]) {
+          newRanks[a] = newRanks[b];
+        } else {
+          newRanks[a] = k;
+          nNewCells++;
+        }
+      }
+      ranks.swap(newRanks);
+      if (nNewCells == nCells) {
+        break;
+      }
+      nCells = nNewCells;
+    }
+  }
+
+  // Returns the certificate of a labelling: the invariants, the neighbours
+  // and, with stereochemistry, the handedness of the tetrahedral centres and
+  // whether the double bonds are cis or trans, of the atoms in label order
+  std::vector<long long>
+  GetCertificate(const std::vector<std::size_t> &labels) const {
+    std::size_t nAtoms = labels.size();
+    std::vector<std::size_t> atomOfLabel(nAtoms);
+    for (std::size_t i = 0; i < nAtoms; i++) {
+      atomOfLabel[labels[i]] = i;
+    }
+    // Returns the neighbours of atom i other than atom j, by label
+    auto getLabelledNeighbours = [&](std::size_t i, std::size_t j) {
+      std::vector<std::pair<std::size_t, std::size_t>> labelled;
+      for (const std::pair<std::size_t, int> &neighbour : m_neighbours[i]) {
+        if (neighbour.first != j) {
+          labelled.push_back(
+              std::make_pair(labels[neighbour.first], neighbour.first));
+        }
+      }
+      std::sort(labelled.begin(), labelled.end());
+      return labelled;
+    };
+    std::vector<long long> certificate;
+    for (std::size_t l = 0; l < nAtoms; l++) {
+      std::size_t i = atomOfLabel[l];
+      certificate.insert(certificate.end(), m_invariants[i].begin(),
+                         m_invariants[i].end());
+      int nHandedness = 0;
+      if (m_bStereo && m_tetrahedral[i]) {
+        // The handedness of the three lowest labelled neighbours, the fourth
+        // being a heavy atom or a hydrogen
+        std::vector<std::pair<std::size_t, std::size_t>> labelled =
+            getLabelledNeighbours(i, nAtoms);
+        const Coord &c = m_atoms[i]->GetCoords();
+        Vector v0 = (m_atoms[labelled[0].second]->GetCoords() - c).Unit();
+        Vector v1 = (m_atoms[labelled[1].second]->GetCoords() - c).Unit();
+        Vector v2 = (m_atoms[labelled[2].second]->GetCoords() - c).Unit();
+        double dHandedness = v0.Dot(v1.Cross(v2));
+        if (std::fabs(dHandedness) > 0.1) {
+          nHandedness = (dHandedness > 0.0) ? 1 : -1;
+        }
+      }
+      certificate.push_back(nHandedness);
+      std::vector<std::pair<std::size_t, std::size_t>> labelled =
+          getLabelledNeighbours(i, nAtoms);
+      for (const std::pair<std::size_t, std::size_t> &neighbour : labelled) {
+        std::size_t j = neighbour.second;
+        int nBondOrder = 0;
+        for (const std::pair<std::size_t, int> &bond : m_neighbours[i]) {
+          if (bond.first == j) {
+            nBondOrder = bond.second;
+          }
+        }
+        // Double bonds: whether the lowest labelled neighbours of the two
+        // ends are cis or trans
+        int nCis = 0;
+        if (m_bStereo && nBondOrder == 2) {
+          std::vector<std::pair<std::size_t, std::size_t>> labelledI =
+              getLabelledNeighbours(i, j);
+          std::vector<std::pair<std::size_t, std::size_t>> labelledJ =
+              getLabelledNeighbours(j, i);
+          if (!labelledI.empty() && !labelledJ.empty()) {
+            Vector u = m_atoms[labelledI.front().second]->GetCoords() -
+                       m_atoms[i]->GetCoords();
+            Vector w = m_atoms[labelledJ.front().second]->GetCoords() -
+                       m_atoms[j]->GetCoords();
+            nCis = (u.Dot(w) > 0.0) ? 1 : -1;
+          }
+        }
+        certificate.push_back(static_cast<long long>(neighbour.first));
+        certificate.push_back(nBondOrder);
+        certificate.push_back(nCis);
+      }
+      certificate.push_back(-1);
+    }
+    return certificate;
+  }
+
+  // Returns whether atom v is the image of one of the explored atoms under
+  // the automorphisms found that fix the atoms of path
+  bool IsExploredImage(std::size_t v, const std::vector<std::size_t> &explored,
+                       const std::vector<std::size_t> &path) const {
+    std::vector<std::size_t> orbit(m_atoms.size());
+    for (std::size_t i = 0; i < orbit.size(); i++) {
+      orbit[i] = i;
+    }
+    std::function<std::size_t(std::size_t)> find = [&](std::size_t i) {
+      return orbit[i] == i ? i : (orbit[i] = find(orbit[i]));
+    };
+    for (const std::vector<std::size_t> &automorphism : m_automorphisms) {
+      bool bFixesPath = true;
+      for (std::size_t p : path) {
+        bFixesPath = bFixesPath && automorphism[p] == p;
+      }
+      if (bFixesPath) {
+        for (std::size_t i = 0; i < orbit.size(); i++) {
+          orbit[find(i)] = find(automorphism[i]);
+        }
+      }
+    }
+    for (std::size_t e : explored) {
+      if (find(e) == find(v)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void Search(std::vector<std::size_t> &ranks,
+              std::vector<std::size_t> &path) {
+    Refine(ranks);
+    std::size_t nAtoms = ranks.size();
+    std::vector<std::size_t> cellSizes(nAtoms, 0);
+    for (std::size_t i = 0; i < nAtoms; i++) {
+      cellSizes[ranks[i]]++;
+    }
+    std::size_t iCell = 0;
+    while (iCell < nAtoms && cellSizes[iCell] < 2) {
+      iCell++;
+    }
+    if (iCell == nAtoms) {
+      // A leaf: the ranks are the labels
+      m_nLeaves++;
+      std::vector<long long> certificate = GetCertificate(ranks);
+      if (m_bestLabels.empty() || certificate < m_best) {
+        m_best.swap(certificate);
+        m_bestLabels = ranks;
+      } else if (certificate == m_best) {
+        // The two labellings differ by an automorphism
+        std::vector<std::size_t> atomOfLabel(nAtoms);
+        for (std::size_t i = 0; i < nAtoms; i++) {
+          atomOfLabel[m_bestLabels[i]] = i;
+        }
+        std::vector<std::size_t> automorphism(nAtoms);
+        for (std::size_t i = 0; i < nAtoms; i++) {
+          automorphism[i] = atomOfLabel[ranks[i]];
+        }
+        m_automorphisms.push_back(automorphism);
+      }
+      return;
+    }
+    std::vector<std::size_t> explored;
+    for (std::size_t v = 0; v < nAtoms && m_nLeaves < m_nMaxLeaves; v++) {
+      if (ranks[v] != iCell || IsExploredImage(v, explored, path)) {
+        continue;
+      }
+      explored.push_back(v);
+      std::vector<std::size_t> childRanks = ranks;
+      for (std::size_t u = 0; u < nAtoms; u++) {
+        if (u != v && ranks[u] == iCell) {
+          childRanks[u] = iCell + 1;
+        }
+      }
+      path.push_back(v);
+      Search(childRanks, path);
+      path.pop_back();
+    }
+  }
+
+  const std::vector<const Atom *> &m_atoms;
+  const std::vector<std::array<int, 5>> &m_invariants;
+  const std::vector<std::vector<std::pair<std::size_t, int>>> &m_neighbours;
+  const std::vector<char> &m_tetrahedral;
+  bool m_bStereo;
+  std::vector<long long> m_best;
+  std::vector<std::size_t> m_bestLabels;
+  std::vector<std::vector<std::size_t>> m_automorphisms;
+  std::size_t m_nLeaves = 0;
+};
+
+} // namespace
+
+std::uint64_t MdlFileSource::GetStructureHash(eStructureMatch eMatch) {
+  AtomList atomList = GetAtomList();
+  BondList bondList = GetBondList();
+  // The heavy atoms are the vertices of the molecular graph, the hydrogens
+  // only add to the hydrogen counts of the atoms they are bonded to
+  std::map<const Atom *, std::size_t> heavyAtomIndex;
+  std::vector<const Atom *> heavyAtoms;
+  for (AtomListConstIter iter = atomList.begin(); iter != atomList.end();
+       iter++) {
+    if ((*iter)->GetAtomicNo() != 1) {
+      heavyAtomIndex[(*iter).Ptr()] = heavyAtoms.size();
+      heavyAtoms.push_back((*iter).Ptr());
+    }
+  }
+  std::size_t nAtoms = heavyAtoms.size();
+  std::vector<int> nHydrogens(nAtoms);
+  for (std::size_t i = 0; i < nAtoms; i++) {
+    nHydrogens[i] = heavyAtoms[i]->GetNumImplicitHydrogens();
+  }
+  // Neighbours of each heavy atom, with the bond orders
+  std::vector<std::vector<std::pair<std::size_t, int>>> neighbours(nAtoms);
+  for (BondListConstIter iter = bondList.begin(); iter != bondList.end();
+       iter++) {
+    std::map<const Atom *, std::size_t>::const_iterator iter1 =
+        heavyAtomIndex.find((*iter)->GetAtom1Ptr().Ptr());
+    std::map<const Atom *, std::size_t>::const_iterator iter2 =
+        heavyAtomIndex.find((*iter)->GetAtom2Ptr().Ptr());
+    if (iter1 != heavyAtomIndex.end() && iter2 != heavyAtomIndex.end()) {
+      int nBondOrder = (*iter)->GetFormalBondOrder();
+      neighbours[iter1->second].push_back(
+          std::make_pair(iter2->second, nBondOrder));
+      neighbours[iter2->second].push_back(
+          std::make_pair(iter1->second, nBondOrder));
+    } else if (iter1 != heavyAtomIndex.end()) {
+      nHydrogens[iter1->second]++;
+    } else if (iter2 != heavyAtomIndex.end()) {
+      nHydrogens[iter2->second]++;
+    }
+  }
+
+  // Invariants of each atom: element, charge, hydrogens, heavy neighbours,
+  // and for tautomers the mobile hydrogens and double bonds of its conjugated
+  // system
+  std::vector<std::array<int, 5>> invariants(nAtoms);
+  for (std::size_t i = 0; i < nAtoms; i++) {
+    invariants[i] = {{heavyAtoms[i]->GetAtomicNo(),
+                      heavyAtoms[i]->GetFormalCharge(), nHydrogens[i],
+                      static_cast<int>(neighbours[i].size()), -1}};
+  }
+  if (eMatch == TAUTOMER_MATCH) {
+    // A conjugated system joins the atoms with double bonds and the N, O and
+    // S atoms next to them. In a system with such heteroatoms, the hydrogens
+    // of the heteroatoms can move within the system and the double bonds
+    // shift with them, so only their numbers are compared
+    auto isDouble = [](int nBondOrder) {
+      return nBondOrder == 2 || nBondOrder > 3;
+    };
+    std::vector<char> unsaturated(nAtoms, 0);
+    std::vector<char> hetero(nAtoms, 0);
+    for (std::size_t i = 0; i < nAtoms; i++) {
+      int nAtomicNo = heavyAtoms[i]->GetAtomicNo();
+      hetero[i] = (nAtomicNo == 7 || nAtomicNo == 8 || nAtomicNo == 16);
+      for (const std::pair<std::size_t, int> &neighbour : neighbours[i]) {
+        unsaturated[i] = unsaturated[i] || isDouble(neighbour.second);
+      }
+    }
+    std::vector<std::size_t> system(nAtoms);
+    for (std::size_t i = 0; i < nAtoms; i++) {
+      system[i] = i;
+    }
+    std::function<std::size_t(std::size_t)> find = [&](std::size_t i) {
+      return system[i] == i ? i : (system[i] = find(system[i]));
+    };
+    auto isConjugated = [&](std::size_t i, std::size_t j) {
+      return (unsaturated[i] || unsaturated[j]) &&
+             (unsaturated[i] || hetero[i]) && (unsaturated[j] || hetero[j]);
+    };
+    for (std::size_t i = 0; i < nAtoms; i++) {
+      for (const std::pair<std::size_t, int> &neighbour : neighbours[i]) {
+        if (isConjugated(i, neighbour.first)) {
+          system[find(i)] = find(neighbour.first);
+        }
+      }
+    }
+    std::vector<char> inSystem(nAtoms, 0);
+    std::vector<char> mobile(nAtoms, 0);
+    std::vector<int> nMobileHydrogens(nAtoms, 0);
+    std::vector<int> nDoubleBonds(nAtoms, 0);
+    for (std::size_t i = 0; i < nAtoms; i++) {
+      for (const std::pair<std::size_t, int> &neighbour : neighbours[i]) {
+        if (isConjugated(i, neighbour.first)) {
+          inSystem[i] = 1;
+        }
+        if (isDouble(neighbour.second) && neighbour.first > i) {
+          nDoubleBonds[find(i)]++;
+        }
+      }
+      if (inSystem[i] && hetero[i]) {
+        mobile[find(i)] = 1;
+        nMobileHydrogens[find(i)] += nHydrogens[i];
+      }
+    }
+    for (std::size_t i = 0; i < nAtoms; i++) {
+      std::size_t s = find(i);
+      if (!inSystem[i] || !mobile[s]) {
+        continue;
+      }
+      if (hetero[i]) {
+        invariants[i][2] = 0;
+      }
+      invariants[i][4] = nMobileHydrogens[s] * 1024 + nDoubleBonds[s];
+      for (std::pair<std::size_t, int> &neighbour : neighbours[i]) {
+        if (isConjugated(i, neighbour.first)) {
+          neighbour.second = 5;
+        }
+      }
+    }
+  }
+
+  // Tetrahedral centres have four neighbours, counting one hydrogen
+  std::vector<char> tetrahedral(nAtoms, 0);
+  for (std::size_t i = 0; i < nAtoms; i++) {
+    tetrahedral[i] = neighbours[i].size() == 4 ||
+                     (neighbours[i].size() == 3 && nHydrogens[i] == 1);
+  }
+  StructureGraph graph(heavyAtoms, invariants, neighbours, tetrahedral,
+                       eMatch == EXACT_MATCH);
+  std::uint64_t hash = support::fnv1aOffsetBasis;
+  for (long long value : graph.GetCanonicalCertificate()) {
+    hash = support::hashFNV1a(static_cast<std::uint64_t>(value), hash);
+  }
+  return hash;
+}
+
 void MdlFileSource::Parse() {
   // Only parse if we haven't already done so
   if (!m_bParsedOK) {
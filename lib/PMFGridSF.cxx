@@ -56,6 +56,15 @@ void PMFGridSF::SetupReceptor() {
   ReadGrids(pmfGrids.at("pmf-grids"));
 }
 // Determine PMF grid type for each atom
+// Shares the receptor grids with a clone
+void PMFGridSF::ShareReceptorData(BaseSF *pClone) const {
+  PMFGridSF *pPMFClone = dynamic_cast<PMFGridSF *>(pClone);
+  if (pPMFClone && !GetReceptor().Null()) {
+    pPMFClone->theGrids = theGrids;
+    ShareReceptor(pPMFClone);
+  }
+}
+
 void PMFGridSF::SetupLigand() {
   theLigandList.clear();
   if (GetLigand().Null())
@@ -141,6 +141,8 @@ PMFIdxSF::~PMFIdxSF() {
   _RBTOBJECTCOUNTER_DESTR_(_CT);
 }
 
+bool PMFIdxSF::isReceptorReadOnly() const { return false; }
+
 void PMFIdxSF::Update(Subject *theChangedSubject) {
   LOG_F(2, "PMFIdxSF PMF Update");
   BaseInterSF::Update(theChangedSubject);
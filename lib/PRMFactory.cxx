@@ -180,6 +180,14 @@ ModelPtr PRMFactory::CreateLigand(BaseMolecularFileSource *pSource) {
   return retVal;
 }
 
+void PRMFactory::SetLigandFlexData(ModelPtr spLigand) {
+  if (!m_pDS) {
+    throw BadArgument(_WHERE_, "A docking site is needed for making a ligand "
+                               "flexible");
+  }
+  AttachLigandFlexData(spLigand);
+}
+
 ModelList PRMFactory::CreateSolvent() {
   ModelList retVal;
   m_pParamSource->SetSection(_SOLV_SECTION);
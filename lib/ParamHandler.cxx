@@ -67,6 +67,19 @@ void ParamHandler::SetParameter(const std::string &strName,
   }
 }
 
+// Set each parameter that is also defined in ph to its value in ph
+void ParamHandler::CopyParameters(const ParamHandler &ph) {
+  for (StringVariantMapConstIter iter = ph.m_parameters.begin();
+       iter != ph.m_parameters.end(); iter++) {
+    StringVariantMapConstIter found = m_parameters.find(iter->first);
+    if ((found != m_parameters.end()) &&
+        ((found->second.GetDouble() != iter->second.GetDouble()) ||
+         (found->second.GetStringList() != iter->second.GetStringList()))) {
+      SetParameter(iter->first, iter->second);
+    }
+  }
+}
+
 ////////////////////////////////////////
 // Protected methods
 ///////////////////
@@ -114,6 +114,8 @@ void PolarIdxSF::SetupReceptor() {
     m_recepPosList = CreateDonorInteractionCenters(atomList);
     m_spNegGrid = CreateInteractionGrid();
     m_recepNegList = CreateAcceptorInteractionCenters(atomList);
+    m_spRecepOwner =
+        new InteractionCenterOwner(m_recepPosList, m_recepNegList);
     for (int i = 1; i <= nCoords; i++) {
       LOG_F(1, "PolarIdxSF::SetupReceptor: Indexing receptor coords # {}", i);
       GetReceptor()->RevertCoords(i);
@@ -137,6 +139,8 @@ void PolarIdxSF::SetupReceptor() {
     m_spNegGrid = CreateInteractionGrid();
     m_recepPosList = CreateDonorInteractionCenters(atomList);
     m_recepNegList = CreateAcceptorInteractionCenters(atomList);
+    m_spRecepOwner =
+        new InteractionCenterOwner(m_recepPosList, m_recepNegList);
 
     // For flexible receptors, separate the interaction centers into rigid and
     // flexible
@@ -282,10 +286,27 @@ void PolarIdxSF::ClearReceptor() {
   m_flexRecIntns.clear();
   m_flexRecPrtIntns.clear();
   m_bFlexRec = false;
-  DeleteList(m_recepPosList);
-  DeleteList(m_flexRecPosList);
-  DeleteList(m_recepNegList);
-  DeleteList(m_flexRecNegList);
+  // The interaction centers are owned by m_spRecepOwner
+  m_recepPosList.clear();
+  m_flexRecPosList.clear();
+  m_recepNegList.clear();
+  m_flexRecNegList.clear();
+  m_spRecepOwner = InteractionCenterOwnerPtr();
+}
+
+// Shares the rigid receptor interaction centers and indexing grids with a
+// clone
+void PolarIdxSF::ShareReceptorData(BaseSF *pClone) const {
+  PolarIdxSF *pPolarClone = dynamic_cast<PolarIdxSF *>(pClone);
+  if (pPolarClone && !GetReceptor().Null() && !m_bFlexRec) {
+    pPolarClone->ClearReceptor();
+    pPolarClone->m_spRecepOwner = m_spRecepOwner;
+    pPolarClone->m_spPosGrid = m_spPosGrid;
+    pPolarClone->m_spNegGrid = m_spNegGrid;
+    pPolarClone->m_recepPosList = m_recepPosList;
+    pPolarClone->m_recepNegList = m_recepNegList;
+    ShareReceptor(pPolarClone);
+  }
 }
 
 void PolarIdxSF::ClearLigand() {
@@ -11,30 +11,43 @@
  ***********************************************************************/
 
 #include "rxdock/Population.h"
+#include "rxdock/BaseSF.h"
 #include "rxdock/Debug.h"
 #include "rxdock/DockingError.h"
+#include "rxdock/WorkSpace.h"
 #include <algorithm>
+#include <exception>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace rxdock;
 
 const std::string Population::_CT = "Population";
 
-Population::Population(ChromElement *pChr, int size, BaseSF *pSF)
-    : m_size(size), m_c(2.0), m_pSF(pSF), m_rand(GetRandInstance()),
-      m_scoreMean(0.0), m_scoreVariance(0.0) {
+Population::Population(ChromElement *pChr, int size, BaseSF *pSF,
+                       const ScoringReplicaList &replicas, int nSeeded,
+                       double seedStepSize)
+    : m_size(size), m_c(2.0), m_pSF(pSF), m_replicas(replicas),
+      m_rand(GetRandInstance()), m_scoreMean(0.0), m_scoreVariance(0.0) {
   if (pChr == nullptr) {
     throw BadArgument(
         _WHERE_, "Null chromosome element passed to Population constructor");
   } else if (size <= 0) {
     throw BadArgument(_WHERE_, "Population size must be positive (non-zero)");
   }
-  // Create a random population
+  // Create a random population, apart from the seeded genomes
   m_pop.reserve(m_size);
   for (unsigned int i = 0; i < m_size; ++i) {
     // The Genome constructor clones the chromosome to create an independent
     // copy
     GenomePtr genome = new Genome(pChr);
-    genome->GetChrom()->Randomise();
+    if (static_cast<int>(i) >= nSeeded) {
+      genome->GetChrom()->Randomise();
+    } else if (i > 0) {
+      genome->GetChrom()->Mutate(seedStepSize);
+    }
     m_pop.push_back(genome);
   }
   // Calculate the scores and evaluate roulette wheel fitness
@@ -42,6 +55,30 @@ Population::Population(ChromElement *pChr, int size, BaseSF *pSF)
   _RBTOBJECTCOUNTER_CONSTR_(_CT);
 }
 
+Population::Population(const GenomeList &genomes, int size, BaseSF *pSF)
+    : m_size(size), m_c(2.0), m_pSF(pSF), m_rand(GetRandInstance()),
+      m_scoreMean(0.0), m_scoreVariance(0.0) {
+  if (genomes.empty()) {
+    throw BadArgument(_WHERE_, "No genomes passed to Population constructor");
+  } else if (size <= 0) {
+    throw BadArgument(_WHERE_, "Population size must be positive (non-zero)");
+  } else if (pSF == nullptr) {
+    throw BadArgument(_WHERE_,
+                      "Null scoring function passed to Population constructor");
+  }
+  m_pop.reserve(std::max<std::size_t>(m_size, genomes.size()));
+  for (GenomeListConstIter iter = genomes.begin(); iter != genomes.end();
+       ++iter) {
+    m_pop.push_back(new Genome(**iter));
+  }
+  std::stable_sort(m_pop.begin(), m_pop.end(), GenomeCmp_Score());
+  if (m_pop.size() > m_size) {
+    m_pop.erase(m_pop.begin() + m_size, m_pop.end());
+  }
+  EvaluateRWFitness();
+  _RBTOBJECTCOUNTER_CONSTR_(_CT);
+}
+
 Population::~Population() { _RBTOBJECTCOUNTER_DESTR_(_CT); }
 
 // Sets the scoring function used for ranking genomes
@@ -50,38 +87,122 @@ void Population::SetSF(BaseSF *pSF) {
     throw BadArgument(_WHERE_, "Null scoring function passed to SetSF");
   }
   m_pSF = pSF;
-  for (GenomeListIter iter = m_pop.begin(); iter != m_pop.end(); ++iter) {
-    (*iter)->SetScore(m_pSF);
+  // The scoring function parameters may have been changed since the last
+  // call, e.g. between docking stages
+  for (ScoringReplicaList::iterator iter = m_replicas.begin();
+       iter != m_replicas.end(); ++iter) {
+    iter->pSF->CopyTreeParameters(*m_pSF);
   }
+  ScoreGenomes(m_pop);
   std::stable_sort(m_pop.begin(), m_pop.end(), GenomeCmp_Score());
   EvaluateRWFitness();
 }
 
+void Population::SetScoringReplica(const ScoringReplica &replica) {
+  if (replica.pSF == nullptr) {
+    throw BadArgument(_WHERE_,
+                      "Null scoring function passed to SetScoringReplica");
+  }
+  m_pSF = replica.pSF;
+  m_spScoringChrom = replica.spChrom;
+}
+
 void Population::GAstep(int nReplicates, double relStepSize,
                         double equalityThreshold, double pcross, bool xovermut,
                         bool cmutate) {
   if (nReplicates <= 0) {
     throw BadArgument(_WHERE_, "nReplicates must be positive (non-zero)");
   }
-  GenomeList newPop;
+  CreateChildren(nReplicates, relStepSize, pcross, xovermut, cmutate);
+  MergeNewPop(m_children, equalityThreshold);
+  EvaluateRWFitness();
+}
+
+void Population::SteadyStateStep(int nReplicates, double relStepSize,
+                                 double equalityThreshold, double pcross,
+                                 bool xovermut, bool cmutate) {
+  if (nReplicates <= 0) {
+    throw BadArgument(_WHERE_, "nReplicates must be positive (non-zero)");
+  }
+  CreateChildren(nReplicates, relStepSize, pcross, xovermut, cmutate);
+  ScoreGenomes(m_children);
+  m_mergedPop.clear();
+  for (GenomeListConstIter iter = m_children.begin(); iter != m_children.end();
+       ++iter) {
+    InsertGenome(*iter, equalityThreshold);
+  }
+  // The children inserted are still referenced by the population, so only
+  // the discarded ones are recycled
+  RecycleGenomes(m_mergedPop);
+  RecycleGenomes(m_children);
+  EvaluateRWFitness();
+}
+
+void Population::Insert(const GenomeList &genomes,
+                        double equalityThreshold) {
+  m_mergedPop.clear();
+  for (GenomeListConstIter iter = genomes.begin(); iter != genomes.end();
+       ++iter) {
+    InsertGenome(NewChild(**iter), equalityThreshold);
+  }
+  RecycleGenomes(m_mergedPop);
+  EvaluateRWFitness();
+}
+
+void Population::InsertGenome(const GenomePtr &genome,
+                              double equalityThreshold) {
+  // The population stays sorted by score, so the place of the genome is
+  // found by binary search rather than by sorting. As when merging, the
+  // genome goes after the genomes with the same score
+  GenomeListIter iter = std::upper_bound(m_pop.begin(), m_pop.end(), genome,
+                                         GenomeCmp_Score());
+  if (static_cast<unsigned int>(iter - m_pop.begin()) >= m_size) {
+    m_mergedPop.push_back(genome);
+    return;
+  }
+  isGenome_eq isEqual(equalityThreshold);
+  if (iter != m_pop.begin() && isEqual(*(iter - 1), genome)) {
+    m_mergedPop.push_back(genome);
+    return;
+  }
+  // A worse genome equal to the new one is replaced by it, else the worst
+  // genome makes room for it
+  if (iter != m_pop.end() && isEqual(*iter, genome)) {
+    m_mergedPop.push_back(*iter);
+    *iter = genome;
+    return;
+  }
+  m_pop.insert(iter, genome);
+  if (m_pop.size() > m_size) {
+    m_mergedPop.push_back(m_pop.back());
+    m_pop.pop_back();
+  }
+}
+
+void Population::CreateChildren(int nReplicates, double relStepSize,
+                                double pcross, bool xovermut, bool cmutate) {
+  // The parents are only referenced by the population, which does not change
+  // until the children are merged into it
+  GenomeList &newPop = m_children;
+  newPop.clear();
   newPop.reserve(nReplicates);
   for (int i = 0; i < nReplicates / 2; i++) {
-    GenomePtr mother = RouletteWheelSelect();
-    GenomePtr father = RouletteWheelSelect();
+    Genome *mother = m_pop[RouletteWheelSelectIndex()];
+    Genome *father = m_pop[RouletteWheelSelectIndex()];
     // Check that mother and father are not the same genome
     // The check is on the pointers, not that the chromosomes are near-equal
     // If we repeatedly get the same genomes selected, this must mean
     // the population lacks diversity
     int j = 0;
     while (father == mother) {
-      father = RouletteWheelSelect();
+      father = m_pop[RouletteWheelSelectIndex()];
       if (j > 100)
         throw DockingError(_WHERE_,
                            "Population failure - not enough diversity");
       j++;
     }
-    GenomePtr child1 = new Genome(*mother);
-    GenomePtr child2 = new Genome(*father);
+    GenomePtr child1 = NewChild(*mother);
+    GenomePtr child2 = NewChild(*father);
     // Crossover
     if (m_rand.GetRandom01() < pcross) {
       Crossover(father->GetChrom(), mother->GetChrom(), child1->GetChrom(),
@@ -110,13 +231,11 @@ void Population::GAstep(int nReplicates, double relStepSize,
   }
   // check if one more is needed (odd nReplicates).
   if (nReplicates % 2) {
-    GenomePtr mother = RouletteWheelSelect();
-    GenomePtr child = new Genome(*mother);
+    Genome *mother = m_pop[RouletteWheelSelectIndex()];
+    GenomePtr child = NewChild(*mother);
     child->GetChrom()->CauchyMutate(0.0, relStepSize);
     newPop.push_back(child);
   }
-  MergeNewPop(newPop, equalityThreshold);
-  EvaluateRWFitness();
 }
 
 GenomePtr Population::Best() const {
@@ -136,6 +255,10 @@ std::ostream &operator<<(std::ostream &s, const Population &p) {
 }
 
 GenomePtr Population::RouletteWheelSelect() const {
+  return m_pop[RouletteWheelSelectIndex()];
+}
+
+int Population::RouletteWheelSelectIndex() const {
   double cutoff = m_rand.GetRandom01();
   int size = m_pop.size();
   int lower = 0;
@@ -150,17 +273,37 @@ GenomePtr Population::RouletteWheelSelect() const {
   // make sure lower is a number between 0 and size - 1
   lower = std::min(size - 1, lower);
   lower = std::max(0, lower);
-  return (m_pop[lower]);
+  return lower;
+}
+
+GenomePtr Population::NewChild(const Genome &parent) {
+  if (m_spareGenomes.empty()) {
+    return new Genome(parent);
+  }
+  GenomePtr child = m_spareGenomes.back();
+  m_spareGenomes.pop_back();
+  child->CopyFrom(parent);
+  return child;
+}
+
+void Population::RecycleGenomes(GenomeList &genomes) {
+  for (GenomeListIter iter = genomes.begin(); iter != genomes.end(); ++iter) {
+    // Genomes still referenced elsewhere, e.g. a best genome kept by the
+    // caller, must not change
+    if (iter->IsUnique()) {
+      m_spareGenomes.push_back(*iter);
+    }
+  }
+  genomes.clear();
 }
 
 void Population::MergeNewPop(GenomeList &newPop, double equalityThreshold) {
   // Assume newPop needs scoring and sorting
-  for (GenomeListIter iter = newPop.begin(); iter != newPop.end(); ++iter) {
-    (*iter)->SetScore(m_pSF);
-  }
+  ScoreGenomes(newPop);
   std::stable_sort(newPop.begin(), newPop.end(), GenomeCmp_Score());
 
-  GenomeList mergedPop;
+  GenomeList &mergedPop = m_mergedPop;
+  mergedPop.clear();
   mergedPop.reserve(m_pop.size() + newPop.size());
   // Merge pops by score
   std::merge(m_pop.begin(), m_pop.end(), newPop.begin(), newPop.end(),
@@ -169,10 +312,87 @@ void Population::MergeNewPop(GenomeList &newPop, double equalityThreshold) {
   GenomeListIter end = std::unique(mergedPop.begin(), mergedPop.end(),
                                    isGenome_eq(equalityThreshold));
   mergedPop.erase(end, mergedPop.end());
-  m_pop.clear();
-  end = (mergedPop.size() > m_size) ? (mergedPop.begin() + m_size)
-                                    : mergedPop.end();
-  std::copy(mergedPop.begin(), end, back_inserter(m_pop));
+  if (mergedPop.size() > m_size) {
+    mergedPop.erase(mergedPop.begin() + m_size, mergedPop.end());
+  }
+  // The merged genomes become the population, and the genomes of the old
+  // population and the new individuals that are not kept become spares
+  m_pop.swap(mergedPop);
+  RecycleGenomes(mergedPop);
+  RecycleGenomes(newPop);
+}
+
+void Population::ScoreGenomes(GenomeList &genomes) {
+  // Decoding a chromosome moves the models from their current coordinates,
+  // so that a score would depend on the genomes scored before it, on the same
+  // thread. Each genome is decoded from the coordinates the models have on
+  // entry instead, which are restored afterwards: the scores then do not
+  // depend on the order the genomes are scored in or on the thread that
+  // scores them. This is done without scoring replicas too, as the scores
+  // must not depend on the number of scoring threads
+  WorkSpace *pWorkSpace = m_pSF->GetWorkSpace();
+  std::vector<CoordList> coords;
+  if (pWorkSpace != nullptr) {
+    coords = pWorkSpace->GetMobileCoords();
+  }
+  int nGenomes = genomes.size();
+  if (m_replicas.empty() || nGenomes < 2) {
+    for (GenomeListIter iter = genomes.begin(); iter != genomes.end();
+         ++iter) {
+      if (m_spScoringChrom.Null()) {
+        (*iter)->SetScore(m_pSF);
+      } else {
+        (*iter)->SetScore(m_pSF, m_spScoringChrom);
+      }
+      if (pWorkSpace != nullptr) {
+        pWorkSpace->SetMobileCoords(coords);
+      }
+    }
+    return;
+  }
+  // The replica models start from the same coordinates
+  for (ScoringReplicaList::iterator iter = m_replicas.begin();
+       iter != m_replicas.end(); ++iter) {
+    WorkSpace *pReplicaWorkSpace = iter->pSF->GetWorkSpace();
+    if (pWorkSpace != nullptr && pReplicaWorkSpace != nullptr) {
+      pReplicaWorkSpace->SetMobileCoords(coords);
+    }
+  }
+  int nThreads = m_replicas.size() + 1;
+  std::exception_ptr scoreException;
+#pragma omp parallel for num_threads(nThreads) schedule(static)
+  for (int i = 0; i < nGenomes; ++i) {
+    int iThread = 0;
+#ifdef _OPENMP
+    iThread = omp_get_thread_num();
+#endif
+    try {
+      BaseSF *pSF = m_pSF;
+      if (iThread == 0) {
+        if (m_spScoringChrom.Null()) {
+          genomes[i]->SetScore(pSF);
+        } else {
+          genomes[i]->SetScore(pSF, m_spScoringChrom);
+        }
+      } else {
+        ScoringReplica &replica = m_replicas[iThread - 1];
+        pSF = replica.pSF;
+        genomes[i]->SetScore(pSF, replica.spChrom);
+      }
+      WorkSpace *pThreadWorkSpace = pSF->GetWorkSpace();
+      if (pWorkSpace != nullptr && pThreadWorkSpace != nullptr) {
+        pThreadWorkSpace->SetMobileCoords(coords);
+      }
+    } catch (...) {
+#pragma omp critical(populationScore)
+      if (!scoreException) {
+        scoreException = std::current_exception();
+      }
+    }
+  }
+  if (scoreException) {
+    std::rethrow_exception(scoreException);
+  }
 }
 
 void Population::EvaluateRWFitness() {
@@ -11,7 +11,6 @@
  ***********************************************************************/
 
 #include "rxdock/Rand.h"
-#include "rxdock/Singleton.h"
 
 using namespace rxdock;
 
@@ -36,18 +35,67 @@ Rand::~Rand() { _RBTOBJECTCOUNTER_DESTR_("Rand"); }
 ////////////////
 // Public methods
 
+// Mixes the bits of x with the splitmix64 finaliser, so that nearby inputs
+// give unrelated outputs
+static std::uint64_t MixBits(std::uint64_t x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
 // Seed the random number generator
-void Rand::Seed(int seed) { m_rng.seed(seed); }
+void Rand::Seed(int seed) {
+  m_rng.seed(seed);
+  m_key = MixBits(static_cast<std::uint32_t>(seed));
+  m_nSubstreamKeys = 0;
+}
 
 // Seed the random number generator from the random device
 void Rand::SeedFromRandomDevice() {
-#if defined(__sun) || (defined(_WIN32) && defined(_MSC_VER))
   std::random_device rd;
+#if defined(__sun) || (defined(_WIN32) && defined(_MSC_VER))
   m_rng.seed(rd());
 #else
   pcg_extras::seed_seq_from<std::random_device> seedSource;
   m_rng.seed(seedSource);
 #endif
+  m_key = (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+  m_nSubstreamKeys = 0;
+}
+
+// Seed the random number generator with the stream for run iRun of ligand
+// iLigand. The seed and the indices are mixed into one key, which sets both
+// the state and the stream of the generator, so that the streams of nearby
+// seeds, ligands and runs are unrelated
+void Rand::SeedStream(int seed, std::uint64_t iLigand, std::uint64_t iRun) {
+  SeedKey(MixBits(
+      MixBits(MixBits(static_cast<std::uint32_t>(seed)) ^ iLigand) ^ iRun));
+}
+
+// The keys of the substreams are mixed from the key of the generator and
+// their number, so that they are unrelated to the streams of other runs
+std::uint64_t Rand::GetSubstreamKey() {
+  return MixBits(m_key ^ MixBits(++m_nSubstreamKeys));
+}
+
+void Rand::SeedSubstream(std::uint64_t nKey, std::uint64_t iSubstream) {
+  SeedKey(MixBits(nKey ^ iSubstream));
+}
+
+void Rand::SeedKey(std::uint64_t key) {
+  std::uint64_t stream = MixBits(key);
+#if defined(__sun) || (defined(_WIN32) && defined(_MSC_VER))
+  std::seed_seq seedSeq{static_cast<std::uint32_t>(key),
+                        static_cast<std::uint32_t>(key >> 32),
+                        static_cast<std::uint32_t>(stream),
+                        static_cast<std::uint32_t>(stream >> 32)};
+  m_rng.seed(seedSeq);
+#else
+  m_rng.seed(key, stream);
+#endif
+  m_key = key;
+  m_nSubstreamKeys = 0;
 }
 
 // Get a random double between 0 and 1
@@ -90,5 +138,21 @@ double Rand::GetCauchyRandom(double mean, double variance) {
 ///////////////////////////////////////
 // Non-member functions in rxdock namespace
 
-// Returns reference to single instance of Rand class (singleton)
-Rand &rxdock::GetRandInstance() { return Singleton<Rand>::instance(); }
+// Instance installed by SetRandInstance for the calling thread, if any
+static thread_local Rand *pActiveRand = nullptr;
+
+// Returns reference to the instance of Rand class belonging to the calling
+// thread, so that docking threads draw from independent generators
+Rand &rxdock::GetRandInstance() {
+  if (pActiveRand != nullptr) {
+    return *pActiveRand;
+  }
+  static thread_local Rand theRand;
+  return theRand;
+}
+
+Rand *rxdock::SetRandInstance(Rand *pRand) {
+  Rand *pPrevious = pActiveRand;
+  pActiveRand = pRand;
+  return pPrevious;
+}
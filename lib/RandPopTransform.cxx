@@ -23,11 +23,15 @@ const std::string RandPopTransform::_CT = "RandPopTransform";
 const std::string RandPopTransform::_POP_SIZE = "population-size";
 const std::string RandPopTransform::_SCALE_CHROM_LENGTH =
     "scale-chromosome-length";
+const std::string RandPopTransform::_SEED_FRACTION = "seed-fraction";
+const std::string RandPopTransform::_SEED_STEP_SIZE = "seed-step-size";
 
 RandPopTransform::RandPopTransform(const std::string &strName)
     : BaseBiMolTransform(_CT, strName) {
   AddParameter(_POP_SIZE, 50);
   AddParameter(_SCALE_CHROM_LENGTH, true);
+  AddParameter(_SEED_FRACTION, 0.0);
+  AddParameter(_SEED_STEP_SIZE, 1.0);
   _RBTOBJECTCOUNTER_CONSTR_(_CT);
 }
 
@@ -66,8 +70,32 @@ void RandPopTransform::Execute() {
     int chromLength = m_chrom->GetLength();
     popSize *= chromLength;
   }
-  LOG_F(2, "RandPopTransform::Execute: popSize={}", popSize);
-  PopulationPtr pop = new Population(m_chrom, popSize, pSF);
+  // The seeded genomes start from the chromosome as it is in the models
+  double seedFraction = GetParameter(_SEED_FRACTION);
+  double seedStepSize = GetParameter(_SEED_STEP_SIZE);
+  int nSeeded = static_cast<int>(seedFraction * popSize + 0.5);
+  if (nSeeded > 0) {
+    m_chrom->SyncFromModel();
+  }
+  LOG_F(2, "RandPopTransform::Execute: popSize={} nSeeded={}", popSize,
+        nSeeded);
+  // Score the population concurrently on any scoring replicas of the
+  // workspace
+  ScoringReplicaList replicas;
+  std::vector<WorkSpace *> replicaWorkSpaces =
+      GetWorkSpace()->GetScoringReplicas();
+  for (std::vector<WorkSpace *>::const_iterator iter =
+           replicaWorkSpaces.begin();
+       iter != replicaWorkSpaces.end(); ++iter) {
+    if ((*iter)->GetSF() != nullptr) {
+      ScoringReplica replica;
+      replica.spChrom = new Chrom((*iter)->GetModels());
+      replica.pSF = (*iter)->GetSF();
+      replicas.push_back(replica);
+    }
+  }
+  PopulationPtr pop = new Population(m_chrom, popSize, pSF, replicas,
+                                     nSeeded, seedStepSize);
   pop->Best()->GetChrom()->SyncToModel();
   GetWorkSpace()->SetPopulation(pop);
 }
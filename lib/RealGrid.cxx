@@ -161,14 +161,15 @@ double RealGrid::GetSmoothedValue(const Coord &c) const {
   double bx0by1 = bx0 * by1;
   double bx1by0 = bx1 * by0;
   double bx1by1 = bx1 * by1;
-  val += m_grid(iX, iY, iZ) * bx0by0 * bz0;
-  val += m_grid(iX, iY, iZ + 1) * bx0by0 * bz1;
-  val += m_grid(iX, iY + 1, iZ) * bx0by1 * bz0;
-  val += m_grid(iX, iY + 1, iZ + 1) * bx0by1 * bz1;
-  val += m_grid(iX + 1, iY, iZ) * bx1by0 * bz0;
-  val += m_grid(iX + 1, iY, iZ + 1) * bx1by0 * bz1;
-  val += m_grid(iX + 1, iY + 1, iZ) * bx1by1 * bz0;
-  val += m_grid(iX + 1, iY + 1, iZ + 1) * bx1by1 * bz1;
+  ConstGridMap grid = Grid();
+  val += grid(iX, iY, iZ) * bx0by0 * bz0;
+  val += grid(iX, iY, iZ + 1) * bx0by0 * bz1;
+  val += grid(iX, iY + 1, iZ) * bx0by1 * bz0;
+  val += grid(iX, iY + 1, iZ + 1) * bx0by1 * bz1;
+  val += grid(iX + 1, iY, iZ) * bx1by0 * bz0;
+  val += grid(iX + 1, iY, iZ + 1) * bx1by0 * bz1;
+  val += grid(iX + 1, iY + 1, iZ) * bx1by1 * bz0;
+  val += grid(iX + 1, iY + 1, iZ + 1) * bx1by1 * bz1;
   // for (UInt i = 0; i < 2; i++) {
   //  for (UInt j = 0; j < 2; j++) {
   //    for (UInt k = 0; k < 2; k++) {
@@ -180,15 +181,17 @@ double RealGrid::GetSmoothedValue(const Coord &c) const {
 }
 
 // Set all grid points to the given value
-void RealGrid::SetAllValues(double val) { m_grid.setConstant(val); }
+void RealGrid::SetAllValues(double val) {
+  std::fill(m_data.begin(), m_data.end(), static_cast<float>(val));
+}
 
 // Replaces all grid points between oldValMin and oldValMax with newVal
 void RealGrid::ReplaceValueRange(double oldValMin, double oldValMax,
                                  double newVal) {
+  GridMap grid = Grid();
   Eigen::Tensor<bool, 3, Eigen::RowMajor> bGrid =
-      m_grid >= m_grid.constant(oldValMin) &&
-      m_grid < m_grid.constant(oldValMax);
-  m_grid = bGrid.select(m_grid.constant(newVal), m_grid);
+      grid >= grid.constant(oldValMin) && grid < grid.constant(oldValMax);
+  grid = bGrid.select(grid.constant(newVal), grid);
 }
 
 // Set all grid points within radius of coord to the given value
@@ -231,27 +234,28 @@ void RealGrid::CreateSurface(double oldVal, double adjVal, double newVal) {
   unsigned int iMaxX = GetNX() - GetPad();
   unsigned int iMaxY = GetNY() - GetPad();
   unsigned int iMaxZ = GetNZ() - GetPad();
+  GridMap grid = Grid();
 
   // probably could be better written
   for (unsigned int iX = iMinX; iX < iMaxX; iX++) {
     for (unsigned int iY = iMinY; iY < iMaxY; iY++) {
       for (unsigned int iZ = iMinZ; iZ < iMaxZ; iZ++) {
         // We have a match with oldVal
-        if (std::fabs(m_grid(iX, iY, iZ) - oldVal) < m_tol) {
+        if (std::fabs(grid(iX, iY, iZ) - oldVal) < m_tol) {
           // Check the six adjacent points for a match with adjVal
           if (((iX > iMinX) &&
-               (std::fabs(m_grid(iX - 1, iY, iZ) - adjVal) < m_tol)) ||
+               (std::fabs(grid(iX - 1, iY, iZ) - adjVal) < m_tol)) ||
               ((iX < iMaxX) &&
-               (std::fabs(m_grid(iX + 1, iY, iZ) - adjVal) < m_tol)) ||
+               (std::fabs(grid(iX + 1, iY, iZ) - adjVal) < m_tol)) ||
               ((iY > iMinY) &&
-               (std::fabs(m_grid(iX, iY - 1, iZ) - adjVal) < m_tol)) ||
+               (std::fabs(grid(iX, iY - 1, iZ) - adjVal) < m_tol)) ||
               ((iY < iMaxY) &&
-               (std::fabs(m_grid(iX, iY + 1, iZ) - adjVal) < m_tol)) ||
+               (std::fabs(grid(iX, iY + 1, iZ) - adjVal) < m_tol)) ||
               ((iZ > iMinZ) &&
-               (std::fabs(m_grid(iX, iY, iZ - 1) - adjVal) < m_tol)) ||
+               (std::fabs(grid(iX, iY, iZ - 1) - adjVal) < m_tol)) ||
               ((iZ < iMaxZ) &&
-               (std::fabs(m_grid(iX, iY, iZ + 1) - adjVal) < m_tol)))
-            m_grid(iX, iY, iZ) = newVal;
+               (std::fabs(grid(iX, iY, iZ + 1) - adjVal) < m_tol)))
+            grid(iX, iY, iZ) = newVal;
         }
       }
     }
@@ -291,18 +295,19 @@ void RealGrid::SetAccessible(double radius, double oldVal, double adjVal,
                       (static_cast<unsigned int>(nXYZ(1)) + 1) *
                       (static_cast<unsigned int>(nXYZ(2)) + 1);
   sphereIndices.reserve(nMax);
+  GridMap grid = Grid();
   // possibly can be better written
   for (unsigned int iX = iMinX; iX < iMaxX; iX++) {
     for (unsigned int iY = iMinY; iY < iMaxY; iY++) {
       for (unsigned int iZ = iMinZ; iZ < iMaxZ; iZ++) {
         // We have a match with oldVal
-        if (std::fabs(m_grid(iX, iY, iZ) - oldVal) < m_tol) {
+        if (std::fabs(grid(iX, iY, iZ) - oldVal) < m_tol) {
           Coord c = GetCoord(iX, iY, iZ);
           // Check the sphere around this grid point
           GetSphereIndices(c, radius, sphereIndices);
           if (!isValueWithinList(sphereIndices, adjVal)) {
             if (bCenterOnly)
-              m_grid(iX, iY, iZ) = newVal; // Set just the center grid point
+              grid(iX, iY, iZ) = newVal; // Set just the center grid point
             else
               // SetValues(sphereIndices,newVal,false);//Set all grid points in
               // the sphere
@@ -322,8 +327,9 @@ void RealGrid::SetAccessible(double radius, double oldVal, double adjVal,
 
 // Returns number of occurrences of a given value range
 unsigned int RealGrid::CountRange(double valMin, double valMax) const {
+  ConstGridMap grid = Grid();
   Eigen::Tensor<bool, 3, Eigen::RowMajor> bGrid =
-      m_grid >= m_grid.constant(valMin) && m_grid < m_grid.constant(valMax);
+      grid >= grid.constant(valMin) && grid < grid.constant(valMax);
   Eigen::Tensor<unsigned int, 0, Eigen::RowMajor> tN =
       bGrid.cast<unsigned int>().sum();
   return tN(0);
@@ -331,19 +337,19 @@ unsigned int RealGrid::CountRange(double valMin, double valMax) const {
 
 // Min/max values
 double RealGrid::MinValue() const {
-  Eigen::Tensor<float, 0, Eigen::RowMajor> tMinimum = m_grid.minimum();
+  Eigen::Tensor<float, 0, Eigen::RowMajor> tMinimum = Grid().minimum();
   return tMinimum(0);
 }
 
 double RealGrid::MaxValue() const {
-  Eigen::Tensor<float, 0, Eigen::RowMajor> tMaximum = m_grid.maximum();
+  Eigen::Tensor<float, 0, Eigen::RowMajor> tMaximum = Grid().maximum();
   return tMaximum(0);
 }
 
 // iXYZ index of grid point with minimum value
 unsigned int RealGrid::FindMinValue() const {
   unsigned int iMin = 0;
-  const float *data = m_grid.data();
+  const float *data = m_data.data();
   for (unsigned int i = 0; i < GetN(); i++) {
     if (data[i] < data[iMin])
       iMin = i;
@@ -354,7 +360,7 @@ unsigned int RealGrid::FindMinValue() const {
 // iXYZ index of grid point with maximum value
 unsigned int RealGrid::FindMaxValue() const {
   unsigned int iMax = 0;
-  const float *data = m_grid.data();
+  const float *data = m_data.data();
   for (unsigned int i = 0; i < GetN(); i++) {
     if (data[i] > data[iMax])
       iMax = i;
@@ -387,10 +393,11 @@ void RealGrid::PrintInsightGrid(std::ostream &s) const {
   // s.setf(std::ios_base::fixed,ios_base::floatfield);
   // s.setf(std::ios_base::right,ios_base::adjustfield);
   // Insight expects data in [1][1][1],[2][1][1]..[NX][1][1] order
+  ConstGridMap grid = Grid();
   for (unsigned int iZ = 0; iZ < GetNZ(); iZ++) {
     for (unsigned int iY = 0; iY < GetNY(); iY++) {
       for (unsigned int iX = 0; iX < GetNX(); iX++) {
-        s << std::setw(15) << m_grid(iX, iY, iZ) << std::endl;
+        s << std::setw(15) << grid(iX, iY, iZ) << std::endl;
       }
     }
   }
@@ -405,11 +412,12 @@ void RealGrid::OwnPrint(std::ostream &ostr) const {
   // Iterate over all grid points
   float tol = GetTolerance();
   // TODO use chip()
+  ConstGridMap grid = Grid();
   for (unsigned int iX = 0; iX < GetNX(); iX++) {
     ostr << std::endl << std::endl << "Plane iX=" << iX << std::endl;
     for (unsigned int iY = 0; iY < GetNY(); iY++) {
       for (unsigned int iZ = 0; iZ < GetNZ(); iZ++) {
-        float f = m_grid(iX, iY, iZ);
+        float f = grid(iX, iY, iZ);
         ostr << ((f < -tol) ? '-' : (f > tol) ? '+' : '.');
       }
       ostr << std::endl;
@@ -425,7 +433,7 @@ void RealGrid::OwnPrint(std::ostream &ostr) const {
 // values out of bounds
 bool RealGrid::isValueWithinList(const std::vector<unsigned int> &iXYZList,
                                  double val) {
-  float *data = m_grid.data();
+  float *data = m_data.data();
   for (std::vector<unsigned int>::const_iterator iter = iXYZList.begin();
        iter != iXYZList.end(); iter++) {
     if (std::fabs(data[*iter] - val) < m_tol) {
@@ -441,7 +449,7 @@ bool RealGrid::isValueWithinList(const std::vector<unsigned int> &iXYZList,
 // bOverwrite is true, all grid points are set the new value
 void RealGrid::SetValues(const std::vector<unsigned int> &iXYZList, double val,
                          bool bOverwrite) {
-  float *data = m_grid.data();
+  float *data = m_data.data();
   for (std::vector<unsigned int>::const_iterator iter = iXYZList.begin();
        iter != iXYZList.end(); iter++) {
     if (bOverwrite || (std::fabs(data[*iter]) < m_tol)) {
@@ -451,10 +459,10 @@ void RealGrid::SetValues(const std::vector<unsigned int> &iXYZList, double val,
 }
 
 void RealGrid::CreateArrays() {
-  int nX = GetNX();
-  int nY = GetNY();
-  int nZ = GetNZ();
-  m_grid = Eigen::Tensor<float, 3, Eigen::RowMajor>(nX, nY, nZ);
+  std::size_t nX = GetNX();
+  std::size_t nY = GetNY();
+  std::size_t nZ = GetNZ();
+  m_data.assign(nX * nY * nZ, 0.0f);
 }
 
 // Helper function called by copy constructor and assignment operator
@@ -462,12 +470,11 @@ void RealGrid::CreateArrays() {
 // Gets called after array has been created, and base class copy has been done
 void RealGrid::CopyGrid(const RealGrid &grid) {
   m_tol = grid.m_tol;
-  m_grid = grid.m_grid;
+  m_data = grid.m_data;
 }
 
 void rxdock::to_json(json &j, const RealGrid &grid) {
-  const std::vector<float> data(grid.m_grid.data(),
-                                grid.m_grid.data() + grid.GetN());
+  const std::vector<float> data(grid.m_data.begin(), grid.m_data.end());
   j = json{{"tolerance", grid.m_tol},
            {"data", data},
            {"base-grid", static_cast<BaseGrid>(grid)}};
@@ -480,5 +487,5 @@ void rxdock::from_json(const json &j, RealGrid &grid) {
   grid.CreateArrays();
   std::vector<float> data;
   j.at("data").get_to(data);
-  std::copy(data.begin(), data.end(), grid.m_grid.data());
+  std::copy(data.begin(), data.end(), grid.m_data.begin());
 }
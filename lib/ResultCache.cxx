@@ -0,0 +1,151 @@
+//===-- ResultCache.cxx - On-disk store of docking results ------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+
+#include "rxdock/ResultCache.h"
+#include "rxdock/FileError.h"
+#include "rxdock/MdlFileSource.h"
+#include "rxdock/support/Hash.h"
+
+#include <fmt/format.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#define getpid _getpid
+#define mkdir(dirName, mode) _mkdir(dirName)
+#else
+#include <unistd.h> // For POSIX getpid
+#endif
+
+using namespace rxdock;
+
+static void MakeDirectory(const std::string &dirName) {
+  if (mkdir(dirName.c_str(), 0777) != 0 && errno != EEXIST) {
+    throw FileWriteError(_WHERE_, "Error creating " + dirName);
+  }
+}
+
+// Returns the contents of fileName, or false if it can not be read
+static bool ReadFile(const std::string &fileName, std::string &text) {
+  std::ifstream fileIn(fileName.c_str(), std::ios::binary);
+  if (!fileIn) {
+    return false;
+  }
+  std::ostringstream ostr;
+  ostr << fileIn.rdbuf();
+  if (!fileIn) {
+    return false;
+  }
+  text = ostr.str();
+  return true;
+}
+
+ResultCache::ResultCache(const std::string &dirName,
+                         const std::string &strJobKey)
+    : m_strDirName(dirName), m_nJobHash(support::hashFNV1a(strJobKey)) {
+  MakeDirectory(m_strDirName);
+  MakeDirectory(m_strDirName + "/jobs");
+  std::string strJobFile =
+      m_strDirName + "/jobs/" + support::formatHash(m_nJobHash) + ".txt";
+  std::string strStoredKey;
+  if (!ReadFile(strJobFile, strStoredKey)) {
+    WriteFile(strJobFile, strJobKey);
+  } else if (strStoredKey != strJobKey) {
+    throw InvalidRequest(_WHERE_, "The key of another job in " + strJobFile +
+                                      " has the same hash as this job");
+  }
+}
+
+bool ResultCache::Lookup(const std::vector<std::string> &lineRecs,
+                         std::vector<std::string> &storedLineRecs,
+                         std::string &text) const {
+  std::string strConnectionTable = GetConnectionTable(lineRecs);
+  std::string strEntry;
+  if (!ReadFile(GetEntryFileName(
+                    support::hashFNV1a(strConnectionTable, m_nJobHash)),
+                strEntry)) {
+    return false;
+  }
+  // The entry holds the job hash, the record and its delimiter, then the text
+  std::istringstream istr(strEntry);
+  std::string line;
+  if (!std::getline(istr, line) || line != support::formatHash(m_nJobHash)) {
+    return false;
+  }
+  std::vector<std::string> entryLineRecs;
+  while (std::getline(istr, line) && line != IDS_MDL_RECDELIM) {
+    entryLineRecs.push_back(line);
+  }
+  if (!istr || GetConnectionTable(entryLineRecs) != strConnectionTable) {
+    return false;
+  }
+  storedLineRecs = entryLineRecs;
+  text = strEntry.substr(static_cast<std::size_t>(istr.tellg()));
+  return true;
+}
+
+void ResultCache::Store(const std::vector<std::string> &lineRecs,
+                        const std::string &text) {
+  std::uint64_t key =
+      support::hashFNV1a(GetConnectionTable(lineRecs), m_nJobHash);
+  std::string strEntry = support::formatHash(m_nJobHash) + "\n";
+  for (const std::string &line : lineRecs) {
+    strEntry += line + "\n";
+  }
+  strEntry += IDS_MDL_RECDELIM + "\n" + text;
+  MakeDirectory(m_strDirName + "/" + support::formatHash(key).substr(0, 2));
+  WriteFile(GetEntryFileName(key), strEntry);
+}
+
+std::string
+ResultCache::GetConnectionTable(const std::vector<std::string> &lineRecs) {
+  std::string strConnectionTable;
+  for (std::size_t iLine = 3; iLine < lineRecs.size(); iLine++) {
+    const std::string &line = lineRecs[iLine];
+    std::size_t nLength = line.find_last_not_of(" \t\r");
+    nLength = (nLength == std::string::npos) ? 0 : nLength + 1;
+    strConnectionTable += line.substr(0, nLength) + "\n";
+    if (line.compare(0, 6, "M  END") == 0) {
+      break;
+    }
+  }
+  return strConnectionTable;
+}
+
+std::string ResultCache::GetEntryFileName(std::uint64_t key) const {
+  std::string strKey = support::formatHash(key);
+  return m_strDirName + "/" + strKey.substr(0, 2) + "/" + strKey + ".sd";
+}
+
+void ResultCache::WriteFile(const std::string &fileName,
+                            const std::string &text) {
+  // The temporary file name is unique to the process and to the call, so
+  // that threads and processes writing the same file do not clash
+  static std::atomic<unsigned long> nWritten(0);
+  std::string strTmpFile =
+      fmt::format("{}.{}-{}.tmp", fileName, getpid(), nWritten++);
+  std::ofstream ostr(strTmpFile.c_str(), std::ios::binary);
+  ostr << text;
+  ostr.close();
+  if (!ostr || std::rename(strTmpFile.c_str(), fileName.c_str()) != 0) {
+    std::remove(strTmpFile.c_str());
+    throw FileWriteError(_WHERE_, "Error writing " + fileName);
+  }
+}
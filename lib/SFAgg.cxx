@@ -85,6 +85,26 @@ void SFAgg::ScoreMap(StringVariantMap &scoreMap) const {
   }
 }
 
+// Aggregate version clones all children
+SFAgg *SFAgg::Clone() const {
+  SFAgg *pClone = new SFAgg(GetName());
+  pClone->CopyParameters(*this);
+  for (BaseSFListConstIter iter = m_sf.begin(); iter != m_sf.end(); iter++) {
+    pClone->Add((*iter)->Clone());
+  }
+  return pClone;
+}
+
+// Aggregate version checks all children
+bool SFAgg::isReceptorReadOnly() const {
+  for (BaseSFListConstIter iter = m_sf.begin(); iter != m_sf.end(); iter++) {
+    if (!(*iter)->isReceptorReadOnly()) {
+      return false;
+    }
+  }
+  return true;
+}
+
 // Aggregate handling methods
 void SFAgg::Add(BaseSF *pSF) {
   // By first orphaning the scoring function to be added,
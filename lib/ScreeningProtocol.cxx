@@ -0,0 +1,203 @@
+//===-- ScreeningProtocol.cxx - Multi-stage screening protocol --*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+
+#include "rxdock/ScreeningProtocol.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace rxdock;
+
+// Returns the best of the first nRuns scores of a ligand
+static double GetBestScore(const std::vector<double> &scores,
+                           std::size_t nRuns) {
+  nRuns = std::min(nRuns, scores.size());
+  if (nRuns == 0) {
+    return std::numeric_limits<double>::infinity();
+  }
+  return *std::min_element(scores.begin(), scores.begin() + nRuns);
+}
+
+ScreeningProtocol::ScreeningProtocol(const std::vector<Stage> &stages,
+                                     std::size_t nMaxRuns,
+                                     const std::string &strScoreName)
+    : m_stages(stages), m_nMaxRuns(nMaxRuns), m_strScoreName(strScoreName) {
+  Validate();
+}
+
+ScreeningProtocol::ScreeningProtocol(json j) {
+  j.get_to(*this);
+  Validate();
+}
+
+void ScreeningProtocol::Validate() const {
+  std::size_t nPrevRuns = 0;
+  for (const Stage &stage : m_stages) {
+    if (stage.nRuns <= nPrevRuns || stage.nRuns >= m_nMaxRuns) {
+      throw BadArgument(_WHERE_, "The stages of a screening protocol must end "
+                                 "after an increasing number of runs, less "
+                                 "than the maximum number of runs");
+    }
+    nPrevRuns = stage.nRuns;
+  }
+  if (m_nMaxRuns == 0) {
+    throw BadArgument(_WHERE_, "A screening protocol needs at least one run");
+  }
+}
+
+std::size_t ScreeningProtocol::GetStageEnd(std::size_t iRun) const {
+  for (const Stage &stage : m_stages) {
+    if (stage.nRuns > iRun) {
+      return stage.nRuns;
+    }
+  }
+  return m_nMaxRuns;
+}
+
+bool ScreeningProtocol::Continue(std::size_t nRuns, double dBestScore) const {
+  if (nRuns >= m_nMaxRuns) {
+    return false;
+  }
+  for (const Stage &stage : m_stages) {
+    if (stage.nRuns == nRuns) {
+      return dBestScore <= stage.dThreshold;
+    }
+  }
+  return true;
+}
+
+double
+ScreeningProtocol::Simulate(const std::vector<std::vector<double>> &runScores,
+                            std::vector<double> &passFractions) const {
+  std::vector<std::size_t> nPassed(m_stages.size(), 0);
+  std::size_t nTotalRuns = 0;
+  for (const std::vector<double> &scores : runScores) {
+    std::size_t nRuns = m_nMaxRuns;
+    for (std::size_t iStage = 0; iStage < m_stages.size(); iStage++) {
+      if (GetBestScore(scores, m_stages[iStage].nRuns) >
+          m_stages[iStage].dThreshold) {
+        nRuns = m_stages[iStage].nRuns;
+        break;
+      }
+      nPassed[iStage]++;
+    }
+    nTotalRuns += nRuns;
+  }
+  passFractions.assign(m_stages.size(), 0.0);
+  if (runScores.empty()) {
+    return 0.0;
+  }
+  for (std::size_t iStage = 0; iStage < m_stages.size(); iStage++) {
+    passFractions[iStage] = static_cast<double>(nPassed[iStage]) /
+                            static_cast<double>(runScores.size());
+  }
+  return static_cast<double>(nTotalRuns) /
+         static_cast<double>(runScores.size());
+}
+
+ScreeningProtocol
+ScreeningProtocol::Calibrate(const std::vector<std::vector<double>> &runScores,
+                             const std::vector<std::size_t> &stageRuns,
+                             const std::vector<double> &keepFractions,
+                             std::size_t nMaxRuns,
+                             const std::string &strScoreName) {
+  if (runScores.empty()) {
+    throw BadArgument(_WHERE_, "No ligands to calibrate the screening "
+                               "protocol with");
+  }
+  if (stageRuns.size() != keepFractions.size()) {
+    throw BadArgument(_WHERE_, "Each screening stage needs a fraction of "
+                               "ligands to keep");
+  }
+  // The ligands that passed all the stages so far
+  std::vector<const std::vector<double> *> passed;
+  for (const std::vector<double> &scores : runScores) {
+    passed.push_back(&scores);
+  }
+  std::vector<Stage> stages;
+  double dPrevFraction = 1.0;
+  for (std::size_t iStage = 0; iStage < stageRuns.size(); iStage++) {
+    double dFraction = keepFractions[iStage];
+    if (!(dFraction > 0.0 && dFraction <= dPrevFraction)) {
+      throw BadArgument(_WHERE_, "The fractions of ligands kept by the "
+                                 "screening stages must be in (0, 1] and "
+                                 "non-increasing");
+    }
+    dPrevFraction = dFraction;
+    std::size_t nRuns = stageRuns[iStage];
+    std::vector<double> bestScores;
+    for (const std::vector<double> *pScores : passed) {
+      bestScores.push_back(GetBestScore(*pScores, nRuns));
+    }
+    std::sort(bestScores.begin(), bestScores.end());
+    // The threshold lets through the best nKeep ligands, and any ligand with
+    // the same score as the last of them. It is set halfway to the next
+    // score, as the scores in SD files are rounded
+    std::size_t nKeep = static_cast<std::size_t>(
+        std::ceil(dFraction * static_cast<double>(runScores.size())));
+    nKeep = std::max<std::size_t>(1, std::min(nKeep, bestScores.size()));
+    std::vector<double>::const_iterator nextIter = std::upper_bound(
+        bestScores.begin(), bestScores.end(), bestScores[nKeep - 1]);
+    Stage stage;
+    stage.nRuns = nRuns;
+    stage.dThreshold = (nextIter == bestScores.end())
+                           ? bestScores[nKeep - 1]
+                           : (bestScores[nKeep - 1] + *nextIter) / 2.0;
+    stages.push_back(stage);
+    passed.erase(std::remove_if(passed.begin(), passed.end(),
+                                [&](const std::vector<double> *pScores) {
+                                  return GetBestScore(*pScores, nRuns) >
+                                         stage.dThreshold;
+                                }),
+                 passed.end());
+  }
+  return ScreeningProtocol(stages, nMaxRuns, strScoreName);
+}
+
+std::ostream &rxdock::operator<<(std::ostream &s, const ScreeningProtocol &p) {
+  for (std::size_t iStage = 0; iStage < p.m_stages.size(); iStage++) {
+    s << fmt::format("Stage {}: {} run(s), continue if {} <= {}", iStage + 1,
+                     p.m_stages[iStage].nRuns, p.m_strScoreName,
+                     p.m_stages[iStage].dThreshold)
+      << std::endl;
+  }
+  s << fmt::format("Stage {}: up to {} run(s)", p.m_stages.size() + 1,
+                   p.m_nMaxRuns)
+    << std::endl;
+  return s;
+}
+
+void rxdock::to_json(json &j, const ScreeningProtocol &p) {
+  json stages = json::array();
+  for (const ScreeningProtocol::Stage &stage : p.m_stages) {
+    stages.push_back(
+        json{{"runs", stage.nRuns}, {"threshold", stage.dThreshold}});
+  }
+  j = json{{"score", p.m_strScoreName},
+           {"stages", stages},
+           {"max-runs", p.m_nMaxRuns}};
+}
+
+void rxdock::from_json(const json &j, ScreeningProtocol &p) {
+  p.m_stages.clear();
+  for (const auto &stage : j.at("stages")) {
+    ScreeningProtocol::Stage s;
+    s.nRuns = stage.at("runs").get<std::size_t>();
+    s.dThreshold = stage.at("threshold").get<double>();
+    p.m_stages.push_back(s);
+  }
+  p.m_nMaxRuns = j.at("max-runs").get<std::size_t>();
+  p.m_strScoreName = j.at("score").get<std::string>();
+}
@@ -47,6 +47,16 @@ void SetupPMFSF::SetupScore() {}
 
 double SetupPMFSF::RawScore() const { return 0.0; }
 
+// The receptor PMF types are set on the receptor model itself, so a clone
+// only needs the list of typed receptor atoms
+void SetupPMFSF::ShareReceptorData(BaseSF *pClone) const {
+  SetupPMFSF *pSetupClone = dynamic_cast<SetupPMFSF *>(pClone);
+  if (pSetupClone && !GetReceptor().Null()) {
+    pSetupClone->theReceptorList = theReceptorList;
+    ShareReceptor(pSetupClone);
+  }
+}
+
 void SetupPMFSF::SetupLigand() {
   theLigandList.clear();
   if (GetLigand().Null()) {
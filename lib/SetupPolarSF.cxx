@@ -55,6 +55,15 @@ void SetupPolarSF::SetupReceptor() {
   SetupAtomList(atomList, heavyAtomList);
 }
 
+// The receptor atom properties are set on the receptor model itself, so a
+// clone only needs to know the receptor has already been set up
+void SetupPolarSF::ShareReceptorData(BaseSF *pClone) const {
+  SetupPolarSF *pSetupClone = dynamic_cast<SetupPolarSF *>(pClone);
+  if (pSetupClone && !GetReceptor().Null()) {
+    ShareReceptor(pSetupClone);
+  }
+}
+
 void SetupPolarSF::SetupLigand() {
   if (GetLigand().Null())
     return;
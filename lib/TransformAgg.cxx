@@ -88,6 +88,17 @@ BaseTransform *TransformAgg::GetTransform(unsigned int iTransform) const {
   }
 }
 
+// Aggregate version clones all children
+TransformAgg *TransformAgg::Clone() const {
+  TransformAgg *pClone = new TransformAgg(GetName());
+  pClone->CopyParameters(*this);
+  for (BaseTransformListConstIter iter = m_transforms.begin();
+       iter != m_transforms.end(); iter++) {
+    pClone->Add((*iter)->Clone());
+  }
+  return pClone;
+}
+
 // WorkSpace handling methods
 // Register scoring function with a workspace
 // Aggregate version registers all children, but NOT itself
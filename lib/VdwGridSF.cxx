@@ -72,6 +72,15 @@ void VdwGridSF::SetupReceptor() {
   ReadGrids(vdwGrids.at("vdw-grids"));
 }
 
+// Shares the receptor grids with a clone
+void VdwGridSF::ShareReceptorData(BaseSF *pClone) const {
+  VdwGridSF *pVdwClone = dynamic_cast<VdwGridSF *>(pClone);
+  if (pVdwClone && !GetReceptor().Null()) {
+    pVdwClone->m_grids = m_grids;
+    ShareReceptor(pVdwClone);
+  }
+}
+
 void VdwGridSF::SetupLigand() {
   m_ligAtomList.clear();
   m_ligAtomTypes.clear();
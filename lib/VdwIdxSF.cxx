@@ -188,6 +188,18 @@ void VdwIdxSF::SetupReceptor() {
   }
 }
 
+// Shares the rigid receptor atom lists and indexing grid with a clone
+void VdwIdxSF::ShareReceptorData(BaseSF *pClone) const {
+  VdwIdxSF *pVdwClone = dynamic_cast<VdwIdxSF *>(pClone);
+  if (pVdwClone && !GetReceptor().Null() && !m_bFlexRec) {
+    pVdwClone->m_spGrid = m_spGrid;
+    pVdwClone->m_recAtomList = m_recAtomList;
+    pVdwClone->m_recRigidAtomList = m_recRigidAtomList;
+    pVdwClone->m_bFlexRec = false;
+    ShareReceptor(pVdwClone);
+  }
+}
+
 void VdwIdxSF::SetupLigand() {
   m_ligAtomList.clear();
   if (GetLigand().Null())
@@ -16,6 +16,8 @@
 
 #include <loguru.hpp>
 
+#include <algorithm>
+
 using namespace rxdock;
 
 // Static data members
@@ -114,6 +116,34 @@ void WorkSpace::RemoveModels(unsigned int iModel) {
   Notify();
 }
 
+// Returns the coordinates of the models that move during docking
+std::vector<CoordList> WorkSpace::GetMobileCoords() const {
+  std::vector<CoordList> coords(m_models.size());
+  for (unsigned int iModel = 0; iModel < m_models.size(); iModel++) {
+    ModelPtr spModel = m_models[iModel];
+    if (spModel.Ptr() && (iModel > 0 || spModel->isFlexible())) {
+      coords[iModel] = GetCoordList(spModel->GetAtomList());
+    }
+  }
+  return coords;
+}
+
+// Restores the coordinates returned by GetMobileCoords
+void WorkSpace::SetMobileCoords(const std::vector<CoordList> &coords) {
+  std::size_t nModels = std::min(m_models.size(), coords.size());
+  for (std::size_t iModel = 0; iModel < nModels; iModel++) {
+    ModelPtr spModel = m_models[iModel];
+    if (spModel.Null() || coords[iModel].empty()) {
+      continue;
+    }
+    AtomList atomList = spModel->GetAtomList();
+    for (std::size_t iAtom = 0; iAtom < atomList.size(); iAtom++) {
+      atomList[iAtom]->SetCoords(coords[iModel][iAtom]);
+    }
+    spModel->UpdatePseudoAtoms();
+  }
+}
+
 // Model I/O
 // Get/set the molecular file sink (for outputting ligands)
 MolecularFileSinkPtr WorkSpace::GetSink() const { return m_spSink; }
@@ -162,10 +192,26 @@ void WorkSpace::SetTransform(BaseTransform *pTransform) {
   }
 }
 
+// Get/Set the random number generator
+RandPtr WorkSpace::GetRand() const { return m_spRand; }
+
+void WorkSpace::SetRand(RandPtr spRand) { m_spRand = spRand; }
+
 // Run the simulation!
 void WorkSpace::Run() {
   if (m_transform) {
-    m_transform->Go();
+    if (m_spRand.Null()) {
+      m_transform->Go();
+    } else {
+      Rand *pPrevious = SetRandInstance(m_spRand);
+      try {
+        m_transform->Go();
+      } catch (...) {
+        SetRandInstance(pPrevious);
+        throw;
+      }
+      SetRandInstance(pPrevious);
+    }
   }
 }
 
@@ -179,6 +225,15 @@ PopulationPtr WorkSpace::GetPopulation() const { return m_population; }
 
 void WorkSpace::ClearPopulation() { m_population.SetNull(); }
 
+// Scoring replica handling
+void WorkSpace::SetScoringReplicas(const std::vector<WorkSpace *> &replicas) {
+  m_scoringReplicas = replicas;
+}
+
+std::vector<WorkSpace *> WorkSpace::GetScoringReplicas() const {
+  return m_scoringReplicas;
+}
+
 // Docking site handling
 // DM 09 Apr 2002 - workspace now manages the docking site
 DockingSitePtr WorkSpace::GetDockingSite() const { return m_spDockSite; }
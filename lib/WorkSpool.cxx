@@ -0,0 +1,339 @@
+//===-- WorkSpool.cxx - Filesystem lease-based work queue -------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+
+#include "rxdock/WorkSpool.h"
+#include "rxdock/Error.h"
+#include "rxdock/FileError.h"
+
+#include <fmt/format.h>
+#include <nlohmann/json.hpp>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#include <sys/utime.h>
+#define getpid _getpid
+#define mkdir(dirName, mode) _mkdir(dirName)
+#define utime _utime
+#else
+#include <unistd.h> // For POSIX gethostname and getpid
+#include <utime.h>
+#endif
+
+using json = nlohmann::json;
+
+using namespace rxdock;
+
+// Identifies this process in the leases it writes
+static std::string GetWorkerId() {
+  std::string strHost;
+#ifdef _WIN32
+  const char *szHost = std::getenv("COMPUTERNAME");
+  if (szHost) {
+    strHost = szHost;
+  }
+#else
+  char szHost[256] = {0};
+  if (gethostname(szHost, sizeof(szHost) - 1) == 0) {
+    strHost = szHost;
+  }
+#endif
+  return fmt::format("{}:{}", strHost, getpid());
+}
+
+static bool FileExists(const std::string &fileName) {
+  struct stat fileStat;
+  return stat(fileName.c_str(), &fileStat) == 0;
+}
+
+// Seconds since the file was last modified, negative if it does not exist
+static double GetFileAge(const std::string &fileName) {
+  struct stat fileStat;
+  if (stat(fileName.c_str(), &fileStat) != 0) {
+    return -1.0;
+  }
+  return std::difftime(std::time(nullptr), fileStat.st_mtime);
+}
+
+static std::string ReadFile(const std::string &fileName) {
+  std::ifstream fileIn(fileName.c_str());
+  std::ostringstream ostr;
+  ostr << fileIn.rdbuf();
+  return ostr.str();
+}
+
+WorkSpool::WorkSpool(const std::string &dirName, const std::string &strJob,
+                     std::size_t nChunks, double dLeaseTimeout)
+    : m_strDirName(dirName), m_strWorkerId(GetWorkerId()), m_nChunks(0),
+      m_dLeaseTimeout(dLeaseTimeout), m_bHasChunk(false), m_iChunk(0),
+      m_bStopRenewing(false), m_bLeaseLost(false) {
+  if (mkdir(m_strDirName.c_str(), 0777) != 0 && errno != EEXIST) {
+    throw FileWriteError(_WHERE_, "Error creating " + m_strDirName);
+  }
+  // The first process to get here defines the chunks, the others read them
+  std::string strSpoolFile = m_strDirName + "/spool.json";
+  std::FILE *spoolFile = std::fopen(strSpoolFile.c_str(), "wx");
+  if (spoolFile) {
+    json spool;
+    spool["spool"]["job"] = strJob;
+    spool["spool"]["chunks"] = nChunks;
+    std::string strSpool = spool.dump();
+    bool bOK = std::fputs(strSpool.c_str(), spoolFile) >= 0;
+    bOK = (std::fclose(spoolFile) == 0) && bOK;
+    if (!bOK) {
+      throw FileWriteError(_WHERE_, "Error writing " + strSpoolFile);
+    }
+    m_nChunks = nChunks;
+  } else {
+    // The file may still be being written by the process that created it
+    json spool;
+    for (int iTry = 0; spool.is_null(); iTry++) {
+      try {
+        spool = json::parse(ReadFile(strSpoolFile));
+      } catch (json::exception &) {
+        if (iTry == 50) {
+          throw FileReadError(_WHERE_, "Error reading " + strSpoolFile);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+    }
+    if (spool.at("spool").at("job").get<std::string>() != strJob) {
+      throw BadArgument(_WHERE_,
+                        "Spool " + m_strDirName + " is for a different job");
+    }
+    m_nChunks = spool.at("spool").at("chunks").get<std::size_t>();
+    if (m_nChunks != nChunks) {
+      throw BadArgument(_WHERE_, fmt::format("Spool {} is split into {} "
+                                             "chunks, not {}",
+                                             m_strDirName, m_nChunks,
+                                             nChunks));
+    }
+  }
+}
+
+WorkSpool::~WorkSpool() {
+  if (m_bHasChunk) {
+    Release();
+  }
+}
+
+std::string WorkSpool::GetChunkFileName(std::size_t iChunk,
+                                        const std::string &suffix) const {
+  return fmt::format("{}/chunk-{}{}", m_strDirName, iChunk, suffix);
+}
+
+bool WorkSpool::Claim(std::size_t &iChunk) {
+  if (m_bHasChunk) {
+    throw InvalidRequest(_WHERE_, "A chunk is already claimed");
+  }
+  while (true) {
+    bool bPending = false;
+    for (std::size_t i = 0; i < m_nChunks; i++) {
+      if (FileExists(GetChunkFileName(i, ".done"))) {
+        continue;
+      }
+      if (TryClaim(i)) {
+        m_bHasChunk = true;
+        m_iChunk = i;
+        iChunk = i;
+        StartRenewing(i);
+        return true;
+      }
+      bPending = true;
+    }
+    if (!bPending) {
+      return false;
+    }
+    // Wait for the other processes to finish their chunks, or to die
+    std::this_thread::sleep_for(
+        std::chrono::duration<double>(m_dLeaseTimeout / 4.0));
+  }
+}
+
+void WorkSpool::SetLeaseLost(LeaseLostFunction leaseLost) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_leaseLost = leaseLost;
+}
+
+bool WorkSpool::Complete() {
+  StopRenewing();
+  m_bHasChunk = false;
+  std::string strLeaseFile = GetChunkFileName(m_iChunk, ".lease");
+  if (m_bLeaseLost || !OwnsLease(strLeaseFile)) {
+    m_bLeaseLost = true;
+    return false;
+  }
+  std::string strDoneFile = GetChunkFileName(m_iChunk, ".done");
+  if (std::rename(strLeaseFile.c_str(), strDoneFile.c_str()) != 0) {
+    throw FileWriteError(_WHERE_, "Error renaming " + strLeaseFile);
+  }
+  return true;
+}
+
+void WorkSpool::Release() {
+  StopRenewing();
+  m_bHasChunk = false;
+  std::string strLeaseFile = GetChunkFileName(m_iChunk, ".lease");
+  if (!m_bLeaseLost && OwnsLease(strLeaseFile)) {
+    std::remove(strLeaseFile.c_str());
+  }
+}
+
+bool WorkSpool::TryClaim(std::size_t iChunk) {
+  std::string strLeaseFile = GetChunkFileName(iChunk, ".lease");
+  if (!WriteLease(strLeaseFile, false)) {
+    if (GetFileAge(strLeaseFile) <= m_dLeaseTimeout) {
+      return false; // Leased by a live process, or just released
+    }
+    if (!ReclaimExpired(iChunk)) {
+      return false;
+    }
+    fmt::print("Reclaiming chunk {} from an expired lease\n", iChunk);
+  }
+  // The chunk may have been completed since it was checked
+  if (FileExists(GetChunkFileName(iChunk, ".done"))) {
+    if (OwnsLease(strLeaseFile)) {
+      std::remove(strLeaseFile.c_str());
+    }
+    return false;
+  }
+  return true;
+}
+
+// Replaces the expired lease of a chunk with a lease of this process. The
+// lease is never moved away, so a live process renewing it always finds it,
+// with the contents of whichever process owns it
+bool WorkSpool::ReclaimExpired(std::size_t iChunk) {
+  // Only one process at a time reclaims the chunk. A reclaim file left by a
+  // process that died while reclaiming is removed once it has expired too,
+  // and the chunk is reclaimed on the next round
+  std::string strReclaimFile = GetChunkFileName(iChunk, ".reclaim");
+  std::FILE *reclaimFile = std::fopen(strReclaimFile.c_str(), "wx");
+  if (!reclaimFile) {
+    if (errno != EEXIST) {
+      throw FileWriteError(_WHERE_, "Error creating " + strReclaimFile);
+    }
+    if (GetFileAge(strReclaimFile) > m_dLeaseTimeout) {
+      std::remove(strReclaimFile.c_str());
+    }
+    return false;
+  }
+  std::fclose(reclaimFile);
+  // The lease may have been renewed, reclaimed or released since its age was
+  // checked
+  bool bReclaimed = false;
+  try {
+    std::string strLeaseFile = GetChunkFileName(iChunk, ".lease");
+    bReclaimed = GetFileAge(strLeaseFile) > m_dLeaseTimeout &&
+                 WriteLease(strLeaseFile, true);
+  } catch (...) {
+    std::remove(strReclaimFile.c_str());
+    throw;
+  }
+  std::remove(strReclaimFile.c_str());
+  return bReclaimed;
+}
+
+// Writes the lease of this process to strLeaseFile. Without bReplace the
+// lease is created exclusively, and false is returned if it already exists.
+// With bReplace it is written to a temporary file that is then renamed over
+// the existing lease
+bool WorkSpool::WriteLease(const std::string &strLeaseFile, bool bReplace) {
+  std::string strTmpFile = strLeaseFile;
+  if (bReplace) {
+    std::string strWorker = m_strWorkerId;
+    std::replace(strWorker.begin(), strWorker.end(), ':', '_');
+    strTmpFile += "." + strWorker + ".tmp";
+  }
+  std::FILE *leaseFile = std::fopen(strTmpFile.c_str(), bReplace ? "w" : "wx");
+  if (!leaseFile) {
+    if (bReplace || errno != EEXIST) {
+      throw FileWriteError(_WHERE_, "Error creating " + strTmpFile);
+    }
+    return false;
+  }
+  bool bOK = std::fputs(m_strWorkerId.c_str(), leaseFile) >= 0;
+  bOK = (std::fclose(leaseFile) == 0) && bOK;
+  if (!bOK) {
+    std::remove(strTmpFile.c_str());
+    throw FileWriteError(_WHERE_, "Error writing " + strTmpFile);
+  }
+  if (bReplace) {
+#ifdef _WIN32
+    // Windows does not rename over an existing file
+    std::remove(strLeaseFile.c_str());
+#endif
+    if (std::rename(strTmpFile.c_str(), strLeaseFile.c_str()) != 0) {
+      std::remove(strTmpFile.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+bool WorkSpool::OwnsLease(const std::string &strLeaseFile) const {
+  return ReadFile(strLeaseFile) == m_strWorkerId;
+}
+
+void WorkSpool::StartRenewing(std::size_t iChunk) {
+  m_bStopRenewing = false;
+  m_bLeaseLost = false;
+  m_renewThread = std::thread(&WorkSpool::RenewLoop, this,
+                              GetChunkFileName(iChunk, ".lease"));
+}
+
+void WorkSpool::StopRenewing() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bStopRenewing = true;
+  }
+  m_stopRenewing.notify_all();
+  if (m_renewThread.joinable()) {
+    m_renewThread.join();
+  }
+}
+
+void WorkSpool::RenewLoop(std::string strLeaseFile) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while (!m_stopRenewing.wait_for(
+      lock, std::chrono::duration<double>(m_dLeaseTimeout / 4.0),
+      [this] { return m_bStopRenewing; })) {
+    // Touching the lease can not create it, so a lease that was released is
+    // noticed here, and a lease that was reclaimed by its contents
+    if (utime(strLeaseFile.c_str(), nullptr) != 0 ||
+        !OwnsLease(strLeaseFile)) {
+      m_bLeaseLost = true;
+      break;
+    }
+  }
+  if (m_bLeaseLost) {
+    // Another process is now working on the chunk and writes the same
+    // output files, so the caller must stop working on it straight away
+    LeaseLostFunction leaseLost = m_leaseLost;
+    lock.unlock();
+    fmt::print("Lost the lease {} to another process\n", strLeaseFile);
+    if (leaseLost) {
+      leaseLost();
+    }
+  }
+}
@@ -0,0 +1,96 @@
+//===-- CalibrateScreening.cxx - Calibrate screening operation --*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Calibrate screening operation.
+///
+//===----------------------------------------------------------------------===//
+
+#include "rxdock/operation/CalibrateScreening.h"
+#include "rxdock/FileError.h"
+#include "rxdock/MdlFileSource.h"
+#include "rxdock/ScreeningProtocol.h"
+
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include <fstream>
+
+int rxdock::operation::calibrateScreening(std::string inputSDFile,
+                                          std::string outputFile,
+                                          std::vector<std::size_t> stageRuns,
+                                          std::vector<double> keepFractions,
+                                          std::size_t nMaxRuns,
+                                          std::string scoreName) {
+  try {
+    // Collect the run scores of each training ligand
+    std::string strScoreField = GetMetaDataPrefix() + scoreName;
+    std::vector<std::vector<double>> runScores;
+    std::string strPrevTitle;
+    std::size_t nUnscored = 0;
+    MolecularFileSourcePtr fileSource(new MdlFileSource(inputSDFile));
+    for (; fileSource->FileStatusOK(); fileSource->NextRecord()) {
+      if (!fileSource->isDataFieldPresent(strScoreField)) {
+        nUnscored++;
+        continue;
+      }
+      std::vector<std::string> titleList = fileSource->GetTitleList();
+      std::string strTitle = titleList.empty() ? "" : titleList.front();
+      if (runScores.empty() || strTitle != strPrevTitle) {
+        runScores.push_back(std::vector<double>());
+        strPrevTitle = strTitle;
+      }
+      runScores.back().push_back(
+          fileSource->GetDataValue(strScoreField).GetDouble());
+    }
+    if (nUnscored > 0) {
+      fmt::print("Skipped {} record(s) without {}\n", nUnscored,
+                 strScoreField);
+    }
+    std::size_t nTotalRuns = 0;
+    for (const std::vector<double> &scores : runScores) {
+      nTotalRuns += scores.size();
+    }
+    fmt::print("Training ligands: {} ({} run(s))\n", runScores.size(),
+               nTotalRuns);
+
+    ScreeningProtocol protocol = ScreeningProtocol::Calibrate(
+        runScores, stageRuns, keepFractions, nMaxRuns, scoreName);
+    fmt::print("{}", protocol);
+
+    // The cost is relative to docking every ligand nMaxRuns times
+    std::vector<double> passFractions;
+    double dMeanRuns = protocol.Simulate(runScores, passFractions);
+    for (std::size_t iStage = 0; iStage < passFractions.size(); iStage++) {
+      fmt::print("Stage {} passed by {:.1f}% of the training ligands\n",
+                 iStage + 1, 100.0 * passFractions[iStage]);
+    }
+    fmt::print("Simulated runs per ligand: {:.2f} ({:.1f}% of {} runs per "
+               "ligand)\n",
+               dMeanRuns, 100.0 * dMeanRuns / static_cast<double>(nMaxRuns),
+               nMaxRuns);
+
+    json protocolData;
+    protocolData["screening-protocol"] = protocol;
+    std::ofstream ostr(outputFile.c_str());
+    ostr << protocolData.dump(2) << std::endl;
+    ostr.close();
+    if (!ostr) {
+      throw FileWriteError(_WHERE_, "Error writing " + outputFile);
+    }
+  } catch (Error &e) {
+    fmt::print("{}\n", e.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -16,442 +16,3074 @@
 //===----------------------------------------------------------------------===//
 
 #include "rxdock/operation/Dock.h"
+#include "rxdock/AsyncFileWriter.h"
 #include "rxdock/BiMolWorkSpace.h"
 #include "rxdock/CrdFileSink.h"
 #include "rxdock/DockingError.h"
 #include "rxdock/Error.h"
+#include "rxdock/FileError.h"
 #include "rxdock/LigandError.h"
 #include "rxdock/MdlFileSink.h"
 #include "rxdock/MdlFileSource.h"
+#include "rxdock/PMFGridSF.h"
 #include "rxdock/PRMFactory.h"
 #include "rxdock/ParameterFileSource.h"
+#include "rxdock/ResultCache.h"
 #include "rxdock/SFFactory.h"
+#include "rxdock/ScreeningProtocol.h"
 #include "rxdock/TransformFactory.h"
+#include "rxdock/VdwGridSF.h"
+#include "rxdock/WorkSpool.h"
+#include "rxdock/support/Hash.h"
+#include "rxdock/support/Numa.h"
 
 #include <fmt/chrono.h>
 #include <fmt/format.h>
 #include <fmt/ostream.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
 #include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#ifndef _WIN32
+#include <csignal>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 namespace rxdock {
 namespace operation {
+namespace {
 
-static const std::string _ROOT_SF = "rxdock.score";
-static const std::string _RESTRAINT_SF = "restr";
-static const std::string _ROOT_TRANSFORM = "dock";
+const std::string _ROOT_SF = "rxdock.score";
+const std::string _RESTRAINT_SF = "restr";
+const std::string _ROOT_TRANSFORM = "dock";
 
-} // namespace operation
-} // namespace rxdock
+// Everything needed to dock ligands independently of any other docking
+// thread: a workspace with its own scoring function and transform trees,
+// termination filter, random number generator and ligand source. Only the
+// docking site, the output sink and read-only receptor data are shared
+struct DockingContext {
+  ParameterFileSourcePtr spParamSource;
+  ParameterFileSourcePtr spRecepPrmSource;
+  MolecularFileSourcePtr spLigandSource;
+  RandPtr spRand;
+  BiMolWorkSpacePtr spWS;
+  SFAggPtr spSF;
+  TransformAggPtr spTransform;
+  FilterPtr spFilter;
+  // Coordinates of the models that move during docking, as loaded. Each run
+  // starts from these coordinates
+  std::vector<CoordList> startCoords;
+  // Contexts whose workspaces are the scoring replicas of the workspace
+  std::vector<SmartPtr<DockingContext>> scoringReplicas;
+  // NUMA node whose replica of the receptor data the context uses
+  std::size_t iNode = 0;
+};
 
-int rxdock::operation::dock(
-    std::string strLigandMdlFile, std::string strOutputMdlFile, bool bOutputCrd,
-    std::string strOutputCrdFile, bool bOutputHistory,
-    std::string strOutputHistoryFilePrefix, std::string strReceptorPrmFile,
-    std::string strParamFile, bool bFilter, std::string strFilterFile,
-    bool bDockingRuns, std::size_t nDockingRuns, bool bPosIonise,
-    bool bNegIonise, bool bExplH, bool bTarget, double dTargetScore,
-    bool bContinue, bool bSeed, std::size_t nSeed) {
-  try {
-    // Create a bimolecular workspace
-    BiMolWorkSpacePtr spWS(new BiMolWorkSpace());
-    // Set the workspace name to the root of the receptor .prm filename
-    std::vector<std::string> componentList =
-        ConvertDelimitedStringToList(strReceptorPrmFile, ".");
-    std::string wsName = componentList.front();
-    spWS->SetName(wsName);
-
-    // Read the docking protocol parameter file
-    ParameterFileSourcePtr spParamSource(
-        new ParameterFileSource(GetDataFileName("data/scripts", strParamFile)));
-    // Read the receptor parameter file
-    ParameterFileSourcePtr spRecepPrmSource(new ParameterFileSource(
-        GetDataFileName("data/receptors", strReceptorPrmFile)));
-    fmt::print("Docking protocol: {} {}\n", spParamSource->GetFileName(),
-               spParamSource->GetTitle());
-    fmt::print("Receptor: {} {}\n", spRecepPrmSource->GetFileName(),
-               spRecepPrmSource->GetTitle());
-
-    // Create the scoring function from the rxdock.score section of the docking
-    // protocol prm file Format is: SECTION rxdock.score
-    //    inter    InterSF.prm
-    //    intra IntraSF.prm
-    // END_SECTION
-    //
-    // Notes:
-    // Section name must be rxdock.score. This is also the name of the root SF
-    // aggregate An aggregate is created for each parameter in the section.
-    // Parameter name becomes the name of the subaggregate (e.g.
-    // rxdock.score.inter) Parameter value is the file name for the subaggregate
-    // definition Default directory is $RBT_ROOT/data/sf
-    SFFactoryPtr spSFFactory(
-        new SFFactory());               // Factory class for scoring functions
-    SFAggPtr spSF(new SFAgg(_ROOT_SF)); // Root SF aggregate
-    spParamSource->SetSection(_ROOT_SF);
-    std::vector<std::string> sfList(spParamSource->GetParameterList());
-    // Loop over all parameters in the rxdock.score section
-    for (std::vector<std::string>::const_iterator sfIter = sfList.begin();
-         sfIter != sfList.end(); sfIter++) {
-      // sfFile = file name for scoring function subaggregate
-      std::string sfFile(GetDataFileName(
-          "data/sf", spParamSource->GetParameterValueAsString(*sfIter)));
-      ParameterFileSourcePtr spSFSource(new ParameterFileSource(sfFile));
-      // Create and add the subaggregate
-      spSF->Add(spSFFactory->CreateAggFromFile(spSFSource, *sfIter));
-    }
-
-    // Add the RESTRAINT subaggregate scoring function from any SF definitions
-    // in the receptor prm file
-    spSF->Add(spSFFactory->CreateAggFromFile(spRecepPrmSource, _RESTRAINT_SF));
-
-    // Create the docking transform aggregate from the transform definitions in
-    // the docking prm file
-    TransformFactoryPtr spTransformFactory(new TransformFactory());
-    spParamSource->SetSection();
-    TransformAggPtr spTransform(
-        spTransformFactory->CreateAggFromFile(spParamSource, _ROOT_TRANSFORM));
+// Creates a docking context from the docking protocol and receptor parameter
+// files. Everything in the context draws random numbers from the generator of
+// the context, which is left installed as the generator of the calling thread
+// and must be installed again by any thread that later uses the context. If
+// bVerbose is true, prints the details of the protocol and the receptor
+DockingContext CreateDockingContext(const std::string &wsName,
+                                    const std::string &strParamFile,
+                                    const std::string &strReceptorPrmFile,
+                                    DockingSitePtr spDS,
+                                    MolecularFileSinkPtr spSink,
+                                    FilterPtr spFilter, bool bVerbose) {
+  DockingContext context;
+  context.spRand = new Rand();
+  SetRandInstance(context.spRand);
+  // Create a bimolecular workspace
+  context.spWS = new BiMolWorkSpace();
+  context.spWS->SetName(wsName);
+  context.spWS->SetRand(context.spRand);
+
+  // Read the docking protocol parameter file
+  context.spParamSource =
+      new ParameterFileSource(GetDataFileName("data/scripts", strParamFile));
+  // Read the receptor parameter file
+  context.spRecepPrmSource = new ParameterFileSource(
+      GetDataFileName("data/receptors", strReceptorPrmFile));
+  // Getting the titles parses the files, which must happen before any section
+  // is selected as parsing resets the current section
+  std::string strParamTitle = context.spParamSource->GetTitle();
+  std::string strRecepPrmTitle = context.spRecepPrmSource->GetTitle();
+  if (bVerbose) {
+    fmt::print("Docking protocol: {} {}\n",
+               context.spParamSource->GetFileName(), strParamTitle);
+    fmt::print("Receptor: {} {}\n", context.spRecepPrmSource->GetFileName(),
+               strRecepPrmTitle);
+  }
+
+  // Create the scoring function from the rxdock.score section of the docking
+  // protocol prm file Format is: SECTION rxdock.score
+  //    inter    InterSF.prm
+  //    intra IntraSF.prm
+  // END_SECTION
+  //
+  // Notes:
+  // Section name must be rxdock.score. This is also the name of the root SF
+  // aggregate An aggregate is created for each parameter in the section.
+  // Parameter name becomes the name of the subaggregate (e.g.
+  // rxdock.score.inter) Parameter value is the file name for the subaggregate
+  // definition Default directory is $RBT_ROOT/data/sf
+  SFFactoryPtr spSFFactory(
+      new SFFactory()); // Factory class for scoring functions
+  context.spSF = new SFAgg(_ROOT_SF); // Root SF aggregate
+  context.spParamSource->SetSection(_ROOT_SF);
+  std::vector<std::string> sfList(context.spParamSource->GetParameterList());
+  // Loop over all parameters in the rxdock.score section
+  for (std::vector<std::string>::const_iterator sfIter = sfList.begin();
+       sfIter != sfList.end(); sfIter++) {
+    // sfFile = file name for scoring function subaggregate
+    std::string sfFile(GetDataFileName(
+        "data/sf", context.spParamSource->GetParameterValueAsString(*sfIter)));
+    ParameterFileSourcePtr spSFSource(new ParameterFileSource(sfFile));
+    // Create and add the subaggregate
+    context.spSF->Add(spSFFactory->CreateAggFromFile(spSFSource, *sfIter));
+  }
+
+  // Add the RESTRAINT subaggregate scoring function from any SF definitions
+  // in the receptor prm file
+  context.spSF->Add(spSFFactory->CreateAggFromFile(context.spRecepPrmSource,
+                                                   _RESTRAINT_SF));
 
+  // Create the docking transform aggregate from the transform definitions in
+  // the docking prm file
+  TransformFactoryPtr spTransformFactory(new TransformFactory());
+  context.spParamSource->SetSection();
+  context.spTransform = spTransformFactory->CreateAggFromFile(
+      context.spParamSource, _ROOT_TRANSFORM);
+
+  if (bVerbose) {
     // Print the scoring function and the transform details
-    fmt::print("Scoring function details: {}\n", *spSF);
-    fmt::print("Search details: {}\n", *spTransform);
-
-    // Register the scoring function and the transform with the workspace
-    spWS->SetSF(spSF);
-    spWS->SetTransform(spTransform);
-
-    // DM 18 May 1999
-    // Variants describing the library version, parameter file, and current
-    // directory will be stored in the ligand SD files
-    Variant vLib(GetProduct() + "/" + GetProgramVersion());
-    Variant vRecep(spRecepPrmSource->GetFileName());
-    Variant vPrm(spParamSource->GetFileName());
-    Variant vDir(GetCurrentWorkingDirectory());
-
-    spRecepPrmSource->SetSection();
-    // Read docking site from file and register with workspace
-    std::string strDockingSiteFile = spWS->GetName() + "-docking-site.json";
-    std::string strInputFile =
-        GetDataFileName("data/grids", strDockingSiteFile);
-    // DM 14 June 2006 - bug fix to one of the longest standing rDock issues
-    //(the cryptic "Error reading from input stream" message, if cavity file was
-    // missing)
-    // std::string message = "Cavity file (" + strDockingSiteFile +
-    //                       ") not found in current directory or $RBT_HOME";
-    // message += " - run rbcavity first";
-    // throw FileReadError(_WHERE_, message);
-    std::ifstream inputFile(strInputFile.c_str());
-    json siteData;
-    inputFile >> siteData;
-    inputFile.close();
-    DockingSitePtr spDS(new DockingSite(siteData.at("docking-site")));
-    spWS->SetDockingSite(spDS);
+    fmt::print("Scoring function details: {}\n", *context.spSF);
+    fmt::print("Search details: {}\n", *context.spTransform);
+  }
+
+  // Register the scoring function and the transform with the workspace
+  context.spWS->SetSF(context.spSF);
+  context.spWS->SetTransform(context.spTransform);
+
+  context.spRecepPrmSource->SetSection();
+  // Register the docking site with workspace
+  context.spWS->SetDockingSite(spDS);
+  if (bVerbose) {
     fmt::print("Docking site: {}\n", *spDS);
+  }
+
+  // Register the shared SD file sink for saving the docked conformations
+  context.spWS->SetSink(spSink);
 
-    // Prepare the SD file sink for saving the docked conformations for each
-    // ligand DM 3 Dec 1999 - replaced ostrstream with String in determining
-    // SD file name SRC 2014 moved here this block to allow WRITE_ERROR TRUE
-    MolecularFileSinkPtr spMdlFileSink(
-        new MdlFileSink(strOutputMdlFile, ModelPtr()));
-    spWS->SetSink(spMdlFileSink);
-
-    PRMFactory prmFactory(spRecepPrmSource, spDS);
-    // Create the receptor model from the file names in the receptor parameter
-    // file
-    ModelPtr spReceptor = prmFactory.CreateReceptor();
-    spWS->SetReceptor(spReceptor);
-
-    // Register any solvent
-    ModelList solventList = prmFactory.CreateSolvent();
-    spWS->SetSolvent(solventList);
-    if (spWS->hasSolvent()) {
-      int nSolvent = spWS->GetSolvent().size();
+  PRMFactory prmFactory(context.spRecepPrmSource, spDS);
+  // Create the receptor model from the file names in the receptor parameter
+  // file
+  context.spWS->SetReceptor(prmFactory.CreateReceptor());
+
+  // Register any solvent
+  ModelList solventList = prmFactory.CreateSolvent();
+  context.spWS->SetSolvent(solventList);
+  if (bVerbose) {
+    if (context.spWS->hasSolvent()) {
+      int nSolvent = context.spWS->GetSolvent().size();
       fmt::print("{} solvent molecules registered\n", nSolvent);
     } else {
       fmt::print("No solvent registered\n");
     }
+  }
+
+  // Register the Filter with the workspace
+  context.spFilter = spFilter;
+  context.spWS->SetFilter(context.spFilter);
+  return context;
+}
+
+// Creates a docking context with the same docking protocol and receptor as
+// the source context, without reading the docking protocol again. The
+// scoring function and transform trees are cloned, so that a rigid receptor
+// model and the receptor data derived from it (e.g. the indexing grids) are
+// shared with the source context rather than built again. A flexible or
+// multi-conformation receptor, or a receptor written to by the scoring
+// function, is created again from the receptor parameter file instead. As
+// for CreateDockingContext, the generator of the new context is left
+// installed as the generator of the calling thread
+DockingContext CloneDockingContext(DockingContext &source,
+                                   MolecularFileSinkPtr spSink,
+                                   FilterPtr spFilter) {
+  DockingContext context;
+  context.spRand = new Rand();
+  SetRandInstance(context.spRand);
+  context.spWS = new BiMolWorkSpace();
+  context.spWS->SetName(source.spWS->GetName());
+  context.spWS->SetRand(context.spRand);
+
+  // The docking protocol source is not used once the trees are created, but
+  // the receptor parameter source is used for creating each ligand
+  context.spParamSource = source.spParamSource;
+  context.spRecepPrmSource =
+      new ParameterFileSource(source.spRecepPrmSource->GetFileName());
 
-    // Seed the random number generator
-    Rand &theRand = GetRandInstance(); // ref to random number generator
-    if (bSeed) {
-      theRand.Seed(nSeed);
+  context.spSF = source.spSF->Clone();
+  context.spTransform = source.spTransform->Clone();
+  context.spWS->SetSF(context.spSF);
+  context.spWS->SetTransform(context.spTransform);
+
+  DockingSitePtr spDS = source.spWS->GetDockingSite();
+  context.spWS->SetDockingSite(spDS);
+  context.spWS->SetSink(spSink);
+
+  PRMFactory prmFactory(context.spRecepPrmSource, spDS);
+  ModelPtr spReceptor = source.spWS->GetReceptor();
+  if (spReceptor.Null() || spReceptor->isFlexible() ||
+      (spReceptor->GetNumSavedCoords() > 1) ||
+      !context.spSF->isReceptorReadOnly()) {
+    spReceptor = prmFactory.CreateReceptor();
+  }
+  context.spWS->SetReceptor(spReceptor);
+  // Solvent may be flexible, so each context has its own
+  context.spWS->SetSolvent(prmFactory.CreateSolvent());
+
+  context.spFilter = spFilter;
+  context.spWS->SetFilter(context.spFilter);
+  context.startCoords = context.spWS->GetMobileCoords();
+  return context;
+}
+
+// Copies the state of the models of one workspace (the docked ligand pose,
+// the positions of any flexible receptor atoms and solvent, and the model
+// data fields) to the equivalent models of another workspace created from the
+// same inputs
+void CopyModelState(WorkSpace *pFrom, WorkSpace *pTo) {
+  int nModels = pFrom->GetNumModels();
+  for (int iModel = 0; iModel < nModels; iModel++) {
+    ModelPtr spFrom = pFrom->GetModel(iModel);
+    ModelPtr spTo = pTo->GetModel(iModel);
+    // Shared models, such as a rigid receptor, are already in the same state
+    if (spFrom.Null() || spTo.Null() || (spFrom == spTo)) {
+      continue;
+    }
+    ChromElementPtr spFromChrom = spFrom->GetChrom();
+    ChromElementPtr spToChrom = spTo->GetChrom();
+    if (spFromChrom.Ptr() && spToChrom.Ptr() &&
+        (spFromChrom->GetLength() > 0)) {
+      spFromChrom->SyncFromModel();
+      std::vector<double> chromVec;
+      spFromChrom->GetVector(chromVec);
+      spToChrom->SetVector(chromVec);
+      spToChrom->SyncToModel();
+      spTo->UpdatePseudoAtoms();
+    }
+    spTo->ClearAllDataFields();
+    StringVariantMap dataMap = spFrom->GetDataMap();
+    for (StringVariantMapConstIter iter = dataMap.begin();
+         iter != dataMap.end(); ++iter) {
+      spTo->SetDataValue(iter->first, iter->second);
     }
+  }
+}
 
-    // BGD 26 Feb 2003 - Create filters to simulate old rbdock
-    // behaviour
-    std::ostringstream strFilter;
-    if (!bFilter) {
-      if (bTarget) // -t<TS>
-      {
-        fmt::print("Lower target intermolecular score = {}\n", dTargetScore);
-        if (!bDockingRuns) // -t<TS> only
-        {
-          strFilter << fmt::format("0 1 - {}score.inter ", GetMetaDataPrefix())
-                    << dTargetScore << std::endl;
-        } else             // -t<TS> -n<N> need to check if -cont present
-                           // for all other cases it doesn't matter
-            if (bContinue) // -t<TS> -n<N> -cont
-        {
-          strFilter << fmt::format("1 if - {}score.NRUNS ", GetMetaDataPrefix())
-                    << (nDockingRuns - 1)
-                    << fmt::format(" 0.0 -1.0,\n1 - {}score.inter ",
-                                   GetMetaDataPrefix())
-                    << dTargetScore << std::endl;
-        } else // -t<TS> -n<N>
-        {
-          strFilter << "1 if - " << dTargetScore
-                    << fmt::format(" {}score.inter 0.0 ", GetMetaDataPrefix())
-                    << fmt::format("if - {}score.NRUNS ", GetMetaDataPrefix())
-                    << (nDockingRuns - 1)
-                    << fmt::format(" 0.0 -1.0,\n1 - {}score.inter ",
-                                   GetMetaDataPrefix())
-                    << dTargetScore << std::endl;
-        }
-      }                      // no target score, no filter
-      else if (bDockingRuns) // -n<N>
-      {
-        strFilter << fmt::format("1 if - {}score.NRUNS ", GetMetaDataPrefix())
-                  << (nDockingRuns - 1) << " 0.0 -1.0,\n0";
-      } else // no -t no -n
-      {
-        strFilter << "0 0\n";
+// Returns the coordinates of the heavy atoms of a model
+CoordList GetHeavyAtomCoords(ModelPtr spModel) {
+  return GetCoordList(GetAtomListWithPredicate(spModel->GetAtomList(),
+                                               std::not1(isAtomicNo_eq(1))));
+}
+
+// Returns the RMSD between two poses of the same model, without looking for
+// symmetry equivalent atoms
+double GetRMSD(const CoordList &coords1, const CoordList &coords2) {
+  std::size_t nCoords = std::min(coords1.size(), coords2.size());
+  if (nCoords == 0) {
+    return 0.0;
+  }
+  double dSum = 0.0;
+  for (std::size_t i = 0; i < nCoords; i++) {
+    dSum += Length2(coords1[i], coords2[i]);
+  }
+  return std::sqrt(dSum / static_cast<double>(nCoords));
+}
+
+// Returns the predicted cost of docking the ligand of an SD record. The number
+// of scoring function evaluations of a run grows with the length of the
+// chromosome, which has six elements for the position and orientation and one
+// for each rotatable bond, and the cost of an evaluation with the number of
+// heavy atoms. Both are counted from the atom and bond blocks of the record
+// rather than from the ligand model, so that the cost can be predicted while
+// the input is locked: a rotatable bond is an acyclic single bond between two
+// heavy atoms that are each bonded to another heavy atom. Returns zero if the
+// blocks can not be read (the error is reported when docking the record)
+double GetDockingCost(const FileRecList &lineRecs) {
+  std::size_t nAtoms = 0;
+  std::size_t nBonds = 0;
+  std::vector<bool> heavyAtoms;
+  // Heavy atom bonds, with their bond orders, and the neighbours of each heavy
+  // atom, with the index of the bond to it
+  std::vector<std::pair<std::size_t, std::size_t>> bonds;
+  std::vector<int> bondOrders;
+  std::vector<std::vector<std::pair<std::size_t, std::size_t>>> neighbours;
+  try {
+    if (lineRecs.size() < 4) {
+      return 0.0;
+    }
+    nAtoms = std::stoul(lineRecs[3].substr(0, 3));
+    nBonds = std::stoul(lineRecs[3].substr(3, 3));
+    if (lineRecs.size() < 4 + nAtoms + nBonds) {
+      return 0.0;
+    }
+    for (std::size_t iAtom = 0; iAtom < nAtoms; iAtom++) {
+      const std::string &line = lineRecs[4 + iAtom];
+      std::string strElement = (line.size() > 31) ? line.substr(31, 3) : "";
+      strElement.erase(std::remove(strElement.begin(), strElement.end(), ' '),
+                       strElement.end());
+      heavyAtoms.push_back(!strElement.empty() && strElement != "H");
+    }
+    neighbours.resize(nAtoms);
+    for (std::size_t iBond = 0; iBond < nBonds; iBond++) {
+      const std::string &line = lineRecs[4 + nAtoms + iBond];
+      std::size_t iAtom1 = std::stoul(line.substr(0, 3)) - 1;
+      std::size_t iAtom2 = std::stoul(line.substr(3, 3)) - 1;
+      int nBondOrder = std::stoi(line.substr(6, 3));
+      if (iAtom1 >= nAtoms || iAtom2 >= nAtoms || !heavyAtoms[iAtom1] ||
+          !heavyAtoms[iAtom2]) {
+        continue;
       }
+      neighbours[iAtom1].push_back(std::make_pair(iAtom2, bonds.size()));
+      neighbours[iAtom2].push_back(std::make_pair(iAtom1, bonds.size()));
+      bonds.push_back(std::make_pair(iAtom1, iAtom2));
+      bondOrders.push_back(nBondOrder);
     }
+  } catch (const std::logic_error &) {
+    return 0.0;
+  }
 
-    // Create the filter object for controlling early termination of protocol
-    FilterPtr spfilter;
-    if (bFilter) {
-      spfilter = new Filter(strFilterFile);
-      if (bDockingRuns) {
-        spfilter->SetMaxNRuns(nDockingRuns);
+  // The acyclic bonds are the bridges of the heavy atom graph, found by a
+  // depth-first search: a bond to a child is a bridge if no descendant of the
+  // child has a back bond to the child's ancestors
+  std::vector<std::size_t> visitOrder(nAtoms, nAtoms);
+  std::vector<std::size_t> lowOrder(nAtoms, nAtoms);
+  std::vector<bool> bridges(bonds.size(), false);
+  std::size_t nVisited = 0;
+  std::function<void(std::size_t, std::size_t)> visit =
+      [&](std::size_t iAtom, std::size_t iParentBond) {
+        visitOrder[iAtom] = lowOrder[iAtom] = nVisited++;
+        for (const std::pair<std::size_t, std::size_t> &neighbour :
+             neighbours[iAtom]) {
+          if (neighbour.second == iParentBond) {
+            continue;
+          }
+          if (visitOrder[neighbour.first] == nAtoms) {
+            visit(neighbour.first, neighbour.second);
+            lowOrder[iAtom] =
+                std::min(lowOrder[iAtom], lowOrder[neighbour.first]);
+            bridges[neighbour.second] =
+                lowOrder[neighbour.first] > visitOrder[iAtom];
+          } else {
+            lowOrder[iAtom] =
+                std::min(lowOrder[iAtom], visitOrder[neighbour.first]);
+          }
+        }
+      };
+  std::size_t nHeavyAtoms = 0;
+  for (std::size_t iAtom = 0; iAtom < nAtoms; iAtom++) {
+    if (heavyAtoms[iAtom]) {
+      nHeavyAtoms++;
+      if (visitOrder[iAtom] == nAtoms) {
+        visit(iAtom, bonds.size());
       }
-    } else {
-      spfilter = new Filter(strFilter.str(), true);
     }
+  }
+  std::size_t nRotatableBonds = 0;
+  for (std::size_t iBond = 0; iBond < bonds.size(); iBond++) {
+    if (bridges[iBond] && bondOrders[iBond] == 1 &&
+        neighbours[bonds[iBond].first].size() > 1 &&
+        neighbours[bonds[iBond].second].size() > 1) {
+      nRotatableBonds++;
+    }
+  }
+  return static_cast<double>(nHeavyAtoms) *
+         static_cast<double>(6 + nRotatableBonds);
+}
+
+// Reads the docking site of the workspace from its docking site file
+DockingSitePtr ReadDockingSite(const std::string &wsName) {
+  std::string strDockingSiteFile = wsName + "-docking-site.json";
+  std::string strInputFile =
+      GetDataFileName("data/grids", strDockingSiteFile);
+  // DM 14 June 2006 - bug fix to one of the longest standing rDock issues
+  //(the cryptic "Error reading from input stream" message, if cavity file was
+  // missing)
+  // std::string message = "Cavity file (" + strDockingSiteFile +
+  //                       ") not found in current directory or $RBT_HOME";
+  // message += " - run rbcavity first";
+  // throw FileReadError(_WHERE_, message);
+  std::ifstream inputFile(strInputFile.c_str());
+  json siteData;
+  inputFile >> siteData;
+  inputFile.close();
+  DockingSitePtr spDS(new DockingSite(siteData.at("docking-site")));
+  // The docking site is shared by all docking threads, so make sure its
+  // distance grid exists before any of them starts using it
+  spDS->GetGrid();
+  return spDS;
+}
+
+std::string ReadFileText(const std::string &fileName) {
+  std::ifstream fileIn(fileName.c_str(), std::ios::binary);
+  if (!fileIn) {
+    throw FileReadError(_WHERE_, "Error opening " + fileName);
+  }
+  std::ostringstream ostr;
+  ostr << fileIn.rdbuf();
+  return ostr.str();
+}
+
+// Adds the parameters of a scoring function and of its children to strKey,
+// with the hashes of the grid files of the grid scoring functions
+void AddSFKey(const BaseSF *pSF, const std::string &wsName,
+              std::string &strKey) {
+  StringVariantMap params = pSF->GetParameters();
+  for (StringVariantMapConstIter iter = params.begin(); iter != params.end();
+       iter++) {
+    strKey += fmt::format("{}.{} = {}\n", pSF->GetFullName(), iter->first,
+                          iter->second.GetString());
+  }
+  // The grid scoring functions read their grids from wsName plus the suffix
+  // of their grid parameter
+  std::string strGridSuffix;
+  if (dynamic_cast<const VdwGridSF *>(pSF)) {
+    strGridSuffix = pSF->GetParameter(VdwGridSF::_GRID).GetString();
+  } else if (dynamic_cast<const PMFGridSF *>(pSF)) {
+    strGridSuffix = pSF->GetParameter(PMFGridSF::_GRID).GetString();
+  }
+  if (!strGridSuffix.empty()) {
+    std::string strGridFile =
+        GetDataFileName("data/grids", wsName + strGridSuffix);
+    strKey += fmt::format(
+        "{} grid: {}\n", pSF->GetFullName(),
+        support::formatHash(support::hashFNV1a(ReadFileText(strGridFile))));
+  }
+  for (unsigned int iSF = 0; iSF < pSF->GetNumSF(); iSF++) {
+    AddSFKey(pSF->GetSF(iSF), wsName, strKey);
+  }
+}
 
-    // Register the Filter with the workspace
-    spWS->SetFilter(spfilter);
+// Returns the key of what the poses docked with a context depend on, other
+// than the ligand: strOptions, the receptor and docking protocol parameter
+// files, the parameters of the scoring function as resolved from the files
+// it is built from, and the hashes of the grid files, of the receptor atoms
+// as loaded (which covers the structure files the receptor parameter file
+// refers to) and of the docking site
+std::string GetJobKey(DockingContext &context, DockingSitePtr spDS,
+                      const std::string &strOptions) {
+  std::string strKey = strOptions;
+  strKey += "receptor:\n" +
+            ReadFileText(context.spRecepPrmSource->GetFileName()) + "\n";
+  strKey +=
+      "protocol:\n" + ReadFileText(context.spParamSource->GetFileName()) +
+      "\n";
+  AddSFKey(context.spSF.Ptr(), context.spWS->GetName(), strKey);
+  std::uint64_t hash = support::fnv1aOffsetBasis;
+  AtomList atomList = context.spWS->GetReceptor()->GetAtomList();
+  for (AtomListConstIter iter = atomList.begin(); iter != atomList.end();
+       iter++) {
+    const Coord &c = (*iter)->GetCoords();
+    hash = support::hashFNV1a(
+        fmt::format("{} {} {} {} {} {}\n", (*iter)->GetFullAtomName(),
+                    (*iter)->GetFFType(), (*iter)->GetPartialCharge(),
+                    c.xyz(0), c.xyz(1), c.xyz(2)),
+        hash);
+  }
+  strKey += "receptor atoms: " + support::formatHash(hash) + "\n";
+  strKey += "docking site: " +
+            support::formatHash(support::hashFNV1a(json(*spDS).dump())) +
+            "\n";
+  return strKey;
+}
 
-    // MAIN LOOP OVER LIGAND RECORDS
-    // DM 20 Apr 1999 - set the auto-ionise flags
-    if (bPosIonise) {
-      fmt::print("Automatically protonating positive ionisable groups (amines, "
-                 "imidazoles, and guanidines)\n");
+// Returns the data fields of the lines of an SD record, as MdlFileSource
+// reads them, including the Name field it takes from the title if missing
+std::vector<std::pair<std::string, FileRecList>>
+GetInputDataFields(const FileRecList &lineRecs) {
+  std::vector<std::pair<std::string, FileRecList>> dataFields;
+  bool bName = false;
+  for (std::size_t iLine = 4; iLine < lineRecs.size(); iLine++) {
+    const std::string &line = lineRecs[iLine];
+    std::string::size_type ob = line.find('<');
+    std::string::size_type cb = line.rfind('>');
+    if (line.find('>') != 0 || ob == std::string::npos || cb <= ob) {
+      continue;
     }
-    if (bNegIonise) {
-      fmt::print(
-          "Automatically deprotonating negative ionisable groups (carboxylic "
-          "acids, phosphates, sulphates, and sulphonates)\n");
+    std::pair<std::string, FileRecList> dataField;
+    dataField.first = line.substr(ob + 1, cb - ob - 1);
+    while (++iLine < lineRecs.size() && !lineRecs[iLine].empty()) {
+      dataField.second.push_back(lineRecs[iLine]);
     }
-    if (!bExplH) {
-      fmt::print("Reading polar hydrogens only from ligand SD file\n");
-    } else {
-      fmt::print("Reading all hydrogens from ligand SD file\n");
+    bName = bName || dataField.first == "Name";
+    dataFields.push_back(dataField);
+  }
+  if (!bName && !lineRecs.empty()) {
+    dataFields.push_back(std::make_pair("Name", FileRecList(1, lineRecs[0])));
+  }
+  return dataFields;
+}
+
+// Returns the poses of the ligand of the record ligandLines as the poses of
+// another record with the same ligand: with the title and the input data
+// fields of the record instead of those of the ligand, followed by the data
+// fields of strExtraFields. The fields set by docking are kept
+std::string GetRecordPoses(const std::string &strPoses,
+                           const FileRecList &ligandLines,
+                           const FileRecList &recordLines,
+                           const std::string &strExtraFields) {
+  const std::string strPrefix = GetMetaDataPrefix();
+  auto isInputField = [&](const std::string &strName) {
+    return strName.compare(0, strPrefix.size(), strPrefix) != 0;
+  };
+  std::set<std::string> ligandFields;
+  for (const std::pair<std::string, FileRecList> &dataField :
+       GetInputDataFields(ligandLines)) {
+    if (isInputField(dataField.first)) {
+      ligandFields.insert(dataField.first);
     }
-    // DM 20 Apr 1999 - add explicit bPosIonise and bNegIonise flags to
-    // MdlFileSource constructor
-    MolecularFileSourcePtr spMdlFileSource(
-        new MdlFileSource(strLigandMdlFile, bPosIonise, bNegIonise, !bExplH));
-    std::chrono::duration<double> totalDuration(0.0);
-    std::size_t nFailedLigands = 0;
-    std::size_t nUnnamedLigands = 0;
-    std::chrono::system_clock::time_point loopBegin =
-        std::chrono::system_clock::now();
-    std::size_t nRec;
-    for (nRec = 0; spMdlFileSource->FileStatusOK();
-         spMdlFileSource->NextRecord(), nRec++) {
-      fmt::print("SDfile record #{}\n", nRec + 1);
-      Error molStatus = spMdlFileSource->Status();
-      if (!molStatus.isOK()) {
-        fmt::print("{}\n", molStatus.what());
+  }
+  std::string strRecordFields;
+  for (const std::pair<std::string, FileRecList> &dataField :
+       GetInputDataFields(recordLines)) {
+    if (isInputField(dataField.first)) {
+      strRecordFields += ">  <" + dataField.first + ">\n";
+      for (const std::string &value : dataField.second) {
+        strRecordFields += value + "\n";
+      }
+      strRecordFields += "\n";
+    }
+  }
+  strRecordFields += strExtraFields;
+
+  std::string strRecordPoses;
+  std::istringstream istr(strPoses);
+  std::string line;
+  std::size_t iLine = 0; // Line of the current pose
+  bool bSkipField = false;
+  while (std::getline(istr, line)) {
+    if (line == IDS_MDL_RECDELIM) {
+      strRecordPoses += strRecordFields + line + "\n";
+      iLine = 0;
+      bSkipField = false;
+      continue;
+    }
+    if (iLine++ == 0) {
+      line = recordLines.empty() ? "" : recordLines.front();
+    } else if (bSkipField) {
+      // The blank line ends the field
+      bSkipField = !line.empty();
+      continue;
+    } else if (iLine > 4 && line.find('>') == 0) {
+      std::string::size_type ob = line.find('<');
+      std::string::size_type cb = line.rfind('>');
+      if (ob != std::string::npos && cb > ob &&
+          ligandFields.count(line.substr(ob + 1, cb - ob - 1))) {
+        bSkipField = true;
         continue;
       }
+    }
+    strRecordPoses += line + "\n";
+  }
+  return strRecordPoses;
+}
 
-      auto startTime = std::chrono::high_resolution_clock::now();
-      bool bLigandError = false;
+// Returns the poses of the ligand of record iLigandRec as the poses of a
+// duplicate record of it, with the ligand record number in the duplicate_of
+// data field
+std::string GetDuplicatePoses(const std::string &strPoses,
+                              const FileRecList &ligandLines,
+                              const FileRecList &duplicateLines,
+                              std::size_t iLigandRec) {
+  return GetRecordPoses(
+      strPoses, ligandLines, duplicateLines,
+      fmt::format(">  <{}duplicate_of>\n{}\n\n", GetMetaDataPrefix(),
+                  iLigandRec + 1));
+}
 
-      // DM 26 Jul 1999 - only read the largest segment (guaranteed to be called
-      // H) BGD 07 Oct 2002 - catching errors created by the ligands, so rbdock
-      // continues with the next one, instead of completely stopping
-      try {
-        spMdlFileSource->SetSegmentFilterMap(ConvertStringToSegmentMap("H"));
+// Moves to nOffset of file, which may be beyond what a long can hold
+bool SeekFile(std::FILE *file, std::size_t nOffset) {
+#ifdef _WIN32
+  return _fseeki64(file, static_cast<__int64>(nOffset), SEEK_SET) == 0;
+#else
+  return fseeko(file, static_cast<off_t>(nOffset), SEEK_SET) == 0;
+#endif
+}
 
-        if (spMdlFileSource->isDataFieldPresent("Name")) {
-          Variant molName = spMdlFileSource->GetDataValue("Name");
-          if (molName.isEmpty())
-            nUnnamedLigands++;
-          fmt::print("Name: {}\n", molName.GetString());
-        }
-        if (spMdlFileSource->isDataFieldPresent("REG_Number"))
-          fmt::print("REG_Number: {}\n",
-                     spMdlFileSource->GetDataValue("REG_Number").GetString());
-        fmt::print("RNG seed: ");
-        if (bSeed) {
-          fmt::print("{}\n", nSeed);
-        } else {
-          fmt::print("std::random_device\n");
-        }
+// BGD 26 Feb 2003 - Create filters to simulate old rbdock behaviour. Returns
+// the filter definition for the -t, -n and -cont options, used unless a filter
+// file is given
+std::string GetFilterString(bool bTarget, double dTargetScore,
+                            bool bDockingRuns, std::size_t nDockingRuns,
+                            bool bContinue) {
+  std::ostringstream strFilter;
+  if (bTarget) // -t<TS>
+  {
+    fmt::print("Lower target intermolecular score = {}\n", dTargetScore);
+    if (!bDockingRuns) // -t<TS> only
+    {
+      strFilter << fmt::format("0 1 - {}score.inter ", GetMetaDataPrefix())
+                << dTargetScore << std::endl;
+    } else             // -t<TS> -n<N> need to check if -cont present
+                       // for all other cases it doesn't matter
+        if (bContinue) // -t<TS> -n<N> -cont
+    {
+      strFilter << fmt::format("1 if - {}score.NRUNS ", GetMetaDataPrefix())
+                << (nDockingRuns - 1)
+                << fmt::format(" 0.0 -1.0,\n1 - {}score.inter ",
+                               GetMetaDataPrefix())
+                << dTargetScore << std::endl;
+    } else // -t<TS> -n<N>
+    {
+      strFilter << "1 if - " << dTargetScore
+                << fmt::format(" {}score.inter 0.0 ", GetMetaDataPrefix())
+                << fmt::format("if - {}score.NRUNS ", GetMetaDataPrefix())
+                << (nDockingRuns - 1)
+                << fmt::format(" 0.0 -1.0,\n1 - {}score.inter ",
+                               GetMetaDataPrefix())
+                << dTargetScore << std::endl;
+    }
+  }                      // no target score, no filter
+  else if (bDockingRuns) // -n<N>
+  {
+    strFilter << fmt::format("1 if - {}score.NRUNS ", GetMetaDataPrefix())
+              << (nDockingRuns - 1) << " 0.0 -1.0,\n0";
+  } else // no -t no -n
+  {
+    strFilter << "0 0\n";
+  }
+  return strFilter.str();
+}
 
-        // Create and register the ligand model
-        ModelPtr spLigand = prmFactory.CreateLigand(spMdlFileSource);
-        std::string strMolName = spLigand->GetName();
-        spWS->SetLigand(spLigand);
-        // Update any model coords from embedded chromosomes in the ligand file
-        spWS->UpdateModelCoordsFromChromRecords(spMdlFileSource);
-
-        // DM 18 May 1999 - store run info in model data
-        // Clear any previous rxdock.program.* data fields
-        spLigand->ClearAllDataFields(GetMetaDataPrefix() + "program.");
-        spLigand->SetDataValue(GetMetaDataPrefix() + "program.library", vLib);
-        spLigand->SetDataValue(GetMetaDataPrefix() + "program.receptor",
-                               vRecep);
-        spLigand->SetDataValue(GetMetaDataPrefix() + "program.parameter_file",
-                               vPrm);
-        spLigand->SetDataValue(
-            GetMetaDataPrefix() + "program.current_directory", vDir);
-
-        // DM 10 Dec 1999 - if in target mode, loop until target score is
-        // reached
-        bool bTargetMet = false;
-
-        ////////////////////////////////////////////////////
-        // MAIN LOOP OVER EACH SIMULATED ANNEALING RUN
-        // Create a history file sink, just in case it's needed by any
-        // of the transforms
-        std::size_t iRun = 0;
-        std::size_t nErrors = 0;
-        // need to check this here. The termination
-        // filter is only run once at least
-        // one docking run has been done.
-        if (nDockingRuns < 1)
-          bTargetMet = true;
-        while (!bTargetMet) {
-          // Catching errors with this specific run
-          if (nErrors > 10) {
-            fmt::print(
-                "Target not met, but giving up on ligand after {} errors",
-                nErrors);
-            bLigandError = true;
-            break;
-          }
-          try {
-            if (bOutputHistory) {
-              std::ostringstream histr;
-              histr << strOutputHistoryFilePrefix << "_" << strMolName
-                    << nRec + 1 << "_his_" << iRun + 1 << ".sd";
-              MolecularFileSinkPtr spHistoryFileSink(
-                  new MdlFileSink(histr.str(), spLigand));
-              spWS->SetHistorySink(spHistoryFileSink);
-            }
-            spWS->Run(); // Dock!
-            bool bterm = spfilter->Terminate();
-            bool bwrite = spfilter->Write();
-            if (bterm)
-              bTargetMet = true;
-            if (bwrite) {
-              spWS->Save();
-            }
-            iRun++;
-          } catch (DockingError &e) {
-            fmt::print("{}\n", e.what());
-            nErrors++;
-          }
-        }
-        // END OF MAIN LOOP OVER EACH SIMULATED ANNEALING RUN
-        ////////////////////////////////////////////////////
+// Creates the filter object for controlling early termination of protocol
+FilterPtr CreateFilter(bool bFilter, const std::string &strFilterFile,
+                       bool bDockingRuns, std::size_t nDockingRuns,
+                       const std::string &strFilter) {
+  FilterPtr spfilter;
+  if (bFilter) {
+    spfilter = new Filter(strFilterFile);
+    if (bDockingRuns) {
+      spfilter->SetMaxNRuns(nDockingRuns);
+    }
+  } else {
+    spfilter = new Filter(strFilter, true);
+  }
+  return spfilter;
+}
+
+// Inserts the chunk number into a file name, before its extension
+std::string GetChunkFileName(const std::string &fileName, std::size_t iChunk) {
+  std::string strChunk = fmt::format("_chunk{}", iChunk + 1);
+  for (const std::string ext : {".sd.gz", ".sd"}) {
+    if (fileName.size() > ext.size() &&
+        fileName.compare(fileName.size() - ext.size(), ext.size(), ext) ==
+            0) {
+      return fileName.substr(0, fileName.size() - ext.size()) + strChunk +
+             ext;
+    }
+  }
+  return fileName + strChunk;
+}
+
+#ifndef _WIN32
+// Moves the lines of the first SD record in strBuffer, up to its $$$$ line,
+// to lineRecs. Returns false if the buffer does not hold a whole record yet
+bool ExtractRequestRecord(std::string &strBuffer, FileRecList &lineRecs) {
+  lineRecs.clear();
+  std::size_t iStart = 0;
+  std::size_t iEnd;
+  while ((iEnd = strBuffer.find('\n', iStart)) != std::string::npos) {
+    std::string line = strBuffer.substr(iStart, iEnd - iStart);
+    iStart = iEnd + 1;
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.compare(0, 4, "$$$$") == 0) {
+      strBuffer.erase(0, iStart);
+      return true;
+    }
+    lineRecs.push_back(line);
+  }
+  lineRecs.clear();
+  return false;
+}
+
+// Reads the SD records sent by a serve client in a thread of its own, ahead
+// of the docking threads, so that they never wait for the client while
+// holding the input. Up to nWindowBytes of records are read ahead. A last
+// record without a $$$$ line is accepted. With dTimeout > 0 the input is
+// ended once the client has sent nothing for dTimeout seconds while all the
+// responses to its records have been written by pWriter
+class RequestReader {
+public:
+  RequestReader(int fd, AsyncFileWriter *pWriter, std::size_t nWindowBytes,
+                double dTimeout);
+  ~RequestReader();
+
+  // Returns the next record, waiting for it, or false at the end of the
+  // input
+  bool Next(FileRecList &lineRecs);
+  // Returns why the input ended before the client closed it, if it did
+  std::string GetError();
+
+private:
+  RequestReader(const RequestReader &);
+  RequestReader &operator=(const RequestReader &);
+
+  void ReadLoop();
+  void Push(FileRecList &lineRecs);
+  bool IsIdle();
+
+  int m_fd;
+  AsyncFileWriter *m_pWriter;
+  std::size_t m_nWindowBytes;
+  double m_dTimeout;
+  int m_wakeFds[2]; // Pipe waking the reader thread up when stopping
+
+  std::mutex m_mutex;
+  std::condition_variable m_changed;
+  std::deque<FileRecList> m_records; // Records read but not yet returned
+  std::size_t m_nBytes = 0;          // Bytes of m_records
+  std::size_t m_nRecords = 0;        // Records read
+  bool m_bEnd = false;
+  bool m_bStop = false;
+  std::string m_strError;
+  std::thread m_thread;
+};
+
+RequestReader::RequestReader(int fd, AsyncFileWriter *pWriter,
+                             std::size_t nWindowBytes, double dTimeout)
+    : m_fd(fd), m_pWriter(pWriter), m_nWindowBytes(nWindowBytes),
+      m_dTimeout(dTimeout) {
+  if (pipe(m_wakeFds) != 0) {
+    throw FileReadError(_WHERE_, fmt::format("Error creating a pipe: {}",
+                                             std::strerror(errno)));
+  }
+  m_thread = std::thread(&RequestReader::ReadLoop, this);
+}
+
+RequestReader::~RequestReader() {
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_bStop = true;
+  }
+  m_changed.notify_all();
+  char cWake = 0;
+  while (write(m_wakeFds[1], &cWake, 1) < 0 && errno == EINTR) {
+  }
+  m_thread.join();
+  close(m_wakeFds[0]);
+  close(m_wakeFds[1]);
+}
+
+bool RequestReader::Next(FileRecList &lineRecs) {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_changed.wait(lock, [this] { return !m_records.empty() || m_bEnd; });
+  if (m_records.empty()) {
+    return false;
+  }
+  lineRecs.swap(m_records.front());
+  m_records.pop_front();
+  for (const std::string &line : lineRecs) {
+    m_nBytes -= line.size() + 1;
+  }
+  m_changed.notify_all();
+  return true;
+}
+
+std::string RequestReader::GetError() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_strError;
+}
 
-        // here we use iRun since it got incremented in the last iteration to
-        // the number of runs done
-        fmt::print("Numer of docking runs done:   {} ({} errors)\n", iRun,
-                   nErrors);
+void RequestReader::Push(FileRecList &lineRecs) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  for (const std::string &line : lineRecs) {
+    m_nBytes += line.size() + 1;
+  }
+  m_records.push_back(FileRecList());
+  m_records.back().swap(lineRecs);
+  m_nRecords++;
+  m_changed.notify_all();
+}
+
+// Returns whether all the records read have been docked and answered
+bool RequestReader::IsIdle() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_records.empty() && m_pWriter->GetNumWrittenBlocks() == m_nRecords;
+}
+
+void RequestReader::ReadLoop() {
+  std::string strBuffer;
+  FileRecList lineRecs;
+  std::chrono::steady_clock::time_point idleSince =
+      std::chrono::steady_clock::now();
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_changed.wait(lock,
+                     [this] { return m_bStop || m_nBytes < m_nWindowBytes; });
+      if (m_bStop) {
+        break;
       }
-      // END OF TRY
-      catch (LigandError &e) {
-        fmt::print("{}\n", e.what());
-        bLigandError = true;
+    }
+    // With a timeout the client is checked on every second
+    struct pollfd fds[2];
+    fds[0].fd = m_fd;
+    fds[0].events = POLLIN;
+    fds[1].fd = m_wakeFds[0];
+    fds[1].events = POLLIN;
+    int nReady = poll(fds, 2, m_dTimeout > 0.0 ? 1000 : -1);
+    if (nReady < 0 && errno == EINTR) {
+      continue;
+    } else if (nReady < 0) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_strError = fmt::format("Error waiting for the client: {}",
+                               std::strerror(errno));
+      break;
+    }
+    if (fds[1].revents != 0) {
+      break;
+    }
+    std::chrono::steady_clock::time_point now =
+        std::chrono::steady_clock::now();
+    if (nReady == 0) {
+      if (!IsIdle()) {
+        idleSince = now;
+      } else if (now - idleSince >=
+                 std::chrono::duration<double>(m_dTimeout)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_strError = fmt::format("No request from the client for {} "
+                                 "second(s)",
+                                 m_dTimeout);
+        break;
       }
-
-      if (!bLigandError) {
-        auto endTime = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> recordDuration = endTime - startTime;
-        fmt::print("Ligand docking duration:      {} second(s)\n",
-                   recordDuration.count());
-        totalDuration += recordDuration;
-        // report average every 10th record starting from the 1st
-        // nRec ligand is done here so the number of docked ligands is nRec + 1
-        if (nRec % 10 == 0) {
-          fmt::print("\nAverage duration per ligand:  {} second(s)\n",
-                     totalDuration.count() / static_cast<double>(nRec + 1));
-          std::size_t estNumRecords = spMdlFileSource->GetEstimatedNumRecords();
-          if (estNumRecords > 0) {
-            std::chrono::duration<double> estimatedTimeRemaining =
-                estNumRecords * (totalDuration / static_cast<double>(nRec + 1));
-            std::chrono::system_clock::time_point loopEnd =
-                loopBegin + std::chrono::duration_cast<std::chrono::seconds>(
-                                estimatedTimeRemaining);
-            std::time_t loopEndTime =
-                std::chrono::system_clock::to_time_t(loopEnd);
-            fmt::print(
-                "Approximately {} record(s) remaining, will finish {:%c}\n",
-                estNumRecords - (nRec + 1), fmt::localtime(loopEndTime));
-          }
+      continue;
+    }
+    idleSince = now;
+    char buf[65536];
+    ssize_t nRead = read(m_fd, buf, sizeof(buf));
+    if (nRead < 0 && (errno == EINTR || errno == EAGAIN)) {
+      continue;
+    } else if (nRead < 0) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_strError = fmt::format("Error reading from the client: {}",
+                               std::strerror(errno));
+      break;
+    } else if (nRead == 0) {
+      // The last record may lack its $$$$ line, but blank lines after the
+      // last record are not a record
+      if (strBuffer.find_first_not_of(" \t\r\n") != std::string::npos) {
+        if (strBuffer.back() != '\n') {
+          strBuffer += '\n';
         }
-      } else {
-        nFailedLigands++;
+        strBuffer += "$$$$\n";
+        ExtractRequestRecord(strBuffer, lineRecs);
+        Push(lineRecs);
       }
+      break;
     }
-    // END OF MAIN LOOP OVER LIGAND RECORDS
-    ////////////////////////////////////////////////////
+    strBuffer.append(buf, nRead);
+    while (ExtractRequestRecord(strBuffer, lineRecs)) {
+      Push(lineRecs);
+    }
+  }
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_bEnd = true;
+  m_changed.notify_all();
+}
 
-    // FileStatusOK becomes false when nRec, counting from zero, becomes equal
-    // to number of ligands in the file
-    fmt::print("Total number of ligands: {}", nRec);
-    if (nFailedLigands > 0)
-      fmt::print(", of which {} failed to dock\n", nFailedLigands);
-    else
-      fmt::print(", all ligands docked without errors\n");
+// Creates a Unix domain socket listening on the given path, which only the
+// user can connect to. A socket left behind by a previous server is replaced,
+// any other file is not
+int ListenOnSocket(const std::string &strSocket) {
+  struct sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (strSocket.size() >= sizeof(addr.sun_path)) {
+    throw BadArgument(_WHERE_, "Socket path " + strSocket + " is too long");
+  }
+  std::strcpy(addr.sun_path, strSocket.c_str());
+  struct stat fileStat;
+  if (lstat(strSocket.c_str(), &fileStat) == 0 && S_ISSOCK(fileStat.st_mode)) {
+    unlink(strSocket.c_str());
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  // The socket file is created without permissions for the group and
+  // others, so that nobody else can connect to it at any time
+  mode_t oldMask = umask(0077);
+  bool bBound =
+      fd >= 0 &&
+      bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) == 0;
+  umask(oldMask);
+  if (!bBound || listen(fd, 16) != 0) {
+    if (fd >= 0) {
+      close(fd);
+    }
+    throw FileWriteError(_WHERE_, fmt::format("Error listening on {}: {}",
+                                              strSocket,
+                                              std::strerror(errno)));
+  }
+  return fd;
+}
+#endif
+
+// Returns the number of threads to use for a requested number, where 0 means
+// all available cores
+std::size_t GetNumThreads(std::size_t nThreads) {
+#ifdef _OPENMP
+  if (nThreads == 0) {
+    nThreads = omp_get_max_threads();
+  }
+#endif
+  return nThreads;
+}
+
+// Returns the size in bytes of an output window of nOutputWindow MiB, where 0
+// means 64 MiB
+std::size_t GetOutputWindowBytes(std::size_t nOutputWindow) {
+  return (nOutputWindow > 0 ? nOutputWindow : 64) << 20;
+}
+
+// DM 18 May 1999
+// Variants describing the library version, parameter file, and current
+// directory will be stored in the ligand SD files
+struct ProgramFields {
+  Variant vLib;
+  Variant vRecep;
+  Variant vPrm;
+  Variant vDir;
+};
 
-    if (nRec - nFailedLigands > 0) {
-      auto hTotal =
-          std::chrono::duration_cast<std::chrono::hours>(totalDuration);
-      totalDuration -= hTotal;
-      auto mTotal =
-          std::chrono::duration_cast<std::chrono::minutes>(totalDuration);
-      totalDuration -= mTotal;
+// Returns the program data fields of the poses docked with a context
+ProgramFields GetProgramFields(DockingContext &context) {
+  ProgramFields fields;
+  fields.vLib = GetProduct() + "/" + GetProgramVersion();
+  fields.vRecep = context.spRecepPrmSource->GetFileName();
+  fields.vPrm = context.spParamSource->GetFileName();
+  fields.vDir = GetCurrentWorkingDirectory();
+  return fields;
+}
+
+// DM 18 May 1999 - store run info in model data
+void SetProgramFields(ModelPtr spLigand, const ProgramFields &fields) {
+  spLigand->SetDataValue(GetMetaDataPrefix() + "program.library",
+                         fields.vLib);
+  spLigand->SetDataValue(GetMetaDataPrefix() + "program.receptor",
+                         fields.vRecep);
+  spLigand->SetDataValue(GetMetaDataPrefix() + "program.parameter_file",
+                         fields.vPrm);
+  spLigand->SetDataValue(GetMetaDataPrefix() + "program.current_directory",
+                         fields.vDir);
+}
 
-      fmt::print("\nDocking duration for {} ligand(s): ",
-                 nRec - nFailedLigands);
+// Reads the next input record, returning false once there is none left.
+// Called by one thread at a time
+typedef std::function<bool(std::size_t &iRec, FileRecList &lineRecs)>
+    RecordReader;
+// Processes input record iRec, submitting its output as block iRec of the
+// writer
+typedef std::function<void(std::size_t iRec, FileRecList &lineRecs)>
+    RecordHandler;
 
-      if (hTotal.count() > 0) {
-        fmt::print("{} hour(s), ", hTotal.count());
+// Processes the records returned by readRecord with nThreads threads. Each
+// thread gets its record handler from startThread, called with its thread
+// number, and processes records with it until the input ends. The first
+// error, of any type, stops all the threads, and releases those waiting for
+// the writer pWriter. Returns false if the records were not all processed,
+// with the error in strAbortMessage
+bool ProcessRecords(std::size_t nThreads, AsyncFileWriter *pWriter,
+                    const RecordReader &readRecord,
+                    const std::function<RecordHandler(int)> &startThread,
+                    std::string &strAbortMessage) {
+  std::atomic<bool> bAbort(false);
+  bool bEndOfInput = false;
+#pragma omp parallel num_threads(nThreads)
+  {
+    int iThread = 0;
+#ifdef _OPENMP
+    iThread = omp_get_thread_num();
+#endif
+    // No exception may leave the parallel region, so the first one is kept
+    // and reported once all the threads are done
+    bool bError = false;
+    std::string strError;
+    try {
+      RecordHandler processRecord = startThread(iThread);
+      while (!bAbort) {
+        FileRecList lineRecs;
+        std::size_t iRec = 0;
+        bool bEndOfFile = false;
+        // An exception must not leave the critical section, so an error
+        // reading the input is thrown once outside it
+        std::exception_ptr readException;
+#pragma omp critical(recordInput)
+        {
+          // Once the end of the input is reached it must not be read again,
+          // as a file source would reopen the file from the first record
+          try {
+            bEndOfFile = bEndOfInput || !readRecord(iRec, lineRecs);
+          } catch (...) {
+            readException = std::current_exception();
+            bEndOfFile = true;
+          }
+          bEndOfInput = bEndOfFile;
+        }
+        if (readException) {
+          std::rethrow_exception(readException);
+        }
+        if (bEndOfFile) {
+          break;
+        }
+        processRecord(iRec, lineRecs);
       }
-      if (hTotal.count() > 0 || mTotal.count() > 0) {
-        fmt::print("{} minute(s), ", mTotal.count());
+    } catch (std::exception &e) {
+      bError = true;
+      strError = e.what();
+    } catch (...) {
+      bError = true;
+      strError = "Unknown error while processing the records";
+    }
+    if (bError) {
+      // Stop all the threads, the error is reported once they are done
+#pragma omp critical(recordAbort)
+      {
+        if (!bAbort) {
+          strAbortMessage = strError;
+        }
+        bAbort = true;
       }
-      fmt::print("{} second(s)\n", totalDuration.count());
+      // Release the threads waiting for this thread to submit its record
+      pWriter->Abort();
     }
+    SetRandInstance(nullptr);
+  }
+  return !bAbort;
+}
 
-    if (nUnnamedLigands > 0) {
-      fmt::print("Warning: {} ligand(s) are unnamed. Post-processing tools "
-                 "might have an issue correctly identifying different poses of "
-                 "the same ligand.\n",
-                 nUnnamedLigands);
+// Returns a reader of the records of an SD file source, numbered from 0
+RecordReader ReadSourceRecords(MolecularFileSourcePtr spSource,
+                               std::size_t &nRec) {
+  return [spSource, &nRec](std::size_t &iRec,
+                           FileRecList &lineRecs) mutable {
+    if (!spSource->FileStatusOK()) {
+      return false;
     }
+    lineRecs = spSource->GetRecordLines();
+    spSource->NextRecord();
+    iRec = nRec++;
+    return true;
+  };
+}
 
-    if (bOutputCrd) {
-      MolecularFileSinkPtr spRecepSink(
-          new CrdFileSink(strOutputCrdFile, spReceptor));
-      spRecepSink->Render();
+// Binds the thread that creates it to other CPUs, and once it goes out of
+// scope, in the same thread, lets the thread run on the given CPUs again
+class ThreadCpusBinding {
+public:
+  explicit ThreadCpusBinding(const std::vector<int> &restoreCpus)
+      : m_restoreCpus(restoreCpus) {}
+  ~ThreadCpusBinding() {
+    if (m_bBound) {
+      support::bindThreadToCpus(m_restoreCpus);
     }
-    std::cout << std::endl;
-    PrintBibliographyItem(std::cout, "RiboDock2004");
-    PrintBibliographyItem(std::cout, "rDock2014");
-#if !defined(__sun) && !defined(_MSC_VER)
-    PrintBibliographyItem(std::cout, "PCG2014");
+  }
+
+  bool Bind(const std::vector<int> &cpus) {
+    m_bBound = true;
+    return support::bindThreadToCpus(cpus);
+  }
+
+private:
+  ThreadCpusBinding(const ThreadCpusBinding &);
+  ThreadCpusBinding &operator=(const ThreadCpusBinding &);
+
+  std::vector<int> m_restoreCpus;
+  bool m_bBound = false;
+};
+
+// Docks ligands with the options of a dock or serve operation. The receptor,
+// docking site and scoring function are set up once when the job is created,
+// and each docking thread keeps the contexts it creates for all the ligands
+// it docks
+class DockingJob {
+public:
+  DockingJob(const DockOptions &options, bool bServe);
+
+  // Docks the records of the input file, or of its shard, to the output file
+  int DockFile();
+
+#ifndef _WIN32
+  // Serves the ligands sent on strSocket or, if it is empty, on standard
+  // input, with the responses written to protocolFd (see serve)
+  int Serve(const std::string &strSocket, int protocolFd, double dTimeout);
+#endif
+
+private:
+  // Reads record iRec of the input, returning false at its end
+  typedef std::function<bool(std::size_t iRec, FileRecList &lineRecs)>
+      InputReader;
+
+  // A record read but not yet docked, with its predicted cost
+  struct ScheduledRecord {
+    std::size_t iRec;
+    FileRecList lineRecs;
+    double dCost;
+  };
+
+  // A ligand structure of the records read. Once its first record is done,
+  // the record lines and poses of it are saved to the duplicates file, as
+  // more duplicates of it may still be read
+  struct DuplicatedStructure {
+    std::size_t iFirstRec = 0;
+    bool bDone = false; // Whether the poses are known
+    std::size_t nFileOffset = 0;
+    std::size_t nLineBytes = 0;
+    std::size_t nPoseBytes = 0;
+    // The duplicates to write once the poses are known
+    std::vector<std::pair<std::size_t, FileRecList>> waiting;
+  };
+
+  // The progress of the runs of the ligand docked by a docking thread
+  struct LigandRuns {
+    std::size_t iRun = 0;    // Runs done
+    std::size_t nErrors = 0; // Runs that failed
+    // Runs are numbered in the order they are started, including the runs
+    // that fail, and run number iAttempt draws from the stream of the seed
+    // for (iRec, iAttempt). The docked poses therefore do not depend on how
+    // the ligands and runs are split between threads
+    std::size_t iAttempt = 0;
+    std::size_t nPoses = 0; // Poses saved
+    // Best screening score of the runs so far
+    double dBestScore = std::numeric_limits<double>::infinity();
+    // Best scoring pose of the runs so far, and the number of runs that
+    // found it
+    CoordList bestPose;
+    double dBestPoseScore = std::numeric_limits<double>::infinity();
+    std::size_t nBestPoseFound = 0;
+  };
+
+  void ReadCheckpoint();
+  void WriteCheckpoint(std::size_t nRecords, std::size_t nBytes);
+  DockingContext &GetNodeTemplateContext(std::size_t iNode);
+  DockingContext CreateContext(std::size_t iNode, bool bRunOnly);
+  ModelPtr CreateLigand(DockingContext &context);
+  ModelPtr PrepareLigand(DockingContext &context);
+  void OpenInput();
+  bool DockShard();
+  bool DockSpool();
+  void StopChunk();
+  void AddStructure(std::size_t iRec);
+  bool IsDuplicate(std::size_t iRec);
+  bool ReadFileRecord(std::size_t iRec, FileRecList &lineRecs);
+  bool ReadScheduledRecord(const InputReader &readInput, std::size_t &iRec,
+                           FileRecList &lineRecs);
+  std::vector<std::string>
+  DockRunBatch(std::vector<DockingContext> &contexts, std::size_t iRec,
+               const FileRecList &lineRecs, const std::string &strMolName,
+               std::vector<char> &ligandReady, std::size_t nBatch,
+               LigandRuns &runs);
+  bool CheckRun(BiMolWorkSpace *pWS, FilterPtr spFilter, LigandRuns &runs,
+                std::ostream &log);
+  bool DockLigand(std::vector<DockingContext> &contexts,
+                  const FileRecList &lineRecs, std::size_t iRec,
+                  std::ostream &log, bool &bUnnamed, std::size_t &nPoses);
+  bool SubmitDuplicate(std::size_t iRec, const FileRecList &lineRecs,
+                       std::ostream &log);
+  std::vector<std::pair<std::size_t, std::string>>
+  CompleteDuplicates(std::size_t iRec, const FileRecList &lineRecs,
+                     const std::string &strPoses);
+  std::string GetResponseHeader(std::size_t iRec, const FileRecList &lineRecs,
+                                bool bDocked, std::size_t nPoses) const;
+  void ReportLigand(std::size_t iRec, bool bUnnamed, bool bLigandOK,
+                    std::chrono::duration<double> recordDuration,
+                    std::ostream &log);
+  void DockRecord(std::vector<DockingContext> &contexts, std::size_t iRec,
+                  const FileRecList &lineRecs);
+  bool DockRecords(AsyncFileWriterPtr spWriter, const InputReader &readInput);
+  void PrintSummary();
+#ifndef _WIN32
+  bool ServeSession(int inFd, std::FILE *outStream, double dTimeout);
+#endif
+
+  DockOptions m_options;
+  bool m_bServe;
+  std::string m_wsName;
+  bool m_bDeduplicate;
+  MdlFileSource::eStructureMatch m_eDuplicateMatch;
+  // NUMA nodes the docking threads are bound to, if any. The CPUs of the
+  // main thread when the job is created are given back to it, and to the
+  // other docking threads, once they are done
+  std::vector<std::vector<int>> m_numaNodes;
+  std::size_t m_nNodes;
+  std::vector<int> m_jobCpus;
+  ThreadCpusBinding m_mainThreadBinding;
+  DockingSitePtr m_spDS;
+
+  // Checkpoint resumed from, if any
+  std::size_t m_nResumeRecords = 0;
+  std::size_t m_nResumeInputOffset = 0;
+  std::size_t m_nResumeOutputOffset = 0;
+  // End offset in the input file of each record that has been read but not
+  // yet checkpointed
+  std::map<std::size_t, std::size_t> m_recordEnds;
+  std::mutex m_recordEndsMutex;
+
+  // Writer of the output file; when serving, each client session has its
+  // own writer. With a spool, the chunk is stopped once its lease is lost
+  AsyncFileWriterPtr m_spOutputWriter;
+  std::mutex m_outputWriterMutex;
+  std::atomic<bool> m_bChunkStopped{false};
+  // Writer of the history files of all the runs
+  AsyncFileWriterPtr m_spHistoryWriter;
+  ScreeningProtocolPtr m_spScreening;
+  std::string m_strFilter;
+  // Template context of each NUMA node, from which the docking contexts of
+  // the node are cloned. The first one is the template context of the job.
+  // The template contexts of different nodes are created concurrently
+  std::vector<DockingContext> m_nodeTemplateContexts;
+  std::vector<std::once_flag> m_nodeTemplateFlags;
+  // Contexts of each docking thread
+  std::vector<std::vector<DockingContext>> m_threadContexts;
+  ResultCachePtr m_spResultCache;
+  std::uint64_t m_nJobHash = 0;
+  ProgramFields m_programFields;
+
+  // Shared source the input records are read from, and the input offsets of
+  // the next record and of the end of the shard
+  MolecularFileSourcePtr m_spMdlFileSource;
+  std::size_t m_nInputOffset = 0;
+  std::size_t m_nShardEnd = 0;
+  // The structures of the records read, by structure hash, the structure of
+  // each record read that is not done yet, and the temporary file with the
+  // poses of the structures that are done
+  std::map<std::uint64_t, DuplicatedStructure> m_structures;
+  std::map<std::size_t, std::uint64_t> m_recordStructures;
+  std::FILE *m_duplicatesFile = nullptr;
+  std::size_t m_nDuplicatesFileBytes = 0;
+  std::mutex m_duplicatesMutex;
+
+  // State of the records being docked
+  AsyncFileWriterPtr m_spWriter;
+  std::size_t m_nRec = 0;
+  bool m_bEndOfInput = false;
+  // The records read but not yet docked, in reverse docking order
+  std::vector<ScheduledRecord> m_schedule;
+  std::string m_strAbortMessage;
+  std::chrono::duration<double> m_totalDuration;
+  std::chrono::system_clock::time_point m_loopBegin;
+  std::size_t m_nFailedLigands = 0;
+  std::size_t m_nUnnamedLigands = 0;
+  std::size_t m_nCachedLigands = 0;
+  std::size_t m_nDuplicateRecords = 0;
+};
+
+DockingJob::DockingJob(const DockOptions &options, bool bServe)
+    : m_options(options), m_bServe(bServe),
+      m_jobCpus(support::getThreadCpus()), m_mainThreadBinding(m_jobCpus) {
+  // Set the workspace name to the root of the receptor .prm filename
+  std::vector<std::string> componentList =
+      ConvertDelimitedStringToList(m_options.strReceptorPrmFile, ".");
+  m_wsName = componentList.front();
+
+  // Determine the number of docking threads, each of which docks a different
+  // ligand. Each docking thread docks nRunThreads runs of its ligand at a
+  // time, and each population is scored by nScoringThreads threads
+  m_options.nThreads = GetNumThreads(m_options.nThreads);
+  m_options.nRunThreads = GetNumThreads(m_options.nRunThreads);
+  m_options.nScoringThreads = GetNumThreads(m_options.nScoringThreads);
+#ifdef _OPENMP
+  // Docking threads, run threads and scoring threads can all be nested
+  omp_set_max_active_levels(3);
+#else
+  if (m_options.nThreads != 1 || m_options.nRunThreads != 1 ||
+      m_options.nScoringThreads != 1) {
+    fmt::print("Built without OpenMP support, docking with a single "
+               "thread\n");
+    m_options.nThreads = 1;
+    m_options.nRunThreads = 1;
+    m_options.nScoringThreads = 1;
+  }
 #endif
-    std::cout << std::endl;
-    std::cout << "Thank you for using " << GetProgramName() << " "
-              << GetProgramVersion() << "." << std::endl;
+
+  // Duplicate records are found by the structure hashes of their ligands
+  m_bDeduplicate = !m_options.strDuplicateMatch.empty();
+  m_eDuplicateMatch = MdlFileSource::EXACT_MATCH;
+  if (m_options.strDuplicateMatch == "stereo") {
+    m_eDuplicateMatch = MdlFileSource::STEREO_MATCH;
+  } else if (m_options.strDuplicateMatch == "tautomer") {
+    m_eDuplicateMatch = MdlFileSource::TAUTOMER_MATCH;
+  } else if (m_bDeduplicate && m_options.strDuplicateMatch != "exact") {
+    throw BadArgument(_WHERE_, "Unknown duplicate match " +
+                                   m_options.strDuplicateMatch +
+                                   ", expected exact, stereo or tautomer");
+  }
+
+  // With NUMA replicas, docking thread i is bound to the CPUs of NUMA node
+  // i % nNodes, and each node gets its own copy of the docking site, receptor
+  // and grids, created by the first thread bound to the node so that the
+  // memory is allocated on the node. The main thread is bound to node 0
+  // before the receptor data of node 0 is created. The threads get the CPUs
+  // of the job back once they are done docking
+  if (m_options.bNumaReplicas) {
+    m_numaNodes = support::getNumaNodeCpus();
+    if (m_numaNodes.size() > m_options.nThreads) {
+      m_numaNodes.resize(m_options.nThreads);
+    }
+    if (m_numaNodes.empty() || m_jobCpus.empty() ||
+        !m_mainThreadBinding.Bind(m_numaNodes.front())) {
+      fmt::print("Unable to bind threads to NUMA nodes, docking without "
+                 "NUMA replicas\n");
+      m_numaNodes.clear();
+    } else {
+      fmt::print("Replicating the receptor data on {} NUMA node(s)\n",
+                 m_numaNodes.size());
+    }
+  }
+  m_nNodes = std::max<std::size_t>(m_numaNodes.size(), 1);
+  std::vector<std::once_flag>(m_nNodes).swap(m_nodeTemplateFlags);
+
+  m_spDS = ReadDockingSite(m_wsName);
+
+  // Prepare the writer for saving the docked conformations for each
+  // ligand DM 3 Dec 1999 - replaced ostrstream with String in determining
+  // SD file name SRC 2014 moved here this block to allow WRITE_ERROR TRUE
+  // Each docking thread renders the poses of its ligand with its own SD file
+  // sink, and the writer writes them in a background thread in input order.
+  // The ligands that are done while an earlier ligand is still docking are
+  // kept in memory, up to nOutputWindow MiB of them (see DockShard). The
+  // history file of each run is written by a single writer too, in the order
+  // the runs finish
+  if (m_options.bOutputHistory) {
+    m_spHistoryWriter =
+        new AsyncFileWriter(GetOutputWindowBytes(m_options.nOutputWindow));
+  }
+
+  // The screening protocol sets the maximum number of runs, which the
+  // filter enforces as for -n
+  if (!m_options.strScreeningFile.empty()) {
+    std::ifstream screeningFile(m_options.strScreeningFile.c_str());
+    if (!screeningFile) {
+      throw FileReadError(_WHERE_,
+                          "Error opening " + m_options.strScreeningFile);
+    }
+    json screeningData;
+    screeningFile >> screeningData;
+    m_spScreening =
+        new ScreeningProtocol(screeningData.at("screening-protocol"));
+    m_options.bDockingRuns = true;
+    m_options.nDockingRuns = m_spScreening->GetMaxRuns();
+    fmt::print("Screening protocol: {}\n{}", m_options.strScreeningFile,
+               *m_spScreening);
+  }
+
+  if (!m_options.bFilter) {
+    m_strFilter = GetFilterString(
+        m_options.bTarget, m_options.dTargetScore, m_options.bDockingRuns,
+        m_options.nDockingRuns, m_options.bContinue);
+  }
+
+  // Create the template context from the docking protocol and receptor
+  // parameter files. It is never docked with; all docking contexts are
+  // cloned from it, so the receptor is only set up once. The template
+  // contexts of the other NUMA nodes are created once a thread bound to the
+  // node needs them
+  m_nodeTemplateContexts.resize(m_nNodes);
+  m_nodeTemplateContexts.front() = CreateDockingContext(
+      m_wsName, m_options.strParamFile, m_options.strReceptorPrmFile, m_spDS,
+      MolecularFileSinkPtr(), FilterPtr(), true);
+
+  // Create the docking context of the main thread, which is also the first
+  // docking thread. The remaining docking threads create their own contexts
+  // once they start, and keep them for all the ligands they dock
+  m_threadContexts.resize(m_options.nThreads);
+  m_threadContexts.front().resize(m_options.nRunThreads);
+  m_threadContexts.front().front() = CreateContext(0, false);
+
+  // The result cache keys the poses of a ligand by its record and by
+  // everything else they depend on, hashed as the job hash, which also
+  // identifies the job of a spool. The options include the number of runs
+  // and the thresholds, in the filter, but not the number of threads, as
+  // the poses do not depend on it
+  if (!m_options.strCacheDir.empty() || !m_options.strSpoolDir.empty()) {
+    std::string strOptions = fmt::format(
+        "{}/{}\nfilter: {}\nmaximum runs: {}\nscreening: {}\n"
+        "convergence: {} {}\nionise: {} {}\nall hydrogens: {}\nseed: {}\n",
+        GetProduct(), GetProgramVersion(),
+        m_options.bFilter ? ReadFileText(m_options.strFilterFile)
+                          : m_strFilter,
+        m_options.bDockingRuns ? m_options.nDockingRuns : 0,
+        m_options.strScreeningFile.empty()
+            ? ""
+            : ReadFileText(m_options.strScreeningFile),
+        m_options.nConvergence, m_options.dConvergenceRMSD,
+        m_options.bPosIonise, m_options.bNegIonise, m_options.bExplH,
+        m_options.bSeed ? std::to_string(m_options.nSeed) : "random");
+    std::string strJobKey =
+        GetJobKey(m_nodeTemplateContexts.front(), m_spDS, strOptions);
+    m_nJobHash = support::hashFNV1a(strJobKey);
+    // The poses of a job without a seed are not reproducible, so there is no
+    // point in storing or reusing them
+    if (!m_options.strCacheDir.empty() && !m_options.bSeed) {
+      fmt::print("Result cache {} not used, as no seed is given\n",
+                 m_options.strCacheDir);
+    } else if (!m_options.strCacheDir.empty()) {
+      m_spResultCache = new ResultCache(m_options.strCacheDir, strJobKey);
+      fmt::print("Result cache: {} (job {})\n", m_options.strCacheDir,
+                 support::formatHash(m_nJobHash));
+    }
+  }
+
+  m_programFields = GetProgramFields(m_threadContexts.front().front());
+
+  // DM 20 Apr 1999 - set the auto-ionise flags
+  if (m_options.bPosIonise) {
+    fmt::print("Automatically protonating positive ionisable groups (amines, "
+               "imidazoles, and guanidines)\n");
+  }
+  if (m_options.bNegIonise) {
+    fmt::print(
+        "Automatically deprotonating negative ionisable groups (carboxylic "
+        "acids, phosphates, sulphates, and sulphonates)\n");
+  }
+  if (!m_options.bExplH) {
+    fmt::print("Reading polar hydrogens only from ligand SD file\n");
+  } else {
+    fmt::print("Reading all hydrogens from ligand SD file\n");
+  }
+  if (m_options.nThreads > 1) {
+    fmt::print("Docking with {} threads\n", m_options.nThreads);
+  }
+  if (m_options.nRunThreads > 1) {
+    fmt::print("Docking {} runs of each ligand concurrently\n",
+               m_options.nRunThreads);
+  }
+  if (m_options.nScoringThreads > 1) {
+    fmt::print("Scoring populations with {} threads\n",
+               m_options.nScoringThreads);
+  }
+}
+
+// The checkpoint records how many input records have been docked and
+// written, and where the next record starts in the input and output files.
+// The poses of a record only depend on the seed and the record index (see
+// DockRunBatch), so no generator state needs to be saved
+void DockingJob::ReadCheckpoint() {
+  if (!m_options.bResume) {
+    return;
+  }
+  if (m_options.strCheckpointFile.empty()) {
+    throw BadArgument(_WHERE_, "Resuming requires a checkpoint file");
+  }
+  std::ifstream checkpointFile(m_options.strCheckpointFile.c_str());
+  if (!checkpointFile) {
+    fmt::print("Checkpoint {} not found, starting from the first SDfile "
+               "record\n",
+               m_options.strCheckpointFile);
+    return;
+  }
+  json checkpointData;
+  checkpointFile >> checkpointData;
+  checkpointFile.close();
+  const json &checkpoint = checkpointData.at("checkpoint");
+  if (checkpoint.at("input").get<std::string>() !=
+          m_options.strLigandMdlFile ||
+      checkpoint.at("output").get<std::string>() !=
+          m_options.strOutputMdlFile) {
+    throw BadArgument(_WHERE_, "Checkpoint " + m_options.strCheckpointFile +
+                                   " is for a different input or output "
+                                   "file");
+  }
+  if (checkpoint.at("shard").get<std::string>() !=
+      fmt::format("{}/{}", m_options.iShard + 1, m_options.nShards)) {
+    throw BadArgument(_WHERE_, "Checkpoint " + m_options.strCheckpointFile +
+                                   " is for a different shard");
+  }
+  if (checkpoint.at("seed").is_null() == m_options.bSeed ||
+      (m_options.bSeed &&
+       checkpoint.at("seed").get<std::size_t>() != m_options.nSeed)) {
+    throw BadArgument(_WHERE_, "Checkpoint " + m_options.strCheckpointFile +
+                                   " was made with a different seed");
+  }
+  m_nResumeRecords = checkpoint.at("records").get<std::size_t>();
+  m_nResumeInputOffset = checkpoint.at("input-offset").get<std::size_t>();
+  m_nResumeOutputOffset = checkpoint.at("output-offset").get<std::size_t>();
+  fmt::print("Resuming from SDfile record #{}\n", m_nResumeRecords + 1);
+}
+
+// Saves the checkpoint once the first nRecords records are on disk, with
+// nBytes bytes of output. Called by the writer thread
+void DockingJob::WriteCheckpoint(std::size_t nRecords, std::size_t nBytes) {
+  std::size_t nInputOffset;
+  {
+    std::lock_guard<std::mutex> lock(m_recordEndsMutex);
+    // The last record written has been read by this job, as the writer
+    // only checkpoints past the first block it was opened with
+    std::map<std::size_t, std::size_t>::iterator iter =
+        m_recordEnds.find(nRecords - 1);
+    if (iter == m_recordEnds.end()) {
+      throw Error(_WHERE_, fmt::format("No input offset for SDfile "
+                                       "record #{} to checkpoint",
+                                       nRecords));
+    }
+    nInputOffset = iter->second;
+    m_recordEnds.erase(m_recordEnds.begin(), iter);
+  }
+  json checkpoint;
+  checkpoint["input"] = m_options.strLigandMdlFile;
+  checkpoint["input-offset"] = nInputOffset;
+  checkpoint["records"] = nRecords;
+  checkpoint["shard"] =
+      fmt::format("{}/{}", m_options.iShard + 1, m_options.nShards);
+  checkpoint["output"] = m_options.strOutputMdlFile;
+  checkpoint["output-offset"] = nBytes;
+  checkpoint["seed"] = m_options.bSeed ? json(m_options.nSeed) : json();
+  json checkpointData;
+  checkpointData["checkpoint"] = checkpoint;
+  // Replace the checkpoint in one step, so that a job killed while writing
+  // it still has the previous one
+  std::string strTmpFile = m_options.strCheckpointFile + ".tmp";
+  std::ofstream ostr(strTmpFile.c_str());
+  ostr << checkpointData << std::endl;
+  ostr.close();
+  if (!ostr || std::rename(strTmpFile.c_str(),
+                           m_options.strCheckpointFile.c_str()) != 0) {
+    throw FileWriteError(_WHERE_,
+                         "Error writing " + m_options.strCheckpointFile);
+  }
+}
+
+// Returns the template context of NUMA node iNode, creating it if the node
+// does not have one yet
+DockingContext &DockingJob::GetNodeTemplateContext(std::size_t iNode) {
+  DockingContext &nodeContext = m_nodeTemplateContexts[iNode];
+  // A thread that fails to create it leaves it to the next thread
+  std::call_once(m_nodeTemplateFlags[iNode], [&] {
+    if (nodeContext.spWS.Null()) {
+      nodeContext = CreateDockingContext(
+          m_wsName, m_options.strParamFile, m_options.strReceptorPrmFile,
+          ReadDockingSite(m_wsName), MolecularFileSinkPtr(), FilterPtr(),
+          false);
+      nodeContext.iNode = iNode;
+    }
+  });
+  return nodeContext;
+}
+
+// Creates a context used for docking. Context 0 of each docking thread owns
+// the ligand that is saved to the output, the other nRunThreads - 1 contexts
+// of the thread (bRunOnly) are used for docking additional runs of the same
+// ligand concurrently. If a seed is given, the generator of the context is
+// seeded before each run (see DockRunBatch). Each context gets
+// nScoringThreads - 1 scoring replicas, which only score populations and so
+// never draw random numbers. The contexts are cloned from the template
+// context of NUMA node iNode
+DockingContext DockingJob::CreateContext(std::size_t iNode, bool bRunOnly) {
+  DockingContext &nodeTemplateContext = GetNodeTemplateContext(iNode);
+  MolecularFileSinkPtr spSink;
+  if (!bRunOnly) {
+    // The sink is given the writer of the records it docks by DockRecords
+    spSink = new MdlFileSink(m_options.strOutputMdlFile, ModelPtr());
+  }
+  DockingContext context = CloneDockingContext(
+      nodeTemplateContext, spSink,
+      bRunOnly ? FilterPtr()
+               : CreateFilter(m_options.bFilter, m_options.strFilterFile,
+                              m_options.bDockingRuns, m_options.nDockingRuns,
+                              m_strFilter));
+  if (m_options.bSeed) {
+    context.spRand->Seed(m_options.nSeed);
+  }
+  context.spLigandSource =
+      new MdlFileSource(m_options.strLigandMdlFile, m_options.bPosIonise,
+                        m_options.bNegIonise, !m_options.bExplH);
+  std::vector<WorkSpace *> replicaWorkSpaces;
+  for (std::size_t iReplica = 1; iReplica < m_options.nScoringThreads;
+       iReplica++) {
+    SmartPtr<DockingContext> spReplica(new DockingContext(CloneDockingContext(
+        nodeTemplateContext, MolecularFileSinkPtr(), FilterPtr())));
+    spReplica->spLigandSource =
+        new MdlFileSource(m_options.strLigandMdlFile, m_options.bPosIonise,
+                          m_options.bNegIonise, !m_options.bExplH);
+    context.scoringReplicas.push_back(spReplica);
+    replicaWorkSpaces.push_back(spReplica->spWS);
+  }
+  context.spWS->SetScoringReplicas(replicaWorkSpaces);
+  context.iNode = iNode;
+  SetRandInstance(context.spRand);
+  return context;
+}
+
+// Creates the ligand model from the current record of the ligand source of
+// the context and registers it with the workspace of the context
+ModelPtr DockingJob::CreateLigand(DockingContext &context) {
+  BaseMolecularFileSource *pSource = context.spLigandSource;
+  // DM 26 Jul 1999 - only read the largest segment (guaranteed to be called
+  // H)
+  pSource->SetSegmentFilterMap(ConvertStringToSegmentMap("H"));
+
+  // Create and register the ligand model
+  PRMFactory prmFactory(context.spRecepPrmSource,
+                        context.spWS->GetDockingSite());
+  ModelPtr spLigand = prmFactory.CreateLigand(pSource);
+  context.spWS->SetLigand(spLigand);
+  // Update any model coords from embedded chromosomes in the ligand file
+  context.spWS->UpdateModelCoordsFromChromRecords(pSource);
+
+  // Clear any previous rxdock.program.* data fields
+  spLigand->ClearAllDataFields(GetMetaDataPrefix() + "program.");
+  SetProgramFields(spLigand, m_programFields);
+  // The ligand is model #1 of the workspace
+  context.startCoords.resize(context.spWS->GetNumModels());
+  context.startCoords[1] = GetCoordList(spLigand->GetAtomList());
+  return spLigand;
+}
+
+// Creates the ligand model from the current record of the ligand source of
+// the context in the context and in all its scoring replicas
+ModelPtr DockingJob::PrepareLigand(DockingContext &context) {
+  ModelPtr spLigand = CreateLigand(context);
+  if (!context.scoringReplicas.empty()) {
+    FileRecList lineRecs = context.spLigandSource->GetRecordLines();
+    for (std::size_t iReplica = 0; iReplica < context.scoringReplicas.size();
+         iReplica++) {
+      DockingContext &replica = *context.scoringReplicas[iReplica];
+      SetRandInstance(replica.spRand);
+      replica.spLigandSource->SetRecordLines(lineRecs);
+      CreateLigand(replica);
+    }
+    SetRandInstance(context.spRand);
+  }
+  return spLigand;
+}
+
+// Opens the input file at the first record to dock: the first record of the
+// shard, or the record after the checkpoint when resuming
+void DockingJob::OpenInput() {
+  // DM 20 Apr 1999 - add explicit bPosIonise and bNegIonise flags to
+  // MdlFileSource constructor
+  // The records are read from this shared source and parsed by a private
+  // source of each docking thread
+  m_spMdlFileSource =
+      new MdlFileSource(m_options.strLigandMdlFile, m_options.bPosIonise,
+                        m_options.bNegIonise, !m_options.bExplH);
+  // The structures of the records are hashed as they are read, from their
+  // heavy atoms
+  if (m_bDeduplicate) {
+    m_spMdlFileSource->SetSegmentFilterMap(ConvertStringToSegmentMap("H"));
+  }
+  // Shard iShard is made of the records that start in its share of the bytes
+  // of the file, moved forward to the end of a record. Only the lines around
+  // the two boundaries are read to find them
+  std::size_t nFileSize = m_spMdlFileSource->GetFileSize();
+  m_nInputOffset = 0;
+  m_nShardEnd = nFileSize;
+  if (m_options.nShards > 1) {
+    std::size_t nShards = m_options.nShards;
+    auto shardBoundary = [&](std::size_t i) -> std::size_t {
+      return m_spMdlFileSource->FindRecordBoundary(
+          nFileSize / nShards * i + nFileSize % nShards * i / nShards);
+    };
+    m_nInputOffset = shardBoundary(m_options.iShard);
+    m_nShardEnd = shardBoundary(m_options.iShard + 1);
+    fmt::print("Docking shard {} of {} (bytes {} to {} of {})\n",
+               m_options.iShard + 1, nShards, m_nInputOffset, m_nShardEnd,
+               nFileSize);
+    m_spMdlFileSource->SeekRecord(m_nInputOffset);
+  }
+  if (m_nResumeRecords > 0) {
+    m_nInputOffset = m_nResumeInputOffset;
+    m_spMdlFileSource->SeekRecord(m_nInputOffset);
+  }
+}
+
+// Adds the structure of record iRec, the current record of the input file,
+// to the structures read. The records are read in order, so the first record
+// of each structure is the one docked
+void DockingJob::AddStructure(std::size_t iRec) {
+  std::uint64_t nHash = 0;
+  // A record that can not be parsed is reported when docking it
+  try {
+    nHash = dynamic_cast<MdlFileSource &>(*m_spMdlFileSource)
+                .GetStructureHash(m_eDuplicateMatch);
+  } catch (Error &) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(m_duplicatesMutex);
+  std::pair<std::map<std::uint64_t, DuplicatedStructure>::iterator, bool>
+      structure =
+          m_structures.insert(std::make_pair(nHash, DuplicatedStructure()));
+  if (structure.second) {
+    structure.first->second.iFirstRec = iRec;
+  }
+  m_recordStructures[iRec] = nHash;
+}
+
+// Returns whether record iRec, read but not done yet, is a duplicate
+bool DockingJob::IsDuplicate(std::size_t iRec) {
+  std::lock_guard<std::mutex> lock(m_duplicatesMutex);
+  std::map<std::size_t, std::uint64_t>::const_iterator iter =
+      m_recordStructures.find(iRec);
+  return iter != m_recordStructures.end() &&
+         m_structures[iter->second].iFirstRec != iRec;
+}
+
+// Reads record iRec of the input file, returning false once the end of the
+// file or of the shard is reached
+bool DockingJob::ReadFileRecord(std::size_t iRec, FileRecList &lineRecs) {
+  if (m_bChunkStopped) {
+    throw Error(_WHERE_, "Stopped docking the chunk, whose lease was lost");
+  }
+  if (m_nInputOffset >= m_nShardEnd || !m_spMdlFileSource->FileStatusOK()) {
+    return false;
+  }
+  lineRecs = m_spMdlFileSource->GetRecordLines();
+  if (m_bDeduplicate) {
+    AddStructure(iRec);
+  }
+  m_nInputOffset = m_spMdlFileSource->GetNextRecordOffset();
+  if (!m_options.strCheckpointFile.empty()) {
+    std::lock_guard<std::mutex> lock(m_recordEndsMutex);
+    m_recordEnds[iRec] = m_nInputOffset;
+  }
+  m_spMdlFileSource->NextRecord();
+  return true;
+}
+
+// Returns the next record to dock. The records are read with readInput
+// nScheduleWindow at a time, and those of each window are docked in order of
+// decreasing predicted cost. Returns false once all the records are docked
+bool DockingJob::ReadScheduledRecord(const InputReader &readInput,
+                                     std::size_t &iRec,
+                                     FileRecList &lineRecs) {
+  if (m_schedule.empty() && !m_bEndOfInput) {
+    std::size_t nRead = std::max<std::size_t>(m_options.nScheduleWindow, 1);
+    while (m_schedule.size() < nRead) {
+      ScheduledRecord record;
+      if (!readInput(m_nRec, record.lineRecs)) {
+        m_bEndOfInput = true;
+        break;
+      }
+      record.iRec = m_nRec++;
+      record.dCost = (m_options.nScheduleWindow > 1 &&
+                      !IsDuplicate(record.iRec))
+                         ? GetDockingCost(record.lineRecs)
+                         : 0.0;
+      m_schedule.push_back(record);
+    }
+    // The most expensive record is docked first, and records of equal cost
+    // in input order
+    std::sort(m_schedule.begin(), m_schedule.end(),
+              [](const ScheduledRecord &a, const ScheduledRecord &b) {
+                return a.dCost < b.dCost ||
+                       (a.dCost == b.dCost && a.iRec > b.iRec);
+              });
+  }
+  if (m_schedule.empty()) {
+    return false;
+  }
+  iRec = m_schedule.back().iRec;
+  lineRecs.swap(m_schedule.back().lineRecs);
+  m_schedule.pop_back();
+  return true;
+}
+
+// Docks the next nBatch runs of the ligand of record iRec concurrently, one
+// per context, creating the contexts and their ligands that are not ready
+// yet. Returns the error message of each run, empty if it did not fail
+std::vector<std::string>
+DockingJob::DockRunBatch(std::vector<DockingContext> &contexts,
+                         std::size_t iRec, const FileRecList &lineRecs,
+                         const std::string &strMolName,
+                         std::vector<char> &ligandReady, std::size_t nBatch,
+                         LigandRuns &runs) {
+  const DockingContext &templateContext = m_nodeTemplateContexts.front();
+  std::vector<std::string> runErrors(nBatch);
+  std::vector<MolecularFileSinkPtr> historySinks(nBatch);
+  std::exception_ptr batchException;
+#pragma omp parallel for num_threads(nBatch) schedule(static, 1)
+  for (int iBatch = 0; iBatch < static_cast<int>(nBatch); iBatch++) {
+    try {
+      DockingContext &runContext = contexts[iBatch];
+      if (runContext.spWS.Null()) {
+        runContext = CreateContext(contexts.front().iNode, true);
+      }
+      SetRandInstance(runContext.spRand);
+      if (!ligandReady[iBatch]) {
+        runContext.spLigandSource->SetRecordLines(lineRecs);
+        PrepareLigand(runContext);
+        ligandReady[iBatch] = 1;
+      }
+      if (m_options.bOutputHistory) {
+        std::ostringstream histr;
+        histr << m_options.strOutputHistoryFilePrefix << "_" << strMolName
+              << iRec + 1 << "_his_" << runs.iRun + iBatch + 1 << ".sd";
+        MolecularFileSinkPtr spHistoryFileSink(
+            new MdlFileSink(histr.str(), runContext.spWS->GetLigand()));
+        spHistoryFileSink->SetWriter(m_spHistoryWriter);
+        runContext.spWS->SetHistorySink(spHistoryFileSink);
+        historySinks[iBatch] = spHistoryFileSink;
+      }
+      // Each run starts from the same state: the models as loaded, and the
+      // scoring function parameters as defined in the docking protocol
+      // rather than as left by the previous run
+      runContext.spWS->SetMobileCoords(runContext.startCoords);
+      runContext.spSF->CopyTreeParameters(*templateContext.spSF);
+      if (m_options.bSeed) {
+        runContext.spRand->SeedStream(m_options.nSeed, iRec,
+                                      runs.iAttempt + iBatch);
+      }
+      runContext.spWS->Run(); // Dock!
+    } catch (DockingError &e) {
+      runErrors[iBatch] = e.what();
+    } catch (...) {
+#pragma omp critical(dockBatch)
+      if (!batchException) {
+        batchException = std::current_exception();
+      }
+    }
+    // The history of the run is written even if the run failed
+    if (!historySinks[iBatch].Null()) {
+      contexts[iBatch].spWS->SetHistorySink(MolecularFileSinkPtr());
+      try {
+        historySinks[iBatch]->SubmitFile();
+      } catch (...) {
+#pragma omp critical(dockBatch)
+        if (!batchException) {
+          batchException = std::current_exception();
+        }
+      }
+    }
+    SetRandInstance(nullptr);
+  }
+  SetRandInstance(contexts.front().spRand);
+  runs.iAttempt += nBatch;
+  if (batchException) {
+    std::rethrow_exception(batchException);
+  }
+  return runErrors;
+}
+
+// Checks the run docked in pWS against the filter, the screening protocol
+// and the convergence criterion, saving its pose if the filter says so.
+// Returns true if no more runs of the ligand are needed
+bool DockingJob::CheckRun(BiMolWorkSpace *pWS, FilterPtr spFilter,
+                          LigandRuns &runs, std::ostream &log) {
+  bool bterm = spFilter->Terminate();
+  bool bwrite = spFilter->Write();
+  if (!m_spScreening.Null()) {
+    StringVariantMap scoreMap;
+    pWS->GetSF()->ScoreMap(scoreMap);
+    Variant vScore =
+        scoreMap[GetMetaDataPrefix() + m_spScreening->GetScoreName()];
+    if (vScore.isEmpty()) {
+      throw BadArgument(_WHERE_, "Unknown screening score " +
+                                     m_spScreening->GetScoreName());
+    }
+    runs.dBestScore = std::min(runs.dBestScore, vScore.GetDouble());
+    if (!bterm && !m_spScreening->Continue(runs.iRun + 1, runs.dBestScore)) {
+      fmt::print(log, "Screening stopped after {} run(s), best score {}\n",
+                 runs.iRun + 1, runs.dBestScore);
+      bterm = true;
+    }
+  }
+  // The search has converged once the runs keep finding the same best pose
+  if (m_options.nConvergence > 0 && !bterm) {
+    double dScore = pWS->GetSF()->Score();
+    CoordList pose = GetHeavyAtomCoords(pWS->GetLigand());
+    bool bBestPose = !runs.bestPose.empty() &&
+                     GetRMSD(pose, runs.bestPose) <= m_options.dConvergenceRMSD;
+    if (bBestPose) {
+      runs.nBestPoseFound++;
+    }
+    if (dScore < runs.dBestPoseScore) {
+      if (!bBestPose) {
+        runs.nBestPoseFound = 1;
+      }
+      runs.bestPose = pose;
+      runs.dBestPoseScore = dScore;
+    }
+    if (runs.nBestPoseFound >= m_options.nConvergence) {
+      fmt::print(log, "Converged after {} run(s), best pose found {} times\n",
+                 runs.iRun + 1, runs.nBestPoseFound);
+      bterm = true;
+    }
+  }
+  if (bwrite) {
+    pWS->Save();
+    runs.nPoses++;
+  }
+  runs.iRun++;
+  return bterm;
+}
+
+// Docks the ligand in the current record of the ligand source of
+// contexts[0], writing the progress messages to log. The other contexts are
+// used to dock runs concurrently; they are created when first needed.
+// Returns false if the ligand could not be docked
+bool DockingJob::DockLigand(std::vector<DockingContext> &contexts,
+                            const FileRecList &lineRecs, std::size_t iRec,
+                            std::ostream &log, bool &bUnnamed,
+                            std::size_t &nPoses) {
+  bool bLigandError = false;
+  DockingContext &context = contexts.front();
+  BaseMolecularFileSource *pSource = context.spLigandSource;
+  BiMolWorkSpacePtr spWS = context.spWS;
+
+  // BGD 07 Oct 2002 - catching errors created by the ligands, so rbdock
+  // continues with the next one, instead of completely stopping
+  try {
+    if (pSource->isDataFieldPresent("Name")) {
+      Variant molName = pSource->GetDataValue("Name");
+      if (molName.isEmpty())
+        bUnnamed = true;
+      fmt::print(log, "Name: {}\n", molName.GetString());
+    }
+    if (pSource->isDataFieldPresent("REG_Number"))
+      fmt::print(log, "REG_Number: {}\n",
+                 pSource->GetDataValue("REG_Number").GetString());
+    fmt::print(log, "RNG seed: ");
+    if (m_options.bSeed) {
+      fmt::print(log, "{}\n", m_options.nSeed);
+    } else {
+      fmt::print(log, "std::random_device\n");
+    }
+
+    ModelPtr spLigand = PrepareLigand(context);
+    std::string strMolName = spLigand->GetName();
+    // The ligand is created in the other contexts once they first dock a run
+    // of it
+    std::vector<char> ligandReady(contexts.size(), 0);
+    ligandReady.front() = 1;
+
+    ////////////////////////////////////////////////////
+    // MAIN LOOP OVER EACH SIMULATED ANNEALING RUN
+    // DM 10 Dec 1999 - if in target mode, loop until target score is reached.
+    // need to check this here. The termination filter is only run once at
+    // least one docking run has been done.
+    LigandRuns runs;
+    bool bTargetMet = (m_options.nDockingRuns < 1);
+    while (!bTargetMet) {
+      // Catching errors with this specific run
+      if (runs.nErrors > 10) {
+        fmt::print(log,
+                   "Target not met, but giving up on ligand after {} errors",
+                   runs.nErrors);
+        bLigandError = true;
+        break;
+      }
+      // Dock a batch of runs concurrently, one per context, without
+      // exceeding the maximum number of runs
+      std::size_t nBatch = contexts.size();
+      if (m_options.bDockingRuns && m_options.nDockingRuns > runs.iRun) {
+        nBatch = std::min(nBatch, m_options.nDockingRuns - runs.iRun);
+      }
+      // Runs past the end of a screening stage may not be needed
+      if (!m_spScreening.Null()) {
+        nBatch =
+            std::min(nBatch, m_spScreening->GetStageEnd(runs.iRun) - runs.iRun);
+      }
+      std::vector<std::string> runErrors = DockRunBatch(
+          contexts, iRec, lineRecs, strMolName, ligandReady, nBatch, runs);
+
+      // Check the runs against the filter in run order, as if they had been
+      // docked one after the other in the workspace of context 0
+      for (std::size_t iBatch = 0; iBatch < nBatch && !bTargetMet;
+           iBatch++) {
+        if (!runErrors[iBatch].empty()) {
+          fmt::print(log, "{}\n", runErrors[iBatch]);
+          runs.nErrors++;
+          continue;
+        }
+        try {
+          if (iBatch > 0) {
+            CopyModelState(contexts[iBatch].spWS, spWS);
+          }
+          bTargetMet = CheckRun(spWS, context.spFilter, runs, log);
+        } catch (DockingError &e) {
+          fmt::print(log, "{}\n", e.what());
+          runs.nErrors++;
+        }
+      }
+    }
+    // END OF MAIN LOOP OVER EACH SIMULATED ANNEALING RUN
+    ////////////////////////////////////////////////////
+
+    // here we use iRun since it got incremented in the last iteration to the
+    // number of runs done
+    fmt::print(log, "Numer of docking runs done:   {} ({} errors)\n",
+               runs.iRun, runs.nErrors);
+    nPoses = runs.nPoses;
+  }
+  // END OF TRY
+  catch (LigandError &e) {
+    fmt::print(log, "{}\n", e.what());
+    bLigandError = true;
+  }
+  return !bLigandError;
+}
+
+// If record iRec is a duplicate, submits the poses of the first record of its
+// structure for it, or leaves it for the thread docking the first record if
+// its poses are not known yet, and returns true
+bool DockingJob::SubmitDuplicate(std::size_t iRec,
+                                 const FileRecList &lineRecs,
+                                 std::ostream &log) {
+  std::size_t iFirstRec = 0;
+  std::string strPoses;
+  bool bFirstDone = false;
+  {
+    std::lock_guard<std::mutex> lock(m_duplicatesMutex);
+    std::map<std::size_t, std::uint64_t>::iterator recordIter =
+        m_recordStructures.find(iRec);
+    if (recordIter == m_recordStructures.end()) {
+      return false;
+    }
+    DuplicatedStructure &structure = m_structures[recordIter->second];
+    iFirstRec = structure.iFirstRec;
+    if (iFirstRec == iRec) {
+      return false;
+    }
+    m_recordStructures.erase(recordIter);
+    bFirstDone = structure.bDone;
+    if (!bFirstDone) {
+      structure.waiting.push_back(std::make_pair(iRec, lineRecs));
+    } else {
+      std::string strSaved(structure.nLineBytes + structure.nPoseBytes, '\0');
+      if (!SeekFile(m_duplicatesFile, structure.nFileOffset) ||
+          std::fread(&strSaved[0], 1, strSaved.size(), m_duplicatesFile) !=
+              strSaved.size()) {
+        throw FileReadError(_WHERE_, "Error reading the poses of SDfile "
+                                     "record #" +
+                                         std::to_string(iFirstRec + 1) +
+                                         " from the duplicates file");
+      }
+      // The record lines were saved one per line
+      FileRecList firstLineRecs;
+      std::string::size_type iLine = 0;
+      while (iLine < structure.nLineBytes) {
+        std::string::size_type iEnd = strSaved.find('\n', iLine);
+        firstLineRecs.push_back(strSaved.substr(iLine, iEnd - iLine));
+        iLine = iEnd + 1;
+      }
+      strPoses = GetDuplicatePoses(strSaved.substr(structure.nLineBytes),
+                                   firstLineRecs, lineRecs, iFirstRec);
+    }
+  }
+  fmt::print(log, "Duplicate of SDfile record #{}\n", iFirstRec + 1);
+  if (bFirstDone) {
+    m_spWriter->Submit(iRec, strPoses);
+  }
+  return true;
+}
+
+// Marks the poses of record iRec as known to its duplicates, saving them for
+// the duplicates still to be read, and returns the poses of the duplicates
+// waiting for them. They are in record order, to be submitted after those of
+// iRec: a record submitted before an earlier one could wait for a free output
+// window forever
+std::vector<std::pair<std::size_t, std::string>>
+DockingJob::CompleteDuplicates(std::size_t iRec, const FileRecList &lineRecs,
+                               const std::string &strPoses) {
+  std::vector<std::pair<std::size_t, std::string>> duplicatePoses;
+  std::lock_guard<std::mutex> lock(m_duplicatesMutex);
+  std::map<std::size_t, std::uint64_t>::iterator recordIter =
+      m_recordStructures.find(iRec);
+  if (recordIter == m_recordStructures.end()) {
+    return duplicatePoses;
+  }
+  DuplicatedStructure &structure = m_structures[recordIter->second];
+  m_recordStructures.erase(recordIter);
+  std::string strLines;
+  for (const std::string &strLine : lineRecs) {
+    strLines += strLine + "\n";
+  }
+  if (!SeekFile(m_duplicatesFile, m_nDuplicatesFileBytes) ||
+      std::fwrite(strLines.data(), 1, strLines.size(), m_duplicatesFile) !=
+          strLines.size() ||
+      std::fwrite(strPoses.data(), 1, strPoses.size(), m_duplicatesFile) !=
+          strPoses.size()) {
+    throw FileWriteError(_WHERE_, "Error writing the poses of SDfile record "
+                                  "#" +
+                                      std::to_string(iRec + 1) +
+                                      " to the duplicates file");
+  }
+  structure.bDone = true;
+  structure.nFileOffset = m_nDuplicatesFileBytes;
+  structure.nLineBytes = strLines.size();
+  structure.nPoseBytes = strPoses.size();
+  m_nDuplicatesFileBytes += strLines.size() + strPoses.size();
+  for (const std::pair<std::size_t, FileRecList> &duplicate :
+       structure.waiting) {
+    duplicatePoses.push_back(std::make_pair(
+        duplicate.first,
+        GetDuplicatePoses(strPoses, lineRecs, duplicate.second, iRec)));
+  }
+  std::vector<std::pair<std::size_t, FileRecList>>().swap(structure.waiting);
+  std::sort(duplicatePoses.begin(), duplicatePoses.end(),
+            [](const std::pair<std::size_t, std::string> &a,
+               const std::pair<std::size_t, std::string> &b) {
+              return a.first < b.first;
+            });
+  return duplicatePoses;
+}
+
+// Returns the response header of record iRec when serving, which gives the
+// number of poses that follow it as SD records, and an empty string otherwise
+std::string DockingJob::GetResponseHeader(std::size_t iRec,
+                                          const FileRecList &lineRecs,
+                                          bool bDocked,
+                                          std::size_t nPoses) const {
+  if (!m_bServe) {
+    return std::string();
+  }
+  json header;
+  header["record"] = iRec + 1;
+  header["name"] = lineRecs.empty() ? "" : lineRecs.front();
+  header["docked"] = bDocked;
+  header["poses"] = nPoses;
+  // Invalid UTF-8 in the title line must not stop the session
+  return header.dump(-1, ' ', false, json::error_handler_t::replace) + "\n";
+}
+
+// Adds a ligand docked in recordDuration to the totals, reporting the average
+// duration and the estimated end of the job every 10th record. Called by one
+// docking thread at a time
+void DockingJob::ReportLigand(std::size_t iRec, bool bUnnamed, bool bLigandOK,
+                              std::chrono::duration<double> recordDuration,
+                              std::ostream &log) {
+  if (bUnnamed) {
+    m_nUnnamedLigands++;
+  }
+  if (!bLigandOK) {
+    m_nFailedLigands++;
+    return;
+  }
+  fmt::print(log, "Ligand docking duration:      {} second(s)\n",
+             recordDuration.count());
+  m_totalDuration += recordDuration;
+  // report average every 10th record starting from the 1st
+  // iRec ligand is done here so the number of docked ligands is iRec + 1, of
+  // which nResumeRecords before resuming
+  std::size_t nDocked = iRec + 1 - m_nResumeRecords;
+  if (iRec % 10 != 0) {
+    return;
+  }
+  fmt::print(log, "\nAverage duration per ligand:  {} second(s)\n",
+             m_totalDuration.count() / static_cast<double>(nDocked));
+  if (m_spMdlFileSource.Null()) {
+    return;
+  }
+  std::size_t estNumRecords;
+#pragma omp critical(recordInput)
+  estNumRecords = m_spMdlFileSource->GetEstimatedNumRecords();
+  if (estNumRecords > m_nResumeRecords) {
+    // The ligands are docked nThreads at a time
+    std::chrono::duration<double> estimatedTimeRemaining =
+        (estNumRecords - m_nResumeRecords) *
+        (m_totalDuration / static_cast<double>(nDocked)) /
+        static_cast<double>(m_options.nThreads);
+    std::chrono::system_clock::time_point loopEnd =
+        m_loopBegin + std::chrono::duration_cast<std::chrono::seconds>(
+                          estimatedTimeRemaining);
+    std::time_t loopEndTime = std::chrono::system_clock::to_time_t(loopEnd);
+    fmt::print(log,
+               "Approximately {} record(s) remaining, will finish {:%c}\n",
+               estNumRecords - (iRec + 1), fmt::localtime(loopEndTime));
+  }
+}
+
+// Docks record iRec with the contexts of the calling docking thread, and
+// submits its poses, followed by those of the duplicates of it that are
+// waiting for them
+void DockingJob::DockRecord(std::vector<DockingContext> &contexts,
+                            std::size_t iRec, const FileRecList &lineRecs) {
+  DockingContext &context = contexts.front();
+  MolecularFileSinkPtr spSink = context.spWS->GetSink();
+  // With more than one docking thread the messages for each ligand are
+  // collected and printed together once the ligand is done
+  std::ostringstream logBuffer;
+  std::ostream &log = (m_options.nThreads > 1)
+                          ? static_cast<std::ostream &>(logBuffer)
+                          : std::cout;
+  fmt::print(log, "SDfile record #{}\n", iRec + 1);
+
+  // A duplicate record gets the poses of the first record of its structure,
+  // from the thread docking it if it is not done yet
+  if (SubmitDuplicate(iRec, lineRecs, log)) {
+#pragma omp critical(dockReport)
+    {
+      m_nDuplicateRecords++;
+      std::cout << logBuffer.str() << std::flush;
+    }
+    return;
+  }
+
+  context.spLigandSource->SetRecordLines(lineRecs);
+  Error molStatus = context.spLigandSource->Status();
+  if (!molStatus.isOK()) {
+    fmt::print(log, "{}\n", molStatus.what());
+#pragma omp critical(dockReport)
+    std::cout << logBuffer.str() << std::flush;
+    // Every record has a block in the output, even if it is empty
+    std::vector<std::pair<std::size_t, std::string>> duplicatePoses =
+        CompleteDuplicates(iRec, lineRecs, "");
+    spSink->SubmitBlock(iRec, GetResponseHeader(iRec, lineRecs, false, 0));
+    for (std::pair<std::size_t, std::string> &duplicate : duplicatePoses) {
+      m_spWriter->Submit(duplicate.first, duplicate.second);
+    }
+    return;
+  }
+
+  // A ligand docked before by the same job gets its stored poses, with the
+  // title and input data fields of its record
+  FileRecList storedLineRecs;
+  std::string strPoses;
+  if (!m_spResultCache.Null() &&
+      m_spResultCache->Lookup(lineRecs, storedLineRecs, strPoses)) {
+    fmt::print(log, "Poses read from result cache\n");
+    if (storedLineRecs != lineRecs) {
+      strPoses = GetRecordPoses(strPoses, storedLineRecs, lineRecs, "");
+    }
+    std::vector<std::pair<std::size_t, std::string>> duplicatePoses =
+        CompleteDuplicates(iRec, lineRecs, strPoses);
+    m_spWriter->Submit(iRec, strPoses);
+    for (std::pair<std::size_t, std::string> &duplicate : duplicatePoses) {
+      m_spWriter->Submit(duplicate.first, duplicate.second);
+    }
+#pragma omp critical(dockReport)
+    {
+      m_nCachedLigands++;
+      std::cout << logBuffer.str() << std::flush;
+    }
+    return;
+  }
+
+  auto startTime = std::chrono::high_resolution_clock::now();
+  bool bUnnamed = false;
+  std::size_t nPoses = 0;
+  bool bLigandOK = DockLigand(contexts, lineRecs, iRec, log, bUnnamed, nPoses);
+  auto endTime = std::chrono::high_resolution_clock::now();
+  // A cache that can not be written to only costs the docking of the ligand
+  // again in a later job
+  if (bLigandOK && !m_spResultCache.Null()) {
+    try {
+      m_spResultCache->Store(lineRecs, spSink->GetWriterText());
+    } catch (FileWriteError &e) {
+      fmt::print(log, "{}\n", e.what());
+    }
+  }
+  std::vector<std::pair<std::size_t, std::string>> duplicatePoses =
+      CompleteDuplicates(iRec, lineRecs, spSink->GetWriterText());
+  spSink->SubmitBlock(iRec,
+                      GetResponseHeader(iRec, lineRecs, bLigandOK, nPoses));
+  for (std::pair<std::size_t, std::string> &duplicate : duplicatePoses) {
+    m_spWriter->Submit(duplicate.first, duplicate.second);
+  }
+
+#pragma omp critical(dockReport)
+  {
+    ReportLigand(iRec, bUnnamed, bLigandOK, endTime - startTime, log);
+    std::cout << logBuffer.str() << std::flush;
+  }
+}
+
+// Docks the records returned by readInput until it returns false, with the
+// docking threads of the job, and submits the poses of record i as block i
+// of spWriter. Returns false if docking was aborted, with the error in
+// m_strAbortMessage
+bool DockingJob::DockRecords(AsyncFileWriterPtr spWriter,
+                             const InputReader &readInput) {
+  m_spWriter = spWriter;
+  m_schedule.clear();
+  m_bEndOfInput = false;
+  m_nFailedLigands = 0;
+  m_nUnnamedLigands = 0;
+  m_totalDuration = std::chrono::duration<double>(0.0);
+  m_loopBegin = std::chrono::system_clock::now();
+  return ProcessRecords(
+      m_options.nThreads, spWriter,
+      [&](std::size_t &iRec, FileRecList &lineRecs) {
+        return ReadScheduledRecord(readInput, iRec, lineRecs);
+      },
+      [&](int iThread) -> RecordHandler {
+        // The binding is renewed each time, as the threads of a parallel
+        // region are not guaranteed to be those of the previous one. The
+        // record handler owns it, so each thread gets the CPUs of the job
+        // back once it is done with the records
+        std::size_t iNode = iThread % m_nNodes;
+        std::shared_ptr<ThreadCpusBinding> spBinding;
+        if (!m_numaNodes.empty()) {
+          spBinding = std::make_shared<ThreadCpusBinding>(m_jobCpus);
+          spBinding->Bind(m_numaNodes[iNode]);
+        }
+        std::vector<DockingContext> &contexts = m_threadContexts[iThread];
+        if (contexts.empty()) {
+          contexts.resize(m_options.nRunThreads);
+          contexts.front() = CreateContext(iNode, false);
+        }
+        contexts.front().spWS->GetSink()->SetWriter(spWriter);
+        SetRandInstance(contexts.front().spRand);
+        return [this, &contexts, spBinding](std::size_t iRec,
+                                            FileRecList &lineRecs) {
+          DockRecord(contexts, iRec, lineRecs);
+        };
+      },
+      m_strAbortMessage);
+}
+
+// Docks the ligands of the shard of the options to the output file, resuming
+// from the checkpoint if there is one. Returns false if docking was aborted,
+// with the error printed
+bool DockingJob::DockShard() {
+  m_nResumeRecords = 0;
+  m_nResumeInputOffset = 0;
+  m_nResumeOutputOffset = 0;
+  m_recordEnds.clear();
+  m_structures.clear();
+  m_recordStructures.clear();
+  m_nDuplicatesFileBytes = 0;
+  m_nCachedLigands = 0;
+  m_nDuplicateRecords = 0;
+  ReadCheckpoint();
+  // Resuming truncates the output, which must not be done once another
+  // process has reclaimed the chunk
+  if (m_bChunkStopped) {
+    fmt::print("Stopped docking the chunk, whose lease was lost\n");
+    return false;
+  }
+  AsyncFileWriterPtr spOutputWriter(new AsyncFileWriter(
+      m_options.strOutputMdlFile, GetOutputWindowBytes(m_options.nOutputWindow),
+      m_nResumeRecords, m_nResumeOutputOffset));
+  if (!m_options.strCheckpointFile.empty()) {
+    spOutputWriter->SetCheckpoint(
+        [this](std::size_t nRecords, std::size_t nBytes) {
+          WriteCheckpoint(nRecords, nBytes);
+        },
+        std::chrono::duration<double>(m_options.dCheckpointInterval));
+  }
+  {
+    std::lock_guard<std::mutex> lock(m_outputWriterMutex);
+    m_spOutputWriter = spOutputWriter;
+  }
+  OpenInput();
+  if (m_bDeduplicate) {
+    m_duplicatesFile = std::tmpfile();
+    if (!m_duplicatesFile) {
+      throw FileWriteError(_WHERE_, "Error creating the duplicates file");
+    }
+  }
+  m_nRec = m_nResumeRecords;
+  // MAIN LOOP OVER LIGAND RECORDS
+  bool bDone = DockRecords(spOutputWriter,
+                           [this](std::size_t iRec, FileRecList &lineRecs) {
+                             return ReadFileRecord(iRec, lineRecs);
+                           });
+  if (m_duplicatesFile) {
+    std::fclose(m_duplicatesFile);
+    m_duplicatesFile = nullptr;
+  }
+  // END OF MAIN LOOP OVER LIGAND RECORDS
+  ////////////////////////////////////////////////////
+  {
+    std::lock_guard<std::mutex> lock(m_outputWriterMutex);
+    m_spOutputWriter = AsyncFileWriterPtr();
+  }
+  if (!bDone) {
+    fmt::print("{}\n", m_strAbortMessage);
+    return false;
+  }
+  // Wait for the writer to finish, reporting any error
+  spOutputWriter->Close();
+  PrintSummary();
+  return true;
+}
+
+// Docks the chunks of the spool as they are claimed, with the receptor and
+// scoring function set up once for all of them. Chunk i is docked as shard i
+// to its own output file, and resumed from its checkpoint if the process that
+// claimed it before died. Returns false if docking a chunk failed
+bool DockingJob::DockSpool() {
+  // The processes of a spool must dock the same input with everything the
+  // poses depend on, which the job hash covers, alike
+  WorkSpool spool(m_options.strSpoolDir,
+                  fmt::format("{} {}", m_options.strLigandMdlFile,
+                              support::formatHash(m_nJobHash)),
+                  m_options.nSpoolChunks, m_options.dLeaseTimeout);
+  spool.SetLeaseLost([this] { StopChunk(); });
+  const DockOptions options = m_options;
+  // A compressed output can not be resumed, so such chunks are docked again
+  // from the start
+  bool bCompressed =
+      options.strOutputMdlFile.size() > 3 &&
+      options.strOutputMdlFile.compare(options.strOutputMdlFile.size() - 3, 3,
+                                       ".gz") == 0;
+  std::size_t iChunk = 0;
+  while (true) {
+    m_bChunkStopped = false;
+    if (!spool.Claim(iChunk)) {
+      break;
+    }
+    fmt::print("Docking chunk {} of {} of spool {}\n", iChunk + 1,
+               options.nSpoolChunks, options.strSpoolDir);
+    m_options = options;
+    m_options.strOutputMdlFile =
+        GetChunkFileName(options.strOutputMdlFile, iChunk);
+    m_options.strOutputHistoryFilePrefix = fmt::format(
+        "{}_chunk{}", options.strOutputHistoryFilePrefix, iChunk + 1);
+    m_options.strCheckpointFile =
+        bCompressed ? std::string()
+                    : spool.GetChunkFileName(iChunk, ".checkpoint.json");
+    m_options.bResume = !bCompressed;
+    m_options.iShard = iChunk;
+    m_options.nShards = options.nSpoolChunks;
+    bool bDone = DockShard();
+    m_options = options;
+    if (!bDone) {
+      // A chunk whose lease was lost is left to the process that reclaimed
+      // it, and this process goes on with the other chunks
+      spool.Release();
+      if (!spool.LeaseLost()) {
+        return false;
+      }
+    } else if (!spool.Complete()) {
+      fmt::print("Chunk {} was reclaimed by another process before it was "
+                 "marked as done\n",
+                 iChunk + 1);
+    }
+  }
+  fmt::print("All {} chunks of spool {} are done\n", options.nSpoolChunks,
+             options.strSpoolDir);
+  return true;
+}
+
+// Stops docking the chunk of the spool whose lease was lost: no more records
+// are read, and nothing more is written to its output file and checkpoint,
+// which now belong to the process that reclaimed it. Called by the thread
+// renewing the lease
+void DockingJob::StopChunk() {
+  m_bChunkStopped = true;
+  std::lock_guard<std::mutex> lock(m_outputWriterMutex);
+  if (!m_spOutputWriter.Null()) {
+    m_spOutputWriter->Discard();
+  }
+}
+
+int DockingJob::DockFile() {
+  bool bDone = m_options.strSpoolDir.empty() ? DockShard() : DockSpool();
+  if (!bDone) {
+    return EXIT_FAILURE;
+  }
+  if (!m_spHistoryWriter.Null()) {
+    m_spHistoryWriter->Close();
+  }
+
+  if (m_options.bOutputCrd) {
+    MolecularFileSinkPtr spRecepSink(
+        new CrdFileSink(m_options.strOutputCrdFile,
+                        m_threadContexts.front().front().spWS->GetReceptor()));
+    spRecepSink->Render();
+  }
+  std::cout << std::endl;
+  PrintBibliographyItem(std::cout, "RiboDock2004");
+  PrintBibliographyItem(std::cout, "rDock2014");
+#if !defined(__sun) && !defined(_MSC_VER)
+  PrintBibliographyItem(std::cout, "PCG2014");
+#endif
+  std::cout << std::endl;
+  std::cout << "Thank you for using " << GetProgramName() << " "
+            << GetProgramVersion() << "." << std::endl;
+  return EXIT_SUCCESS;
+}
+
+// Prints the number of ligands docked by DockFile and the time it took
+void DockingJob::PrintSummary() {
+  // FileStatusOK becomes false when nRec, counting from zero, becomes equal
+  // to number of ligands in the file
+  std::size_t nRec = m_nRec;
+  if (m_nResumeRecords > 0) {
+    fmt::print("Skipped {} ligand(s) docked before resuming\n",
+               m_nResumeRecords);
+    nRec -= m_nResumeRecords;
+  }
+  fmt::print("Total number of ligands: {}", nRec);
+  if (m_nFailedLigands > 0)
+    fmt::print(", of which {} failed to dock\n", m_nFailedLigands);
+  else
+    fmt::print(", all ligands docked without errors\n");
+  if (m_nCachedLigands > 0) {
+    fmt::print("Poses of {} ligand(s) read from the result cache\n",
+               m_nCachedLigands);
+    nRec -= m_nCachedLigands;
+  }
+  if (m_nDuplicateRecords > 0) {
+    fmt::print("Poses of {} duplicate record(s) copied from the first record "
+               "of their structure\n",
+               m_nDuplicateRecords);
+    nRec -= m_nDuplicateRecords;
+  }
+
+  std::chrono::duration<double> totalDuration = m_totalDuration;
+  if (nRec - m_nFailedLigands > 0) {
+    auto hTotal = std::chrono::duration_cast<std::chrono::hours>(totalDuration);
+    totalDuration -= hTotal;
+    auto mTotal =
+        std::chrono::duration_cast<std::chrono::minutes>(totalDuration);
+    totalDuration -= mTotal;
+
+    fmt::print("\nDocking duration for {} ligand(s): ",
+               nRec - m_nFailedLigands);
+
+    if (hTotal.count() > 0) {
+      fmt::print("{} hour(s), ", hTotal.count());
+    }
+    if (hTotal.count() > 0 || mTotal.count() > 0) {
+      fmt::print("{} minute(s), ", mTotal.count());
+    }
+    fmt::print("{} second(s)\n", totalDuration.count());
+  }
+
+  if (m_nUnnamedLigands > 0) {
+    fmt::print("Warning: {} ligand(s) are unnamed. Post-processing tools "
+               "might have an issue correctly identifying different poses of "
+               "the same ligand.\n",
+               m_nUnnamedLigands);
+  }
+}
+
+#ifndef _WIN32
+// Docks the records sent by a client session on inFd, numbered from 1, and
+// writes the responses to outStream in the same order. The session ends once
+// the client closes inFd, or with dTimeout > 0 once it has been idle for
+// dTimeout seconds (see RequestReader). Returns false if the session was
+// aborted
+bool DockingJob::ServeSession(int inFd, std::FILE *outStream,
+                              double dTimeout) {
+  m_nRec = 0;
+  // The ready line tells the client that anything before it (such as the
+  // banner of the command-line interface) is not a response
+  json ready;
+  ready["ready"] = true;
+  fmt::print(outStream, "{}\n", ready.dump());
+  std::fflush(outStream);
+  AsyncFileWriterPtr spWriter(
+      new AsyncFileWriter(outStream,
+                          GetOutputWindowBytes(m_options.nOutputWindow)));
+  std::string strInputError;
+  bool bDone;
+  {
+    RequestReader reader(inFd, spWriter,
+                         GetOutputWindowBytes(m_options.nOutputWindow),
+                         dTimeout);
+    bDone = DockRecords(spWriter, [&](std::size_t, FileRecList &lineRecs) {
+      return reader.Next(lineRecs);
+    });
+    strInputError = reader.GetError();
+  }
+  if (bDone) {
+    try {
+      spWriter->Close();
+    } catch (Error &e) {
+      m_strAbortMessage = e.what();
+      bDone = false;
+    }
+  }
+  if (!bDone) {
+    fmt::print("Session ended: {}\n", m_strAbortMessage);
+  } else {
+    if (!strInputError.empty()) {
+      fmt::print("{}\n", strInputError);
+    }
+    fmt::print("Session ended: {} ligand(s), of which {} failed to dock\n",
+               m_nRec, m_nFailedLigands);
+  }
+  return bDone;
+}
+
+int DockingJob::Serve(const std::string &strSocket, int protocolFd,
+                      double dTimeout) {
+  if (strSocket.empty()) {
+    std::FILE *outStream = fdopen(protocolFd, "w");
+    if (!outStream) {
+      throw FileWriteError(_WHERE_, "Error opening standard output");
+    }
+    fmt::print("Serving ligands from standard input\n");
+    bool bDone = ServeSession(STDIN_FILENO, outStream, 0.0);
+    std::fclose(outStream);
+    return bDone ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+  // A client that disconnects early must only end its own session. The
+  // sessions are served one at a time, with all the docking threads, and the
+  // clients that connect meanwhile wait for their turn
+  std::signal(SIGPIPE, SIG_IGN);
+  int listenFd = ListenOnSocket(strSocket);
+  fmt::print("Serving ligands on {}\n", strSocket);
+  std::cout << std::flush;
+  while (true) {
+    int connFd = accept(listenFd, nullptr, nullptr);
+    if (connFd < 0) {
+      if (errno == EINTR || errno == ECONNABORTED) {
+        continue;
+      }
+      throw FileReadError(_WHERE_,
+                          fmt::format("Error accepting on {}: {}", strSocket,
+                                      std::strerror(errno)));
+    }
+    int outFd = dup(connFd);
+    std::FILE *outStream = (outFd < 0) ? nullptr : fdopen(outFd, "w");
+    if (outStream) {
+      fmt::print("Session started\n");
+      std::cout << std::flush;
+      ServeSession(connFd, outStream, dTimeout);
+      std::fclose(outStream);
+    } else if (outFd >= 0) {
+      close(outFd);
+    }
+    close(connFd);
+    std::cout << std::flush;
+  }
+}
+#endif
+
+// Docks the ligand of the current record of pSource against each receptor in
+// turn, with the contexts of the calling thread, one per receptor, writing the
+// progress messages to log. Returns false if the ligand could not be docked
+bool CrossDockLigand(std::vector<DockingContext> &contexts,
+                     const std::vector<DockingContext> &templateContexts,
+                     const DockOptions &options,
+                     BaseMolecularFileSource *pSource, std::size_t iRec,
+                     std::ostream &log) {
+  bool bLigandError = false;
+  try {
+    // DM 26 Jul 1999 - only read the largest segment (guaranteed to be called
+    // H)
+    pSource->SetSegmentFilterMap(ConvertStringToSegmentMap("H"));
+    // The ligand is created without a docking site, and made flexible within
+    // the docking site of each receptor in turn
+    ModelPtr spLigand =
+        PRMFactory(contexts.front().spRecepPrmSource).CreateLigand(pSource);
+    AtomList atomList = spLigand->GetAtomList();
+    CoordList loadedCoords = GetCoordList(atomList);
+    StringVariantMap loadedData = spLigand->GetDataMap();
+
+    for (std::size_t iReceptor = 0; iReceptor < contexts.size();
+         iReceptor++) {
+      DockingContext &context = contexts[iReceptor];
+      SetRandInstance(context.spRand);
+      // The ligand starts from the record for each receptor
+      for (std::size_t iAtom = 0; iAtom < atomList.size(); iAtom++) {
+        atomList[iAtom]->SetCoords(loadedCoords[iAtom]);
+      }
+      spLigand->ClearAllDataFields();
+      for (StringVariantMapConstIter iter = loadedData.begin();
+           iter != loadedData.end(); ++iter) {
+        spLigand->SetDataValue(iter->first, iter->second);
+      }
+      PRMFactory(context.spRecepPrmSource, context.spWS->GetDockingSite())
+          .SetLigandFlexData(spLigand);
+      context.spWS->SetLigand(spLigand);
+      context.spWS->UpdateModelCoordsFromChromRecords(pSource);
+      SetProgramFields(spLigand, GetProgramFields(context));
+      context.startCoords.resize(context.spWS->GetNumModels());
+      context.startCoords[1] = GetCoordList(atomList);
+      fmt::print(log, "Receptor: {}\n",
+                 context.spRecepPrmSource->GetFileName());
+
+      // Dock the runs one after the other, seeded as by dock so that the
+      // poses do not depend on the other receptors
+      FilterPtr spFilter = context.spFilter;
+      std::size_t iRun = 0;
+      std::size_t iAttempt = 0;
+      std::size_t nErrors = 0;
+      bool bTargetMet = (options.nDockingRuns < 1);
+      while (!bTargetMet) {
+        if (nErrors > 10) {
+          fmt::print(log,
+                     "Target not met, but giving up on ligand after {} "
+                     "errors\n",
+                     nErrors);
+          bLigandError = true;
+          break;
+        }
+        try {
+          context.spWS->SetMobileCoords(context.startCoords);
+          context.spSF->CopyTreeParameters(*templateContexts[iReceptor].spSF);
+          if (options.bSeed) {
+            context.spRand->SeedStream(options.nSeed, iRec, iAttempt);
+          }
+          iAttempt++;
+          context.spWS->Run(); // Dock!
+          if (spFilter->Terminate()) {
+            bTargetMet = true;
+          }
+          if (spFilter->Write()) {
+            context.spWS->Save();
+          }
+          iRun++;
+        } catch (DockingError &e) {
+          fmt::print(log, "{}\n", e.what());
+          nErrors++;
+        }
+      }
+      fmt::print(log, "Number of docking runs done:  {} ({} errors)\n", iRun,
+                 nErrors);
+    }
+  } catch (LigandError &e) {
+    fmt::print(log, "{}\n", e.what());
+    bLigandError = true;
+  }
+  return !bLigandError;
+}
+
+// Scores the pose in the current record of the ligand source of the context,
+// after running the transforms of the protocol on it (e.g. a minimisation),
+// and returns its output: with bScoresOnly a JSON line with its score fields,
+// otherwise nothing, as the SD record of the pose is saved to the sink of the
+// context
+std::string RescorePose(DockingContext &context,
+                        const DockingContext &templateContext,
+                        const ProgramFields &fields, bool bScoresOnly,
+                        std::size_t iRec) {
+  BaseMolecularFileSource *pSource = context.spLigandSource;
+  // DM 26 Jul 1999 - only read the largest segment (guaranteed to be called
+  // H)
+  pSource->SetSegmentFilterMap(ConvertStringToSegmentMap("H"));
+  PRMFactory prmFactory(context.spRecepPrmSource,
+                        context.spWS->GetDockingSite());
+  ModelPtr spLigand = prmFactory.CreateLigand(pSource);
+  context.spWS->SetLigand(spLigand);
+  context.spWS->UpdateModelCoordsFromChromRecords(pSource);
+  // A flexible receptor or solvent starts from the same coordinates for each
+  // pose, and the scoring function from the protocol parameters
+  context.startCoords.resize(context.spWS->GetNumModels());
+  context.startCoords[1] = GetCoordList(spLigand->GetAtomList());
+  context.spWS->SetMobileCoords(context.startCoords);
+  context.spSF->CopyTreeParameters(*templateContext.spSF);
+  context.spWS->Run();
+
+  if (bScoresOnly) {
+    StringVariantMap scoreMap;
+    context.spSF->ScoreMap(scoreMap);
+    json scores;
+    scores["record"] = iRec + 1;
+    scores["name"] = spLigand->GetName();
+    for (StringVariantMapConstIter iter = scoreMap.begin();
+         iter != scoreMap.end(); ++iter) {
+      scores[iter->first] = iter->second.GetDouble();
+    }
+    return scores.dump(-1, ' ', false, json::error_handler_t::replace) + "\n";
+  }
+  SetProgramFields(spLigand, fields);
+  context.spWS->Save();
+  return std::string();
+}
+
+} // namespace
+} // namespace operation
+} // namespace rxdock
+
+int rxdock::operation::dock(const DockOptions &options) {
+  try {
+    DockingJob job(options, false);
+    return job.DockFile();
+  } catch (Error &e) {
+    SetRandInstance(nullptr);
+    fmt::print("{}\n", e.what());
+    return EXIT_FAILURE;
+  }
+}
+
+int rxdock::operation::serve(const DockOptions &options,
+                             const std::string &strSocket, double dTimeout) {
+#ifdef _WIN32
+  fmt::print("Serving is not supported on Windows\n");
+  return EXIT_FAILURE;
+#else
+  // Without a socket the responses are written to standard output, so
+  // everything else printed goes to standard error instead
+  int protocolFd = -1;
+  if (strSocket.empty()) {
+    std::cout << std::flush;
+    std::fflush(stdout);
+    protocolFd = dup(STDOUT_FILENO);
+    if (protocolFd < 0 || dup2(STDERR_FILENO, STDOUT_FILENO) < 0) {
+      fmt::print(stderr, "Error redirecting standard output\n");
+      return EXIT_FAILURE;
+    }
+  }
+  // The ligands come from the clients and the poses go back to them
+  DockOptions serveOptions = options;
+  serveOptions.strLigandMdlFile.clear();
+  serveOptions.strOutputMdlFile.clear();
+  serveOptions.bOutputCrd = false;
+  serveOptions.bOutputHistory = false;
+  serveOptions.strCheckpointFile.clear();
+  serveOptions.bResume = false;
+  serveOptions.iShard = 0;
+  serveOptions.nShards = 1;
+  serveOptions.strSpoolDir.clear();
+  serveOptions.nScheduleWindow = 0;
+  serveOptions.strCacheDir.clear();
+  serveOptions.strDuplicateMatch.clear();
+  try {
+    DockingJob job(serveOptions, true);
+    return job.Serve(strSocket, protocolFd, dTimeout);
+  } catch (Error &e) {
+    SetRandInstance(nullptr);
+    fmt::print("{}\n", e.what());
+    return EXIT_FAILURE;
+  }
+#endif
+}
+
+int rxdock::operation::crossDock(
+    const DockOptions &options,
+    const std::vector<std::string> &receptorPrmFiles) {
+  try {
+    if (receptorPrmFiles.empty()) {
+      throw BadArgument(_WHERE_, "Cross-docking needs at least one receptor");
+    }
+    std::size_t nThreads = GetNumThreads(options.nThreads);
+#ifndef _OPENMP
+    if (nThreads != 1) {
+      fmt::print("Built without OpenMP support, docking with a single "
+                 "thread\n");
+      nThreads = 1;
+    }
+#endif
+    std::string strFilter;
+    if (!options.bFilter) {
+      strFilter =
+          GetFilterString(options.bTarget, options.dTargetScore,
+                          options.bDockingRuns, options.nDockingRuns,
+                          options.bContinue);
+    }
+
+    // Create the template context of each receptor, from which each docking
+    // thread clones its own context for the receptor
+    std::vector<DockingContext> templateContexts;
+    for (const std::string &strReceptorPrmFile : receptorPrmFiles) {
+      std::string wsName =
+          ConvertDelimitedStringToList(strReceptorPrmFile, ".").front();
+      templateContexts.push_back(CreateDockingContext(
+          wsName, options.strParamFile, strReceptorPrmFile,
+          ReadDockingSite(wsName), MolecularFileSinkPtr(), FilterPtr(), true));
+    }
+    SetRandInstance(nullptr);
+
+    fmt::print("Cross-docking against {} receptor(s)", receptorPrmFiles.size());
+    if (nThreads > 1) {
+      fmt::print(" with {} threads", nThreads);
+    }
+    fmt::print("\n");
+
+    AsyncFileWriterPtr spWriter(
+        new AsyncFileWriter(options.strOutputMdlFile,
+                            GetOutputWindowBytes(options.nOutputWindow)));
+    MolecularFileSourcePtr spMdlFileSource(
+        new MdlFileSource(options.strLigandMdlFile, options.bPosIonise,
+                          options.bNegIonise, !options.bExplH));
+    std::size_t nRec = 0;
+    std::size_t nFailedLigands = 0;
+    std::string strAbortMessage;
+    bool bDone = ProcessRecords(
+        nThreads, spWriter, ReadSourceRecords(spMdlFileSource, nRec),
+        [&](int) -> RecordHandler {
+          // Each docking thread has a context for each receptor. The ligand
+          // of a record is parsed once by the ligand source of the thread,
+          // and the poses against all the receptors go to the SD file sink
+          // of the thread
+          MolecularFileSinkPtr spSink(
+              new MdlFileSink(options.strOutputMdlFile, ModelPtr()));
+          spSink->SetWriter(spWriter);
+          MolecularFileSourcePtr spLigandSource(
+              new MdlFileSource(options.strLigandMdlFile, options.bPosIonise,
+                                options.bNegIonise, !options.bExplH));
+          std::vector<DockingContext> contexts;
+          for (DockingContext &templateContext : templateContexts) {
+            contexts.push_back(CloneDockingContext(
+                templateContext, spSink,
+                CreateFilter(options.bFilter, options.strFilterFile,
+                             options.bDockingRuns, options.nDockingRuns,
+                             strFilter)));
+            if (options.bSeed) {
+              contexts.back().spRand->Seed(options.nSeed);
+            }
+          }
+          return [&, spSink, spLigandSource,
+                  contexts](std::size_t iRec,
+                            FileRecList &lineRecs) mutable {
+            std::ostringstream log;
+            fmt::print(log, "SDfile record #{}\n", iRec + 1);
+            spLigandSource->SetRecordLines(lineRecs);
+            Error molStatus = spLigandSource->Status();
+            bool bLigandOK = molStatus.isOK();
+            if (bLigandOK) {
+              bLigandOK = CrossDockLigand(contexts, templateContexts, options,
+                                          spLigandSource, iRec, log);
+            } else {
+              fmt::print(log, "{}\n", molStatus.what());
+            }
+            // Every record has a block in the output, even if it is empty
+            spSink->SubmitBlock(iRec);
+#pragma omp critical(crossDockReport)
+            {
+              if (!bLigandOK) {
+                nFailedLigands++;
+              }
+              std::cout << log.str() << std::flush;
+            }
+          };
+        },
+        strAbortMessage);
+
+    if (!bDone) {
+      fmt::print("{}\n", strAbortMessage);
+      return EXIT_FAILURE;
+    }
+    // Wait for the writer to finish, reporting any error
+    spWriter->Close();
+    fmt::print("Total number of ligands: {}", nRec);
+    if (nFailedLigands > 0) {
+      fmt::print(", of which {} failed to dock\n", nFailedLigands);
+    } else {
+      fmt::print(", all ligands docked without errors\n");
+    }
+  } catch (Error &e) {
+    SetRandInstance(nullptr);
+    fmt::print("{}\n", e.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int rxdock::operation::rescore(std::string strInputMdlFile,
+                               std::string strOutputFile,
+                               std::string strReceptorPrmFile,
+                               std::string strParamFile, bool bPosIonise,
+                               bool bNegIonise, bool bExplH, bool bScoresOnly,
+                               std::size_t nThreads,
+                               std::size_t nOutputWindow) {
+  try {
+    nThreads = GetNumThreads(nThreads);
+#ifndef _OPENMP
+    if (nThreads != 1) {
+      fmt::print("Built without OpenMP support, rescoring with a single "
+                 "thread\n");
+      nThreads = 1;
+    }
+#endif
+    std::string wsName =
+        ConvertDelimitedStringToList(strReceptorPrmFile, ".").front();
+    DockingContext templateContext = CreateDockingContext(
+        wsName, strParamFile, strReceptorPrmFile, ReadDockingSite(wsName),
+        MolecularFileSinkPtr(), FilterPtr(), true);
+    SetRandInstance(nullptr);
+    ProgramFields fields = GetProgramFields(templateContext);
+
+    if (nThreads > 1) {
+      fmt::print("Rescoring with {} threads\n", nThreads);
+    }
+
+    AsyncFileWriterPtr spWriter(
+        new AsyncFileWriter(strOutputFile,
+                            GetOutputWindowBytes(nOutputWindow)));
+    MolecularFileSourcePtr spMdlFileSource(
+        new MdlFileSource(strInputMdlFile, bPosIonise, bNegIonise, !bExplH));
+    std::size_t nRec = 0;
+    std::size_t nFailedPoses = 0;
+    std::string strAbortMessage;
+    bool bDone = ProcessRecords(
+        nThreads, spWriter, ReadSourceRecords(spMdlFileSource, nRec),
+        [&](int) -> RecordHandler {
+          // Each thread scores the poses with its own workspace. The SD
+          // records are rendered by the sink of the thread, the score lines
+          // are submitted to the writer directly
+          MolecularFileSinkPtr spSink;
+          if (!bScoresOnly) {
+            spSink = new MdlFileSink(strOutputFile, ModelPtr());
+            spSink->SetWriter(spWriter);
+          }
+          DockingContext context =
+              CloneDockingContext(templateContext, spSink, FilterPtr());
+          context.spLigandSource = new MdlFileSource(
+              strInputMdlFile, bPosIonise, bNegIonise, !bExplH);
+          return [&, spSink, context](std::size_t iRec,
+                                      FileRecList &lineRecs) mutable {
+            // Only the poses that fail are reported, as there may be
+            // millions of them
+            std::string strError;
+            std::string strOutput;
+            context.spLigandSource->SetRecordLines(lineRecs);
+            Error molStatus = context.spLigandSource->Status();
+            if (molStatus.isOK()) {
+              try {
+                strOutput = RescorePose(context, templateContext, fields,
+                                        bScoresOnly, iRec);
+              } catch (LigandError &e) {
+                strError = e.what();
+              } catch (DockingError &e) {
+                strError = e.what();
+              }
+            } else {
+              strError = molStatus.what();
+            }
+            // Every record has a block in the output, even if it is empty
+            if (bScoresOnly || !strError.empty()) {
+              spWriter->Submit(iRec, strOutput);
+            } else {
+              spSink->SubmitBlock(iRec);
+            }
+            if (!strError.empty()) {
+#pragma omp critical(rescoreReport)
+              {
+                nFailedPoses++;
+                fmt::print("SDfile record #{}: {}\n", iRec + 1, strError);
+              }
+            }
+          };
+        },
+        strAbortMessage);
+
+    if (!bDone) {
+      fmt::print("{}\n", strAbortMessage);
+      return EXIT_FAILURE;
+    }
+    // Wait for the writer to finish, reporting any error
+    spWriter->Close();
+    fmt::print("Total number of poses: {}", nRec);
+    if (nFailedPoses > 0) {
+      fmt::print(", of which {} failed to rescore\n", nFailedPoses);
+    } else {
+      fmt::print(", all poses rescored without errors\n");
+    }
   } catch (Error &e) {
+    SetRandInstance(nullptr);
     fmt::print("{}\n", e.what());
     return EXIT_FAILURE;
   }
@@ -0,0 +1,33 @@
+//===-- Hash.cxx - Non-cryptographic hashing --------------------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Non-cryptographic hashing.
+///
+//===----------------------------------------------------------------------===//
+
+#include "rxdock/support/Hash.h"
+
+#include <fmt/format.h>
+
+std::uint64_t rxdock::support::hashFNV1a(const std::string &text,
+                                         std::uint64_t hash) {
+  for (unsigned char c : text) {
+    hash ^= c;
+    hash *= fnv1aPrime;
+  }
+  return hash;
+}
+
+std::string rxdock::support::formatHash(std::uint64_t hash) {
+  return fmt::format("{:016x}", hash);
+}
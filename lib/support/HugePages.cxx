@@ -0,0 +1,136 @@
+//===-- HugePages.cxx - Huge page backed allocation -------------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Huge page backed allocation for large, randomly accessed arrays.
+///
+//===----------------------------------------------------------------------===//
+
+#include "rxdock/support/HugePages.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+namespace {
+
+// Each allocation starts with a header recording how to free it. The header
+// takes a whole cache line, so the memory returned stays as aligned as the
+// memory allocated
+struct AllocationHeader {
+  void *pBase;              // Start of the allocated memory
+  std::size_t nMappedBytes; // Size of the mapping, or 0 if from the heap
+};
+const std::size_t headerSize = 64;
+static_assert(sizeof(AllocationHeader) <= headerSize,
+              "The allocation header must fit in its cache line");
+
+const std::size_t hugePageSize = 2 * 1024 * 1024;
+
+std::atomic<int> hugePageMode(rxdock::support::HUGE_PAGES_OFF);
+
+void *setHeader(void *pBase, std::size_t nMappedBytes) {
+  AllocationHeader *pHeader = static_cast<AllocationHeader *>(pBase);
+  pHeader->pBase = pBase;
+  pHeader->nMappedBytes = nMappedBytes;
+  return static_cast<char *>(pBase) + headerSize;
+}
+
+#ifdef __linux__
+// Maps nBytes (a multiple of the huge page size) of memory backed by huge
+// pages, or returns nullptr if it can not be mapped
+void *mapHugePages(std::size_t nBytes, bool bExplicit) {
+#ifdef MAP_HUGETLB
+  if (bExplicit) {
+    void *p = mmap(nullptr, nBytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (p != MAP_FAILED) {
+      return p;
+    }
+  }
+#endif
+  // Transparent huge pages only back the 2 MB aligned pages of a mapping, so
+  // map an extra huge page and trim the mapping to the aligned part
+  std::size_t nMapBytes = nBytes + hugePageSize;
+  void *p = mmap(nullptr, nMapBytes, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) {
+    return nullptr;
+  }
+  char *pMap = static_cast<char *>(p);
+  std::uintptr_t address = reinterpret_cast<std::uintptr_t>(pMap);
+  std::size_t nHead = (hugePageSize - address % hugePageSize) % hugePageSize;
+  char *pAligned = pMap + nHead;
+  if (nHead > 0) {
+    munmap(pMap, nHead);
+  }
+  munmap(pAligned + nBytes, nMapBytes - nHead - nBytes);
+#ifdef MADV_HUGEPAGE
+  // Only advice: without transparent huge page support the memory is still
+  // usable with regular pages
+  madvise(pAligned, nBytes, MADV_HUGEPAGE);
+#endif
+  return pAligned;
+}
+#endif
+
+} // namespace
+
+void rxdock::support::setHugePageMode(HugePageMode mode) {
+  hugePageMode = mode;
+}
+
+rxdock::support::HugePageMode rxdock::support::getHugePageMode() {
+  return static_cast<HugePageMode>(hugePageMode.load());
+}
+
+void *rxdock::support::allocateHugePages(std::size_t nBytes) {
+  if (nBytes > std::numeric_limits<std::size_t>::max() - 2 * hugePageSize) {
+    throw std::bad_alloc();
+  }
+  std::size_t nTotalBytes = nBytes + headerSize;
+#ifdef __linux__
+  HugePageMode mode = getHugePageMode();
+  if (mode != HUGE_PAGES_OFF && nBytes >= hugePageSize) {
+    std::size_t nMappedBytes =
+        (nTotalBytes + hugePageSize - 1) / hugePageSize * hugePageSize;
+    void *p = mapHugePages(nMappedBytes, mode == HUGE_PAGES_EXPLICIT);
+    if (p) {
+      return setHeader(p, nMappedBytes);
+    }
+  }
+#endif
+  void *p = std::malloc(nTotalBytes);
+  if (!p) {
+    throw std::bad_alloc();
+  }
+  return setHeader(p, 0);
+}
+
+void rxdock::support::deallocateHugePages(void *p) {
+  if (!p) {
+    return;
+  }
+  AllocationHeader *pHeader = reinterpret_cast<AllocationHeader *>(
+      static_cast<char *>(p) - headerSize);
+#ifdef __linux__
+  if (pHeader->nMappedBytes > 0) {
+    munmap(pHeader->pBase, pHeader->nMappedBytes);
+    return;
+  }
+#endif
+  std::free(pHeader->pBase);
+}
@@ -0,0 +1,131 @@
+//===-- Numa.cxx - NUMA topology and thread placement -----------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// NUMA topology and thread placement.
+///
+//===----------------------------------------------------------------------===//
+
+#include "rxdock/support/Numa.h"
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#ifdef __linux__
+// Parses a Linux CPU list, such as "0-3,8-11", into CPU numbers. Returns an
+// empty list if the text is not a CPU list
+static std::vector<int> parseCpuList(const std::string &strCpuList) {
+  std::vector<int> cpus;
+  std::istringstream istr(strCpuList);
+  std::string strRange;
+  while (std::getline(istr, strRange, ',')) {
+    if (strRange.empty()) {
+      continue;
+    }
+    int nFirst = 0;
+    int nLast = 0;
+    char cDash = 0;
+    std::istringstream rangeStr(strRange);
+    if (!(rangeStr >> nFirst)) {
+      return std::vector<int>();
+    }
+    nLast = nFirst;
+    if ((rangeStr >> cDash) && (cDash != '-' || !(rangeStr >> nLast))) {
+      return std::vector<int>();
+    }
+    for (int iCpu = nFirst; iCpu <= nLast; iCpu++) {
+      cpus.push_back(iCpu);
+    }
+  }
+  return cpus;
+}
+#endif
+
+std::vector<std::vector<int>> rxdock::support::getNumaNodeCpus() {
+  std::vector<std::vector<int>> nodes;
+#ifdef __linux__
+  cpu_set_t allowed;
+  CPU_ZERO(&allowed);
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+    return nodes;
+  }
+  // Node numbers may have gaps, so look a bit beyond the last node found
+  for (int iNode = 0, nMissing = 0; nMissing < 64; iNode++) {
+    std::ifstream cpuListFile("/sys/devices/system/node/node" +
+                              std::to_string(iNode) + "/cpulist");
+    if (!cpuListFile) {
+      nMissing++;
+      continue;
+    }
+    nMissing = 0;
+    std::string strCpuList;
+    std::getline(cpuListFile, strCpuList);
+    std::vector<int> cpus;
+    for (int iCpu : parseCpuList(strCpuList)) {
+      if (iCpu < CPU_SETSIZE && CPU_ISSET(iCpu, &allowed)) {
+        cpus.push_back(iCpu);
+      }
+    }
+    if (!cpus.empty()) {
+      nodes.push_back(cpus);
+    }
+  }
+  if (nodes.empty()) {
+    std::vector<int> cpus;
+    for (int iCpu = 0; iCpu < CPU_SETSIZE; iCpu++) {
+      if (CPU_ISSET(iCpu, &allowed)) {
+        cpus.push_back(iCpu);
+      }
+    }
+    nodes.push_back(cpus);
+  }
+#endif
+  return nodes;
+}
+
+bool rxdock::support::bindThreadToCpus(const std::vector<int> &cpus) {
+#ifdef __linux__
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  for (int iCpu : cpus) {
+    if (iCpu >= 0 && iCpu < CPU_SETSIZE) {
+      CPU_SET(iCpu, &cpuSet);
+    }
+  }
+  return CPU_COUNT(&cpuSet) > 0 &&
+         sched_setaffinity(0, sizeof(cpuSet), &cpuSet) == 0;
+#else
+  (void)cpus;
+  return false;
+#endif
+}
+
+std::vector<int> rxdock::support::getThreadCpus() {
+  std::vector<int> cpus;
+#ifdef __linux__
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  if (sched_getaffinity(0, sizeof(cpuSet), &cpuSet) == 0) {
+    for (int iCpu = 0; iCpu < CPU_SETSIZE; iCpu++) {
+      if (CPU_ISSET(iCpu, &cpuSet)) {
+        cpus.push_back(iCpu);
+      }
+    }
+  }
+#endif
+  return cpus;
+}
@@ -0,0 +1,118 @@
+#include "AsyncFileWriterTest.h"
+#include "rxdock/AsyncFileWriter.h"
+#include "rxdock/FileError.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+void AsyncFileWriterTest::SetUp() {}
+
+void AsyncFileWriterTest::TearDown() {
+  for (std::vector<std::string>::const_iterator iter = m_files.begin();
+       iter != m_files.end(); ++iter) {
+    std::remove(iter->c_str());
+  }
+  m_files.clear();
+}
+
+std::string AsyncFileWriterTest::GetTestFileName(const std::string &strName) {
+  m_files.push_back(strName);
+  return strName;
+}
+
+std::string AsyncFileWriterTest::ReadFile(const std::string &strFile) const {
+  std::ifstream file(strFile.c_str());
+  std::stringstream fileStream;
+  fileStream << file.rdbuf();
+  return fileStream.str();
+}
+
+// Blocks submitted by several threads in any order are written in block order
+TEST_F(AsyncFileWriterTest, BlockOrder) {
+  const int nThreads = 4;
+  const int nBlocks = 200;
+  std::string strFile = GetTestFileName("async_writer_order.txt");
+  {
+    AsyncFileWriter writer(strFile, 1 << 20);
+    std::vector<std::thread> threads;
+    for (int iThread = 0; iThread < nThreads; iThread++) {
+      // Each thread submits its blocks last to first
+      threads.push_back(std::thread([&writer, iThread] {
+        for (int iBlock = nBlocks - nThreads + iThread; iBlock >= 0;
+             iBlock -= nThreads) {
+          writer.Submit(iBlock, std::to_string(iBlock) + "\n");
+        }
+      }));
+    }
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+    writer.Close();
+  }
+  std::string strExpected;
+  for (int iBlock = 0; iBlock < nBlocks; iBlock++) {
+    strExpected += std::to_string(iBlock) + "\n";
+  }
+  EXPECT_EQ(ReadFile(strFile), strExpected);
+}
+
+// A block that does not fit in the window waits until the blocks before it
+// are written, while the next block to write is always accepted
+TEST_F(AsyncFileWriterTest, WindowBackpressure) {
+  std::string strFile = GetTestFileName("async_writer_window.txt");
+  AsyncFileWriter writer(strFile, 10);
+  writer.Submit(1, "block 1\n"); // 8 bytes, fits in the window
+  std::atomic<bool> bSubmitted(false);
+  std::thread thread([&writer, &bSubmitted] {
+    writer.Submit(2, "block 2\n"); // 16 bytes pending with block 1
+    bSubmitted = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  EXPECT_FALSE(bSubmitted);
+  // Larger than the whole window, but the next block to write
+  writer.Submit(0, "the first block\n");
+  thread.join();
+  EXPECT_TRUE(bSubmitted);
+  writer.Close();
+  EXPECT_EQ(ReadFile(strFile), "the first block\nblock 1\nblock 2\n");
+}
+
+// Closing writes the blocks after a missing one, in block order
+TEST_F(AsyncFileWriterTest, CloseWithGap) {
+  std::string strFile = GetTestFileName("async_writer_gap.txt");
+  AsyncFileWriter writer(strFile, 1 << 20);
+  writer.Submit(3, "3\n");
+  writer.Submit(0, "0\n");
+  writer.Submit(2, "2\n");
+  writer.Close();
+  EXPECT_EQ(ReadFile(strFile), "0\n2\n3\n");
+  EXPECT_THROW(writer.Submit(4, "4\n"), FileWriteError);
+}
+
+// A writer without a file of its own writes each block to its own file
+TEST_F(AsyncFileWriterTest, FilePerBlock) {
+  const int nFiles = 20;
+  std::vector<std::string> files;
+  for (int iFile = 0; iFile < nFiles; iFile++) {
+    files.push_back(
+        GetTestFileName("async_writer_" + std::to_string(iFile) + ".txt"));
+  }
+  // The first file is overwritten
+  std::ofstream(files.front().c_str()) << "stale contents\n";
+  AsyncFileWriter writer(16);
+  EXPECT_THROW(writer.Submit(0, "text\n"), FileWriteError);
+  for (int iFile = 0; iFile < nFiles; iFile++) {
+    writer.SubmitFile(files[iFile], "file " + std::to_string(iFile) + "\n");
+  }
+  writer.Close();
+  for (int iFile = 0; iFile < nFiles; iFile++) {
+    EXPECT_EQ(ReadFile(files[iFile]), "file " + std::to_string(iFile) + "\n");
+  }
+}
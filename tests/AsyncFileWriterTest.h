@@ -0,0 +1,36 @@
+// Unit tests for AsyncFileWriter
+//
+// Required input files:
+// None: the tests write their own files to the current directory
+#ifndef ASYNCFILEWRITERTEST_H_
+#define ASYNCFILEWRITERTEST_H_
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace rxdock {
+
+namespace unittest {
+
+class AsyncFileWriterTest : public ::testing::Test {
+protected:
+  // TextFixture methods
+  void SetUp() override;
+  void TearDown() override;
+
+  // Returns the name of a file for a test to create, which is removed in
+  // TearDown
+  std::string GetTestFileName(const std::string &strName);
+  // Returns the contents of a file
+  std::string ReadFile(const std::string &strFile) const;
+
+  std::vector<std::string> m_files; // Files to remove in TearDown
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*ASYNCFILEWRITERTEST_H_*/
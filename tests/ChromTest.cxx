@@ -447,6 +447,40 @@ TEST_F(ChromTest, PopulationGAstep) {
   }
 }
 
+// 45) Check that population SteadyStateStep does not decrease the score of
+// the best genome, and keeps the population full, sorted by score and free of
+// equal genomes
+TEST_F(ChromTest, PopulationSteadyStateStep) {
+  setupWorkSpace();
+  int popSize = 100;
+  int nIter = 100;
+  double equalityThreshold = 1.0E-2;
+  double relStepSize = 1.0;
+  double pcross = 0.4;
+  bool xovermut = true;
+  bool cmutate = false;
+  PopulationPtr pop = new Population(m_chrom_1koc, popSize, m_SF);
+  double lastScore = pop->Best()->GetScore();
+  isGenome_eq isEqual(equalityThreshold);
+  for (int i = 0; i < nIter; ++i) {
+    // Odd batch sizes too, which create a child by mutation alone
+    ASSERT_NO_THROW(pop->SteadyStateStep(1 + i % 4, relStepSize,
+                                         equalityThreshold, pcross, xovermut,
+                                         cmutate));
+    double score = pop->Best()->GetScore();
+    ASSERT_GE(score, lastScore);
+    lastScore = score;
+    const GenomeList &genomeList = pop->GetGenomeList();
+    ASSERT_EQ(genomeList.size(), static_cast<std::size_t>(popSize));
+    for (std::size_t j = 1; j < genomeList.size(); j++) {
+      ASSERT_GE(genomeList[j - 1]->GetScore(), genomeList[j]->GetScore());
+      ASSERT_FALSE(isEqual(genomeList[j - 1], genomeList[j]));
+    }
+  }
+  ASSERT_LT(std::fabs(pop->GetGenomeList().back()->GetRWFitness() - 1.0),
+            TINY);
+}
+
 // 29) Checks the behaviour of Model::GetChrom if flex data has not been
 // defined Should return a zero length chromosome for rigid model
 TEST_F(ChromTest, ModelGetChromUndefinedFlexData) {
@@ -718,6 +752,84 @@ TEST_F(ChromTest, OccupancyThreshold) {
   ASSERT_LT(std::fabs(enabledProb - occupancyProb), 0.01);
 }
 
+// 43) Checks that a chromosome made of the chromosomes of several models is
+// flat, with the genes of each model in turn
+TEST_F(ChromTest, FlatChrom) {
+  ChromElementPtr ligChrom;
+  ChromElementPtr recChrom;
+  {
+    FlexDataPtr ligFlexData = new LigandFlexData(m_site_1koc);
+    ligFlexData->SetModel(m_lig_1koc);
+    ChromFactory chromFactory;
+    ligFlexData->Accept(chromFactory);
+    ligChrom = chromFactory.GetChrom();
+  }
+  {
+    FlexDataPtr recFlexData = new ReceptorFlexData(m_site_1koc);
+    recFlexData->SetModel(m_recep_1koc);
+    ChromFactory chromFactory;
+    recFlexData->Accept(chromFactory);
+    recChrom = chromFactory.GetChrom();
+  }
+  ASSERT_EQ(m_chrom_1koc->GetLength(),
+            ligChrom->GetLength() + recChrom->GetLength());
+  ASSERT_EQ(m_chrom_1koc->GetXOverLength(),
+            ligChrom->GetXOverLength() + recChrom->GetXOverLength());
+  m_chrom_1koc->Randomise();
+  m_chrom_1koc->SyncToModel();
+  ligChrom->SyncFromModel();
+  recChrom->SyncFromModel();
+  std::vector<double> genes;
+  m_chrom_1koc->GetVector(genes);
+  std::vector<double> modelGenes;
+  ligChrom->GetVector(modelGenes);
+  recChrom->GetVector(modelGenes);
+  ASSERT_EQ(genes.size(), modelGenes.size());
+  for (std::size_t i = 0; i < genes.size(); i++) {
+    ASSERT_NEAR(genes[i], modelGenes[i], TINY);
+  }
+}
+
+// 44) Checks that crossover into separate children gives the same children as
+// crossover through the gene vectors, which is used when the children are the
+// parents
+TEST_F(ChromTest, CrossoverMatchesGeneVectors) {
+  ChromElementPtr parent1 = m_chrom_1koc->clone();
+  ChromElementPtr parent2 = m_chrom_1koc->clone();
+  ChromElementPtr child1 = m_chrom_1koc->clone();
+  ChromElementPtr child2 = m_chrom_1koc->clone();
+  Rand &rand = GetRandInstance();
+  int nMixed = 0; // Children with genes of both parents
+  for (int iTrial = 0; iTrial < 20; iTrial++) {
+    parent1->Randomise();
+    parent2->Randomise();
+    ChromElementPtr vector1 = parent1->clone();
+    ChromElementPtr vector2 = parent2->clone();
+    rand.Seed(iTrial);
+    Crossover(parent1, parent2, child1, child2);
+    rand.Seed(iTrial);
+    Crossover(vector1, vector2, vector1, vector2);
+    std::vector<double> genes;
+    std::vector<double> vectorGenes;
+    child1->GetVector(genes);
+    vector1->GetVector(vectorGenes);
+    ASSERT_EQ(genes, vectorGenes);
+    std::vector<double> parentGenes1;
+    std::vector<double> parentGenes2;
+    parent1->GetVector(parentGenes1);
+    parent2->GetVector(parentGenes2);
+    if (genes != parentGenes1 && genes != parentGenes2) {
+      nMixed++;
+    }
+    genes.clear();
+    vectorGenes.clear();
+    child2->GetVector(genes);
+    vector2->GetVector(vectorGenes);
+    ASSERT_EQ(genes, vectorGenes);
+  }
+  ASSERT_GT(nMixed, 0);
+}
+
 void ChromTest::measureRandOrMutateDiff(ChromElement *chrom, int nTrials,
                                         bool bMutate, double &meanDiff,
                                         double &minDiff, double &maxDiff) {
@@ -0,0 +1,316 @@
+#include "DockTest.h"
+#include "rxdock/Config.h"
+#include "rxdock/support/Numa.h"
+
+#include <nlohmann/json.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using json = nlohmann::json;
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+void DockTest::SetUp() {
+  std::string strRecords[2];
+  const char *ligands[2] = {"1YET_c.sd", "1koc_c.sd"};
+  for (int i = 0; i < 2; i++) {
+    std::ifstream ligandFile(GetDataFileName("", ligands[i]).c_str());
+    std::stringstream ligandStream;
+    ligandStream << ligandFile.rdbuf();
+    std::string strRecord = ligandStream.str();
+    // Skip the title line
+    strRecords[i] = strRecord.substr(strRecord.find('\n') + 1);
+  }
+  m_strInputFile = GetTestFileName("dock_test_in.sd");
+  std::ofstream inputFile(m_strInputFile.c_str());
+  for (int iLig = 0; iLig < 4; iLig++) {
+    inputFile << "lig" << iLig + 1 << "\n" << strRecords[iLig % 2];
+  }
+}
+
+void DockTest::TearDown() {
+  for (std::vector<std::string>::const_iterator iter = m_files.begin();
+       iter != m_files.end(); ++iter) {
+    std::remove(iter->c_str());
+  }
+  m_files.clear();
+}
+
+operation::DockOptions
+DockTest::GetOptions(const std::string &strOutputFile) const {
+  operation::DockOptions options;
+  options.strLigandMdlFile = m_strInputFile;
+  options.strOutputMdlFile = strOutputFile;
+  options.strReceptorPrmFile = GetDataFileName("", "1YET_test.json");
+  options.strParamFile = "dock.json";
+  options.bDockingRuns = true;
+  options.nDockingRuns = 2;
+  options.bSeed = true;
+  options.nSeed = 48151623;
+  return options;
+}
+
+std::string DockTest::ReadFile(const std::string &strFile) const {
+  std::ifstream file(strFile.c_str(), std::ios_base::binary);
+  std::stringstream fileStream;
+  fileStream << file.rdbuf();
+  return fileStream.str();
+}
+
+std::vector<std::string>
+DockTest::ReadRecords(const std::string &strFile) const {
+  std::vector<std::string> records;
+  std::ifstream file(strFile.c_str());
+  std::string strRecord;
+  std::string strLine;
+  int iLine = 0;
+  while (std::getline(file, strLine)) {
+    if (iLine++ != 1) {
+      strRecord += strLine + "\n";
+    }
+    if (strLine == "$$$$") {
+      records.push_back(strRecord);
+      strRecord.clear();
+      iLine = 0;
+    }
+  }
+  return records;
+}
+
+std::string DockTest::GetField(const std::string &strRecord,
+                               const std::string &strField) const {
+  std::string strTag = ">  <" + strField + ">\n";
+  std::size_t iTag = strRecord.find(strTag);
+  if (iTag == std::string::npos) {
+    return "";
+  }
+  std::size_t iValue = iTag + strTag.size();
+  return strRecord.substr(iValue, strRecord.find('\n', iValue) - iValue);
+}
+
+std::string DockTest::GetTestFileName(const std::string &strName) {
+  m_files.push_back(strName);
+  return strName;
+}
+
+// 1 Check that with a seed the poses do not depend on the number of docking,
+// run and scoring threads
+TEST_F(DockTest, ThreadCounts) {
+  std::string strSerialFile = GetTestFileName("dock_test_serial.sd");
+  ASSERT_EQ(operation::dock(GetOptions(strSerialFile)), 0);
+  std::vector<std::string> serialRecords = ReadRecords(strSerialFile);
+  ASSERT_EQ(serialRecords.size(), 8);
+  std::size_t threadCounts[3][3] = {{2, 1, 1}, {1, 2, 1}, {2, 2, 3}};
+  for (int i = 0; i < 3; i++) {
+    std::string strFile = GetTestFileName("dock_test_threads.sd");
+    operation::DockOptions options = GetOptions(strFile);
+    options.nThreads = threadCounts[i][0];
+    options.nRunThreads = threadCounts[i][1];
+    options.nScoringThreads = threadCounts[i][2];
+    ASSERT_EQ(operation::dock(options), 0);
+    ASSERT_EQ(ReadRecords(strFile), serialRecords);
+  }
+}
+
+// 2 Check that a job killed after checkpointing resumes from the checkpoint,
+// dropping the output written after it
+TEST_F(DockTest, CheckpointResume) {
+  std::string strOutputFile = GetTestFileName("dock_test_resume.sd");
+  std::string strCheckpointFile = GetTestFileName("dock_test_resume.json");
+  operation::DockOptions options = GetOptions(strOutputFile);
+  options.strCheckpointFile = strCheckpointFile;
+  options.dCheckpointInterval = 0.0;
+  ASSERT_EQ(operation::dock(options), 0);
+  std::string strOutput = ReadFile(strOutputFile);
+  std::vector<std::string> records = ReadRecords(strOutputFile);
+  ASSERT_EQ(records.size(), 8);
+
+  // The last checkpoint covers the whole job
+  json checkpointData = json::parse(ReadFile(strCheckpointFile));
+  json &checkpoint = checkpointData.at("checkpoint");
+  EXPECT_EQ(checkpoint.at("records").get<std::size_t>(), 4);
+  EXPECT_EQ(checkpoint.at("input-offset").get<std::size_t>(),
+            ReadFile(m_strInputFile).size());
+  EXPECT_EQ(checkpoint.at("output-offset").get<std::size_t>(),
+            strOutput.size());
+
+  // Roll the job back to a checkpoint after the second ligand, as if it had
+  // been killed while writing the poses of the third one
+  std::string strInput = ReadFile(m_strInputFile);
+  std::size_t nInputOffset = strInput.find("$$$$\n") + 5;
+  nInputOffset = strInput.find("$$$$\n", nInputOffset) + 5;
+  ASSERT_EQ(strInput.compare(nInputOffset, 5, "lig3\n"), 0);
+  std::size_t nOutputOffset = strOutput.find("$$$$\nlig3\n") + 5;
+  ASSERT_NE(nOutputOffset, std::string::npos + 5);
+  checkpoint["records"] = 2;
+  checkpoint["input-offset"] = nInputOffset;
+  checkpoint["output-offset"] = nOutputOffset;
+  std::ofstream(strCheckpointFile.c_str()) << checkpointData << std::endl;
+  std::ofstream(strOutputFile.c_str(), std::ios_base::binary)
+      << strOutput.substr(0, nOutputOffset) << "lig3\n  partial record";
+
+  options.bResume = true;
+  ASSERT_EQ(operation::dock(options), 0);
+  EXPECT_EQ(ReadRecords(strOutputFile), records);
+  // The poses of the first two ligands are kept as they were
+  EXPECT_EQ(ReadFile(strOutputFile).compare(0, nOutputOffset, strOutput, 0,
+                                            nOutputOffset),
+            0);
+
+  // A checkpoint of another seed is rejected
+  options.nSeed++;
+  EXPECT_NE(operation::dock(options), 0);
+}
+
+// 3 Check that the shards of a job dock each ligand once, and that a shard
+// docks its ligands as a job given only its records would
+TEST_F(DockTest, Shards) {
+  std::string strShardFile = GetTestFileName("dock_test_shard.sd");
+  std::size_t shardCounts[3] = {2, 3, 6};
+  for (int i = 0; i < 3; i++) {
+    std::vector<std::string> titles;
+    for (std::size_t iShard = 0; iShard < shardCounts[i]; iShard++) {
+      operation::DockOptions options = GetOptions(strShardFile);
+      options.nDockingRuns = 1;
+      options.iShard = iShard;
+      options.nShards = shardCounts[i];
+      ASSERT_EQ(operation::dock(options), 0);
+      std::vector<std::string> records = ReadRecords(strShardFile);
+      for (std::vector<std::string>::const_iterator iter = records.begin();
+           iter != records.end(); ++iter) {
+        titles.push_back(iter->substr(0, iter->find('\n')));
+      }
+    }
+    std::vector<std::string> expectedTitles = {"lig1", "lig2", "lig3", "lig4"};
+    EXPECT_EQ(titles, expectedTitles) << shardCounts[i] << " shards";
+  }
+
+  // The second of two shards docks the records from its first ligand on
+  operation::DockOptions options = GetOptions(strShardFile);
+  options.iShard = 1;
+  options.nShards = 2;
+  ASSERT_EQ(operation::dock(options), 0);
+  std::vector<std::string> shardRecords = ReadRecords(strShardFile);
+  ASSERT_FALSE(shardRecords.empty());
+  std::string strTitle =
+      shardRecords.front().substr(0, shardRecords.front().find('\n') + 1);
+  std::string strInput = ReadFile(m_strInputFile);
+  std::size_t nOffset = strInput.find("$$$$\n" + strTitle) + 5;
+  ASSERT_NE(nOffset, std::string::npos + 5);
+  std::string strTailInputFile = GetTestFileName("dock_test_tail_in.sd");
+  std::ofstream(strTailInputFile.c_str(), std::ios_base::binary)
+      << strInput.substr(nOffset);
+  std::string strTailFile = GetTestFileName("dock_test_tail.sd");
+  options = GetOptions(strTailFile);
+  options.strLigandMdlFile = strTailInputFile;
+  ASSERT_EQ(operation::dock(options), 0);
+  EXPECT_EQ(shardRecords, ReadRecords(strTailFile));
+}
+
+// 4 Check that a spool docks its chunks as the shards of the input
+TEST_F(DockTest, Spool) {
+  std::string strSpoolDir = "dock_test_spool";
+  std::string strOutputFile = "dock_test_spool.sd";
+  for (int iChunk = 0; iChunk < 2; iChunk++) {
+    GetTestFileName(strSpoolDir + "/chunk-" + std::to_string(iChunk) +
+                    ".done");
+    GetTestFileName(strSpoolDir + "/chunk-" + std::to_string(iChunk) +
+                    ".checkpoint.json");
+    GetTestFileName("dock_test_spool_chunk" + std::to_string(iChunk + 1) +
+                    ".sd");
+  }
+  GetTestFileName(strSpoolDir + "/spool.json");
+  GetTestFileName(strSpoolDir);
+  operation::DockOptions options = GetOptions(strOutputFile);
+  options.strSpoolDir = strSpoolDir;
+  options.nSpoolChunks = 2;
+  ASSERT_EQ(operation::dock(options), 0);
+  // All the chunks are done, so docking again does nothing
+  ASSERT_EQ(operation::dock(options), 0);
+
+  std::string strShardFile = GetTestFileName("dock_test_spool_shard.sd");
+  for (int iChunk = 0; iChunk < 2; iChunk++) {
+    options = GetOptions(strShardFile);
+    options.iShard = iChunk;
+    options.nShards = 2;
+    ASSERT_EQ(operation::dock(options), 0);
+    EXPECT_EQ(ReadRecords("dock_test_spool_chunk" +
+                          std::to_string(iChunk + 1) + ".sd"),
+              ReadRecords(strShardFile));
+  }
+
+  // A spool can not be joined by a job with other options
+  options = GetOptions(strOutputFile);
+  options.strSpoolDir = strSpoolDir;
+  options.nSpoolChunks = 2;
+  options.nSeed++;
+  EXPECT_NE(operation::dock(options), 0);
+}
+
+// 5 Check that the duplicates of a ligand get its poses, with the same output
+// for any number of docking threads, even when they do not all fit in the
+// output window
+TEST_F(DockTest, Duplicates) {
+  std::string strInput = ReadFile(m_strInputFile);
+  std::size_t nFirstEnd = strInput.find("$$$$\n") + 5;
+  std::size_t nSecondEnd = strInput.find("$$$$\n", nFirstEnd) + 5;
+  std::string strFirst = strInput.substr(0, nFirstEnd);
+  std::string strSecond = strInput.substr(nFirstEnd, nSecondEnd - nFirstEnd);
+  const std::size_t nDuplicates = 150;
+  std::string strDuplicatesInputFile = GetTestFileName("dock_test_dup_in.sd");
+  {
+    std::ofstream inputFile(strDuplicatesInputFile.c_str(),
+                            std::ios_base::binary);
+    inputFile << strFirst;
+    for (std::size_t iDup = 0; iDup < nDuplicates; iDup++) {
+      inputFile << "dup" << iDup + 1 << strFirst.substr(strFirst.find('\n'));
+    }
+    inputFile << strSecond;
+  }
+
+  std::string strSerialFile = GetTestFileName("dock_test_dup_serial.sd");
+  operation::DockOptions options = GetOptions(strSerialFile);
+  options.strLigandMdlFile = strDuplicatesInputFile;
+  options.strDuplicateMatch = "exact";
+  ASSERT_EQ(operation::dock(options), 0);
+  std::vector<std::string> serialRecords = ReadRecords(strSerialFile);
+  ASSERT_EQ(serialRecords.size(), 2 * (nDuplicates + 2));
+  std::size_t nPoseBytes = 0;
+  for (std::size_t iRec = 0; iRec < serialRecords.size(); iRec++) {
+    std::string strDuplicateOf =
+        GetField(serialRecords[iRec], "rxdock.duplicate_of");
+    if (iRec < 2 || iRec >= 2 * (nDuplicates + 1)) {
+      EXPECT_EQ(strDuplicateOf, "");
+    } else {
+      EXPECT_EQ(strDuplicateOf, "1");
+      nPoseBytes += serialRecords[iRec].size();
+    }
+  }
+  // The poses of the duplicates are more than the output window of 1 MiB
+  EXPECT_GT(nPoseBytes, std::size_t(1) << 20);
+
+  std::string strParallelFile = GetTestFileName("dock_test_dup_parallel.sd");
+  options.strOutputMdlFile = strParallelFile;
+  options.nThreads = 4;
+  options.nOutputWindow = 1;
+  ASSERT_EQ(operation::dock(options), 0);
+  EXPECT_EQ(ReadRecords(strParallelFile), serialRecords);
+}
+
+// 6 Check that NUMA replicas do not change the poses, and that the calling
+// thread can run on the same CPUs as before once the job is done
+TEST_F(DockTest, NumaReplicas) {
+  std::string strSerialFile = GetTestFileName("dock_test_numa_serial.sd");
+  ASSERT_EQ(operation::dock(GetOptions(strSerialFile)), 0);
+  std::vector<int> cpus = support::getThreadCpus();
+  std::string strNumaFile = GetTestFileName("dock_test_numa.sd");
+  operation::DockOptions options = GetOptions(strNumaFile);
+  options.nThreads = 2;
+  options.bNumaReplicas = true;
+  ASSERT_EQ(operation::dock(options), 0);
+  EXPECT_EQ(ReadRecords(strNumaFile), ReadRecords(strSerialFile));
+  EXPECT_EQ(support::getThreadCpus(), cpus);
+}
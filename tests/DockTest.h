@@ -0,0 +1,57 @@
+// Unit tests for the dock operation
+//
+// Required input files:
+// 1YET_test.json             RxDock receptor file
+// 1YET.psf                   Receptor topology file
+// 1YET.crd                   Receptor coordinate file
+// 1YET_test-docking-site.json Docking site
+// 1YET_c.sd                  Ligand coordinate file
+// 1koc_c.sd                  Ligand coordinate file
+//
+// Required environment:
+// Make sure the above files are colocated in a single directory
+// and define RBT_HOME env. variable to point at this directory
+#ifndef DOCKTEST_H_
+#define DOCKTEST_H_
+
+#include <gtest/gtest.h>
+
+#include "rxdock/operation/Dock.h"
+
+#include <string>
+#include <vector>
+
+namespace rxdock {
+
+namespace unittest {
+
+class DockTest : public ::testing::Test {
+protected:
+  // TextFixture methods
+  void SetUp() override;
+  void TearDown() override;
+
+  // Returns the options docking the test ligands with a seed
+  operation::DockOptions GetOptions(const std::string &strOutputFile) const;
+  // Returns the contents of a file
+  std::string ReadFile(const std::string &strFile) const;
+  // Returns the SD records of a file, without the program and time stamp
+  // line, which differs between jobs
+  std::vector<std::string> ReadRecords(const std::string &strFile) const;
+  // Returns the value of a data field of an SD record
+  std::string GetField(const std::string &strRecord,
+                       const std::string &strField) const;
+  // Returns the name of a file for a test to create, which is removed in
+  // TearDown
+  std::string GetTestFileName(const std::string &strName);
+
+  // Input file: the 1YET and 1koc ligands, twice each, titled lig1 to lig4
+  std::string m_strInputFile;
+  std::vector<std::string> m_files; // Files to remove in TearDown
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*DOCKTEST_H_*/
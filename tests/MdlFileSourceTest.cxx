@@ -0,0 +1,83 @@
+#include "MdlFileSourceTest.h"
+#include "rxdock/Config.h"
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+void MdlFileSourceTest::SetUp() {
+  MdlFileSource source(GetDataFileName("", "isomers.sd"), false, false, true);
+  source.SetSegmentFilterMap(ConvertStringToSegmentMap("H"));
+  for (; source.FileStatusOK(); source.NextRecord()) {
+    std::array<std::uint64_t, 3> &hashes =
+        m_hashes[source.GetTitleList().front()];
+    hashes[0] = source.GetStructureHash(MdlFileSource::EXACT_MATCH);
+    hashes[1] = source.GetStructureHash(MdlFileSource::STEREO_MATCH);
+    hashes[2] = source.GetStructureHash(MdlFileSource::TAUTOMER_MATCH);
+  }
+}
+
+void MdlFileSourceTest::TearDown() { m_hashes.clear(); }
+
+std::uint64_t
+MdlFileSourceTest::GetHash(const std::string &strTitle,
+                           MdlFileSource::eStructureMatch eMatch) const {
+  std::map<std::string, std::array<std::uint64_t, 3>>::const_iterator iter =
+      m_hashes.find(strTitle);
+  EXPECT_TRUE(iter != m_hashes.end()) << strTitle;
+  return (iter == m_hashes.end()) ? 0 : iter->second[eMatch];
+}
+
+// 1 Check that the hashes do not depend on the order of the atoms and bonds or
+// on the position of the molecule
+TEST_F(MdlFileSourceTest, AtomOrder) {
+  const char *molecules[4] = {"trans-decalin", "trans-1,4-dimethylcyclohexane",
+                              "3-methylhexane", "2-hydroxypyridine"};
+  MdlFileSource::eStructureMatch matches[3] = {
+      MdlFileSource::EXACT_MATCH, MdlFileSource::STEREO_MATCH,
+      MdlFileSource::TAUTOMER_MATCH};
+  for (const char *molecule : molecules) {
+    for (MdlFileSource::eStructureMatch eMatch : matches) {
+      EXPECT_EQ(GetHash(molecule, eMatch),
+                GetHash(std::string(molecule) + "-shuffled", eMatch))
+          << molecule << " " << eMatch;
+    }
+  }
+}
+
+// 2 Check that graphs that atom invariant refinement can not tell apart get
+// different hashes
+TEST_F(MdlFileSourceTest, Constitution) {
+  EXPECT_NE(GetHash("trans-decalin", MdlFileSource::STEREO_MATCH),
+            GetHash("bicyclopentyl", MdlFileSource::STEREO_MATCH));
+  EXPECT_NE(GetHash("trans-decalin", MdlFileSource::TAUTOMER_MATCH),
+            GetHash("bicyclopentyl", MdlFileSource::TAUTOMER_MATCH));
+}
+
+// 3 Check that cis/trans isomers of rings and double bonds and enantiomers only
+// match when stereochemistry is ignored
+TEST_F(MdlFileSourceTest, Stereo) {
+  const char *isomers[4][2] = {
+      {"cis-decalin", "trans-decalin"},
+      {"cis-1,4-dimethylcyclohexane", "trans-1,4-dimethylcyclohexane"},
+      {"3-methylhexane", "3-methylhexane-mirror"},
+      {"cis-2-butene", "trans-2-butene"}};
+  for (const auto &pair : isomers) {
+    EXPECT_NE(GetHash(pair[0], MdlFileSource::EXACT_MATCH),
+              GetHash(pair[1], MdlFileSource::EXACT_MATCH))
+        << pair[0];
+    EXPECT_EQ(GetHash(pair[0], MdlFileSource::STEREO_MATCH),
+              GetHash(pair[1], MdlFileSource::STEREO_MATCH))
+        << pair[0];
+  }
+}
+
+// 4 Check that tautomers only match when tautomers are, and that moving a
+// double bond is not taken as a tautomer
+TEST_F(MdlFileSourceTest, Tautomer) {
+  EXPECT_NE(GetHash("2-pyridone", MdlFileSource::STEREO_MATCH),
+            GetHash("2-hydroxypyridine", MdlFileSource::STEREO_MATCH));
+  EXPECT_EQ(GetHash("2-pyridone", MdlFileSource::TAUTOMER_MATCH),
+            GetHash("2-hydroxypyridine", MdlFileSource::TAUTOMER_MATCH));
+  EXPECT_NE(GetHash("1-butene", MdlFileSource::TAUTOMER_MATCH),
+            GetHash("cis-2-butene", MdlFileSource::TAUTOMER_MATCH));
+}
@@ -0,0 +1,43 @@
+// Unit tests for MdlFileSource
+//
+// Required input files:
+// isomers.sd                 Isomers and atom orders of small molecules
+//
+// Required environment:
+// Make sure the above files are colocated in a single directory
+// and define RBT_HOME env. variable to point at this directory
+#ifndef MDLFILESOURCETEST_H_
+#define MDLFILESOURCETEST_H_
+
+#include <gtest/gtest.h>
+
+#include "rxdock/MdlFileSource.h"
+
+#include <array>
+#include <map>
+#include <string>
+
+namespace rxdock {
+
+namespace unittest {
+
+class MdlFileSourceTest : public ::testing::Test {
+protected:
+  // TextFixture methods
+  void SetUp() override;
+  void TearDown() override;
+
+  // Returns the structure hash of the record of isomers.sd with title
+  // strTitle
+  std::uint64_t GetHash(const std::string &strTitle,
+                        MdlFileSource::eStructureMatch eMatch) const;
+
+  // Exact, stereo and tautomer hashes of the records of isomers.sd, by title
+  std::map<std::string, std::array<std::uint64_t, 3>> m_hashes;
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*MDLFILESOURCETEST_H_*/
@@ -0,0 +1,203 @@
+#include "ResultCacheTest.h"
+#include "rxdock/Config.h"
+#include "rxdock/Error.h"
+#include "rxdock/ResultCache.h"
+#include "rxdock/operation/Dock.h"
+#include "rxdock/support/Hash.h"
+
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <sys/stat.h>
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+const std::string ResultCacheTest::m_strDirName = "result_cache_test";
+
+void ResultCacheTest::SetUp() {
+  TearDown();
+  m_lineRecs = {"ethanol",
+                "  program 01012000003D",
+                "comment",
+                "  3  2  0  0  0  0  0  0  0  0999 V2000",
+                "    0.0000    0.0000    0.0000 C   0  0  0  0  0  0",
+                "    1.5000    0.0000    0.0000 C   0  0  0  0  0  0",
+                "    2.0000    1.4000    0.0000 O   0  0  0  0  0  0",
+                "  1  2  1  0  0  0",
+                "  2  3  1  0  0  0",
+                "M  END",
+                ">  <id>",
+                "1",
+                ""};
+}
+
+void ResultCacheTest::TearDown() {
+  RemoveDirectory(m_strDirName);
+  for (const std::string &strFile : m_files) {
+    std::remove(strFile.c_str());
+  }
+  m_files.clear();
+}
+
+void ResultCacheTest::RemoveDirectory(const std::string &strDirName) const {
+  DIR *pDir = opendir(strDirName.c_str());
+  if (pDir == nullptr) {
+    return;
+  }
+  while (dirent *pEntry = readdir(pDir)) {
+    std::string strName = pEntry->d_name;
+    if (strName == "." || strName == "..") {
+      continue;
+    }
+    std::string strPath = strDirName + "/" + strName;
+    struct stat fileStat;
+    if (stat(strPath.c_str(), &fileStat) == 0 && S_ISDIR(fileStat.st_mode)) {
+      RemoveDirectory(strPath);
+    } else {
+      std::remove(strPath.c_str());
+    }
+  }
+  closedir(pDir);
+  std::remove(strDirName.c_str());
+}
+
+std::vector<std::string>
+ResultCacheTest::ReadRecords(const std::string &strFile) const {
+  std::vector<std::string> records;
+  std::ifstream file(strFile.c_str());
+  std::string strRecord;
+  std::string strLine;
+  int iLine = 0;
+  while (std::getline(file, strLine)) {
+    if (iLine++ != 1) {
+      strRecord += strLine + "\n";
+    }
+    if (strLine == "$$$$") {
+      records.push_back(strRecord);
+      strRecord.clear();
+      iLine = 0;
+    }
+  }
+  return records;
+}
+
+// 1 Check that a ligand is only found after its poses are stored, with the
+// record they were stored for
+TEST_F(ResultCacheTest, HitAndMiss) {
+  ResultCache cache(m_strDirName, "job 1\n");
+  std::vector<std::string> storedLineRecs;
+  std::string strPoses;
+  EXPECT_FALSE(cache.Lookup(m_lineRecs, storedLineRecs, strPoses));
+  cache.Store(m_lineRecs, "poses\n$$$$\n");
+  ASSERT_TRUE(cache.Lookup(m_lineRecs, storedLineRecs, strPoses));
+  EXPECT_EQ(strPoses, "poses\n$$$$\n");
+  EXPECT_EQ(storedLineRecs, m_lineRecs);
+
+  // Another cache object of the same job finds the entry too
+  ResultCache sameJob(m_strDirName, "job 1\n");
+  EXPECT_TRUE(sameJob.Lookup(m_lineRecs, storedLineRecs, strPoses));
+  // But not another job
+  ResultCache otherJob(m_strDirName, "job 2\n");
+  EXPECT_NE(otherJob.GetJobHash(), cache.GetJobHash());
+  EXPECT_FALSE(otherJob.Lookup(m_lineRecs, storedLineRecs, strPoses));
+}
+
+// 2 Check that the entries are keyed by the connection table, not by the
+// header, title or data fields of the record
+TEST_F(ResultCacheTest, ConnectionTable) {
+  ResultCache cache(m_strDirName, "job 1\n");
+  cache.Store(m_lineRecs, "poses\n$$$$\n");
+  std::vector<std::string> lineRecs = m_lineRecs;
+  lineRecs[0] = "ethyl alcohol";
+  lineRecs[1] = "  other program";
+  lineRecs[11] = "2";
+  lineRecs[4] += "  ";
+  std::vector<std::string> storedLineRecs;
+  std::string strPoses;
+  ASSERT_TRUE(cache.Lookup(lineRecs, storedLineRecs, strPoses));
+  EXPECT_EQ(storedLineRecs, m_lineRecs);
+
+  // Other coordinates or bonds are another ligand
+  lineRecs = m_lineRecs;
+  lineRecs[6] = "    2.0000    1.5000    0.0000 O   0  0  0  0  0  0";
+  EXPECT_FALSE(cache.Lookup(lineRecs, storedLineRecs, strPoses));
+  lineRecs = m_lineRecs;
+  lineRecs[8] = "  2  3  2  0  0  0";
+  EXPECT_FALSE(cache.Lookup(lineRecs, storedLineRecs, strPoses));
+}
+
+// 3 Check that a job whose key has the hash of the key of another job in the
+// cache is rejected
+TEST_F(ResultCacheTest, JobKeyCollision) {
+  std::string strJobFile;
+  {
+    ResultCache cache(m_strDirName, "job 1\n");
+    strJobFile = m_strDirName + "/jobs/" +
+                 support::formatHash(cache.GetJobHash()) + ".txt";
+  }
+  std::ofstream jobFile(strJobFile.c_str(), std::ios::binary);
+  jobFile << "job 3\n";
+  jobFile.close();
+  EXPECT_THROW(ResultCache(m_strDirName, "job 1\n"), InvalidRequest);
+}
+
+// 4 Check that docking again with the cache writes the same poses without
+// docking, that a record with the connection table of an earlier one gets its
+// poses under its own title, and that the cache is not used without a seed
+TEST_F(ResultCacheTest, Dock) {
+  std::string strInputFile = "result_cache_test_in.sd";
+  m_files.push_back(strInputFile);
+  std::ifstream ligandFile(GetDataFileName("", "1YET_c.sd").c_str());
+  std::string strLine;
+  std::getline(ligandFile, strLine);
+  std::string strRecord;
+  while (std::getline(ligandFile, strLine)) {
+    strRecord += strLine + "\n";
+  }
+  std::ofstream inputFile(strInputFile.c_str());
+  inputFile << "lig1\n" << strRecord << "lig2\n" << strRecord;
+  inputFile.close();
+
+  operation::DockOptions options;
+  options.strLigandMdlFile = strInputFile;
+  options.strReceptorPrmFile = GetDataFileName("", "1YET_test.json");
+  options.strParamFile = "dock.json";
+  options.bDockingRuns = true;
+  options.nDockingRuns = 2;
+  options.bSeed = true;
+  options.nSeed = 48151623;
+  options.strCacheDir = m_strDirName;
+  std::string strOutputFiles[2] = {"result_cache_test_1.sd",
+                                   "result_cache_test_2.sd"};
+  for (const std::string &strOutputFile : strOutputFiles) {
+    m_files.push_back(strOutputFile);
+    options.strOutputMdlFile = strOutputFile;
+    ASSERT_EQ(operation::dock(options), 0);
+  }
+  std::vector<std::string> records = ReadRecords(strOutputFiles[0]);
+  ASSERT_EQ(records.size(), 4);
+  EXPECT_EQ(ReadRecords(strOutputFiles[1]), records);
+  // The poses of lig2 are those of lig1 with its title and Name field
+  auto removeTitle = [](std::string strRecord, const std::string &strTitle) {
+    std::string strName = ">  <Name>\n" + strTitle + "\n\n";
+    std::string::size_type iName = strRecord.find(strName);
+    if (strRecord.compare(0, strTitle.size() + 1, strTitle + "\n") != 0 ||
+        iName == std::string::npos) {
+      return std::string();
+    }
+    strRecord.erase(iName, strName.size());
+    return strRecord.substr(strTitle.size() + 1);
+  };
+  for (int iPose = 0; iPose < 2; iPose++) {
+    std::string strPose = removeTitle(records[iPose], "lig1");
+    EXPECT_FALSE(strPose.empty());
+    EXPECT_EQ(removeTitle(records[iPose + 2], "lig2"), strPose);
+  }
+
+  RemoveDirectory(m_strDirName);
+  options.bSeed = false;
+  ASSERT_EQ(operation::dock(options), 0);
+  struct stat fileStat;
+  EXPECT_NE(stat(m_strDirName.c_str(), &fileStat), 0);
+}
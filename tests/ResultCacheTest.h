@@ -0,0 +1,47 @@
+// Unit tests for ResultCache
+//
+// Required input files:
+// 1YET_test.json             RxDock receptor file
+// 1YET.psf                   Receptor topology file
+// 1YET.crd                   Receptor coordinate file
+// 1YET_test-docking-site.json Docking site
+// 1YET_c.sd                  Ligand coordinate file
+//
+// Required environment:
+// Make sure the above files are colocated in a single directory
+// and define RBT_HOME env. variable to point at this directory. The tests
+// create their cache directory in the current directory
+#ifndef RESULTCACHETEST_H_
+#define RESULTCACHETEST_H_
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace rxdock {
+
+namespace unittest {
+
+class ResultCacheTest : public ::testing::Test {
+protected:
+  // TextFixture methods
+  void SetUp() override;
+  void TearDown() override;
+
+  // Removes a directory and everything in it
+  void RemoveDirectory(const std::string &strDirName) const;
+  // Returns the SD records of a file, without the program and time stamp
+  // line, which differs between jobs
+  std::vector<std::string> ReadRecords(const std::string &strFile) const;
+
+  static const std::string m_strDirName; // Cache directory
+  std::vector<std::string> m_lineRecs;   // SD record of a ligand
+  std::vector<std::string> m_files;      // Files to remove in TearDown
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*RESULTCACHETEST_H_*/
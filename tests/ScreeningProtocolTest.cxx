@@ -0,0 +1,112 @@
+#include "ScreeningProtocolTest.h"
+#include "rxdock/Error.h"
+
+#include <sstream>
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+void ScreeningProtocolTest::SetUp() {
+  // Best scores after 2, 3 and 4 runs: -10, -10, -12; -6, -6, -6; -2, -9,
+  // -9; and 1, -20, -20
+  m_runScores = {{-10.0, -3.0, -4.0, -12.0},
+                 {-2.0, -6.0, -1.0, -1.0},
+                 {-1.0, -2.0, -9.0, -9.0},
+                 {0.0, 1.0, -20.0, -20.0}};
+}
+
+void ScreeningProtocolTest::TearDown() { m_runScores.clear(); }
+
+// 1 The stages must end after an increasing number of runs, less than the
+// maximum
+TEST_F(ScreeningProtocolTest, Validate) {
+  std::vector<ScreeningProtocol::Stage> stages = {{2, -5.0}, {5, -8.0}};
+  EXPECT_NO_THROW(ScreeningProtocol(stages, 10, "score.inter"));
+  EXPECT_THROW(ScreeningProtocol(stages, 5, "score.inter"), BadArgument);
+  stages[1].nRuns = 2;
+  EXPECT_THROW(ScreeningProtocol(stages, 10, "score.inter"), BadArgument);
+  stages.clear();
+  EXPECT_NO_THROW(ScreeningProtocol(stages, 10, "score.inter"));
+  EXPECT_THROW(ScreeningProtocol(stages, 0, "score.inter"), BadArgument);
+}
+
+// 2 A ligand is docked again while its best score is at most the threshold
+// of each stage it completes, up to the maximum number of runs
+TEST_F(ScreeningProtocolTest, Thresholds) {
+  ScreeningProtocol protocol({{2, -5.0}, {5, -8.0}}, 10, "score.inter");
+  EXPECT_EQ(protocol.GetStageEnd(0), 2);
+  EXPECT_EQ(protocol.GetStageEnd(1), 2);
+  EXPECT_EQ(protocol.GetStageEnd(2), 5);
+  EXPECT_EQ(protocol.GetStageEnd(4), 5);
+  EXPECT_EQ(protocol.GetStageEnd(5), 10);
+  // Within a stage the score is not checked
+  EXPECT_TRUE(protocol.Continue(1, 100.0));
+  EXPECT_TRUE(protocol.Continue(2, -5.0));
+  EXPECT_FALSE(protocol.Continue(2, -4.9));
+  EXPECT_TRUE(protocol.Continue(3, -4.9));
+  EXPECT_TRUE(protocol.Continue(5, -9.0));
+  EXPECT_FALSE(protocol.Continue(5, -7.0));
+  EXPECT_TRUE(protocol.Continue(9, -9.0));
+  EXPECT_FALSE(protocol.Continue(10, -100.0));
+}
+
+// 3 Each threshold keeps the requested fraction of all the training ligands,
+// given those that passed the previous stages, and is set halfway to the
+// score of the next ligand
+TEST_F(ScreeningProtocolTest, Calibrate) {
+  ScreeningProtocol protocol = ScreeningProtocol::Calibrate(
+      m_runScores, {2, 3}, {0.5, 0.25}, 4, "score.inter");
+  ASSERT_EQ(protocol.GetStages().size(), 2);
+  EXPECT_EQ(protocol.GetStages()[0].nRuns, 2);
+  EXPECT_DOUBLE_EQ(protocol.GetStages()[0].dThreshold, -4.0);
+  EXPECT_EQ(protocol.GetStages()[1].nRuns, 3);
+  EXPECT_DOUBLE_EQ(protocol.GetStages()[1].dThreshold, -8.0);
+  EXPECT_EQ(protocol.GetMaxRuns(), 4);
+  EXPECT_EQ(protocol.GetScoreName(), "score.inter");
+
+  // The first ligand gets all 4 runs, the second 3, the others 2
+  std::vector<double> passFractions;
+  EXPECT_DOUBLE_EQ(protocol.Simulate(m_runScores, passFractions), 2.75);
+  ASSERT_EQ(passFractions.size(), 2);
+  EXPECT_DOUBLE_EQ(passFractions[0], 0.5);
+  EXPECT_DOUBLE_EQ(passFractions[1], 0.25);
+}
+
+// 4 Ligands with the same best score as the last ligand kept are kept too
+TEST_F(ScreeningProtocolTest, CalibrateTies) {
+  ScreeningProtocol protocol = ScreeningProtocol::Calibrate(
+      {{-5.0, 0.0}, {-5.0, 0.0}, {-3.0, 0.0}}, {1}, {0.25}, 2, "score");
+  EXPECT_DOUBLE_EQ(protocol.GetStages()[0].dThreshold, -4.0);
+  std::vector<double> passFractions;
+  protocol.Simulate({{-5.0, 0.0}, {-5.0, 0.0}, {-3.0, 0.0}}, passFractions);
+  EXPECT_DOUBLE_EQ(passFractions[0], 2.0 / 3.0);
+}
+
+// 5 Calibration needs ligands, and non-increasing fractions in (0, 1]
+TEST_F(ScreeningProtocolTest, CalibrateErrors) {
+  EXPECT_THROW(ScreeningProtocol::Calibrate({}, {2}, {0.5}, 4, "score"),
+               BadArgument);
+  EXPECT_THROW(
+      ScreeningProtocol::Calibrate(m_runScores, {2, 3}, {0.5}, 4, "score"),
+      BadArgument);
+  EXPECT_THROW(ScreeningProtocol::Calibrate(m_runScores, {2, 3}, {0.25, 0.5},
+                                            4, "score"),
+               BadArgument);
+  EXPECT_THROW(
+      ScreeningProtocol::Calibrate(m_runScores, {2}, {0.0}, 4, "score"),
+      BadArgument);
+}
+
+// 6 A protocol is saved to and read from JSON
+TEST_F(ScreeningProtocolTest, Json) {
+  ScreeningProtocol protocol({{2, -5.5}, {5, -8.25}}, 10, "score.inter");
+  json j = protocol;
+  ScreeningProtocol copy(j);
+  ASSERT_EQ(copy.GetStages().size(), 2);
+  EXPECT_EQ(copy.GetStages()[1].nRuns, 5);
+  EXPECT_DOUBLE_EQ(copy.GetStages()[1].dThreshold, -8.25);
+  EXPECT_EQ(copy.GetMaxRuns(), 10);
+  EXPECT_EQ(copy.GetScoreName(), "score.inter");
+  j["max-runs"] = 5;
+  EXPECT_THROW(ScreeningProtocol protocol(j), BadArgument);
+}
@@ -0,0 +1,32 @@
+// Unit tests for ScreeningProtocol
+//
+// Required input files:
+// None
+#ifndef SCREENINGPROTOCOLTEST_H_
+#define SCREENINGPROTOCOLTEST_H_
+
+#include <gtest/gtest.h>
+
+#include "rxdock/ScreeningProtocol.h"
+
+#include <vector>
+
+namespace rxdock {
+
+namespace unittest {
+
+class ScreeningProtocolTest : public ::testing::Test {
+protected:
+  // TextFixture methods
+  void SetUp() override;
+  void TearDown() override;
+
+  // Run scores of four training ligands, docked four times each
+  std::vector<std::vector<double>> m_runScores;
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*SCREENINGPROTOCOLTEST_H_*/
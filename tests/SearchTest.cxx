@@ -4,6 +4,8 @@
 #include "rxdock/GATransform.h"
 #include "rxdock/MdlFileSink.h"
 #include "rxdock/MdlFileSource.h"
+#include "rxdock/NMCriteria.h"
+#include "rxdock/NMSimplex.h"
 #include "rxdock/PRMFactory.h"
 #include "rxdock/RandPopTransform.h"
 #include "rxdock/SimAnnTransform.h"
@@ -12,6 +14,8 @@
 #include "rxdock/VdwIdxSF.h"
 #include "rxdock/VdwIntraSF.h"
 
+#include <fmt/ostream.h>
+
 using namespace rxdock;
 using namespace rxdock::unittest;
 
@@ -195,3 +199,126 @@ TEST_F(SearchTest, Restart) {
   }
   ASSERT_LT(std::fabs(restartScore - finalScore), 0.01);
 }
+
+// 7 Check that a cloned scoring function gives the same score as the original
+// when registered with a workspace containing the same models
+TEST_F(SearchTest, CloneSF) {
+  SFAggPtr spClone(m_SF->Clone());
+  ASSERT_EQ(spClone->GetNumSF(), m_SF->GetNumSF());
+  ASSERT_EQ(spClone->GetSF(0)->GetParameter(VdwSF::GetEcut()).GetDouble(),
+            1.0);
+  BiMolWorkSpacePtr spWorkSpace(new BiMolWorkSpace());
+  spWorkSpace->SetDockingSite(m_workSpace->GetDockingSite());
+  spWorkSpace->SetSF(spClone);
+  spWorkSpace->SetReceptor(m_workSpace->GetReceptor());
+  spWorkSpace->SetLigand(m_workSpace->GetLigand());
+  spWorkSpace->SetSolvent(m_workSpace->GetSolvent());
+  ASSERT_NEAR(spClone->Score(), m_SF->Score(), 1.0e-6);
+}
+
+// 8 Check that a steady-state GA does not lose the best genome of the random
+// population it starts from
+TEST_F(SearchTest, SteadyStateGA) {
+  BaseTransform *pRandPop = new RandPopTransform();
+  m_workSpace->SetTransform(pRandPop);
+  ASSERT_NO_THROW(m_workSpace->Run());
+  double startScore = m_workSpace->GetPopulation()->Best()->GetScore();
+  BaseTransform *pGA = new GATransform();
+  pGA->SetParameter(GATransform::_STEADY_STATE_BATCH, 2);
+  pGA->SetParameter(GATransform::_NCYCLES, 20);
+  m_workSpace->SetTransform(pGA);
+  ASSERT_NO_THROW(m_workSpace->Run());
+  PopulationPtr spPop = m_workSpace->GetPopulation();
+  ASSERT_EQ(spPop->GetActualSize(), spPop->GetMaxSize());
+  ASSERT_GE(spPop->Best()->GetScore(), startScore);
+  delete pGA;
+  delete pRandPop;
+}
+
+// 9 Check that an island GA gives the same population whether its islands are
+// stepped in turn or concurrently on a scoring replica of the workspace
+TEST_F(SearchTest, IslandGA) {
+  std::vector<CoordList> startCoords = m_workSpace->GetMobileCoords();
+  // Runs the GA from the start coordinates, returning the final scores
+  auto runGA = [&]() {
+    m_workSpace->SetMobileCoords(startCoords);
+    GetRandInstance().SeedStream(48151623, 0, 0);
+    TransformAggPtr spTransformAgg(new TransformAgg());
+    spTransformAgg->Add(new RandPopTransform());
+    BaseTransform *pGA = new GATransform();
+    pGA->SetParameter(GATransform::_NISLANDS, 4);
+    pGA->SetParameter(GATransform::_MIGRATION_FREQ, 2);
+    pGA->SetParameter(GATransform::_NMIGRANTS, 2);
+    pGA->SetParameter(GATransform::_NCYCLES, 10);
+    spTransformAgg->Add(pGA);
+    m_workSpace->SetTransform(spTransformAgg);
+    EXPECT_NO_THROW(m_workSpace->Run());
+    m_workSpace->SetTransform(nullptr);
+    std::vector<double> scores;
+    PopulationPtr spPop = m_workSpace->GetPopulation();
+    EXPECT_EQ(spPop->GetActualSize(), spPop->GetMaxSize());
+    for (GenomeListConstIter iter = spPop->GetGenomeList().begin();
+         iter != spPop->GetGenomeList().end(); ++iter) {
+      scores.push_back((*iter)->GetScore());
+    }
+    return scores;
+  };
+  std::vector<double> serialScores = runGA();
+
+  // A replica of the workspace, with its own models and scoring function
+  BiMolWorkSpacePtr spReplica(new BiMolWorkSpace());
+  spReplica->SetDockingSite(m_workSpace->GetDockingSite());
+  ParameterFileSourcePtr spPrmSource(
+      new ParameterFileSource(GetDataFileName("", "1YET.json")));
+  MolecularFileSourcePtr spMdlFileSource(
+      new MdlFileSource(GetDataFileName("", "1YET_c.sd"), true, true, true));
+  PRMFactory prmFactory(spPrmSource, spReplica->GetDockingSite());
+  spReplica->SetReceptor(prmFactory.CreateReceptor());
+  spReplica->SetLigand(prmFactory.CreateLigand(spMdlFileSource));
+  spReplica->SetSolvent(prmFactory.CreateSolvent());
+  SFAggPtr spReplicaSF(m_SF->Clone());
+  spReplica->SetSF(spReplicaSF);
+  m_workSpace->SetScoringReplicas(
+      std::vector<WorkSpace *>(1, spReplica.Ptr()));
+  std::vector<double> replicaScores = runGA();
+  m_workSpace->SetScoringReplicas(std::vector<WorkSpace *>());
+  ASSERT_EQ(replicaScores, serialScores);
+}
+
+// A quadratic bowl that records the points it is evaluated at
+class RecordingQuadratic {
+public:
+  typedef double DataType;
+  typedef Eigen::VectorXd ParameterType;
+  double operator()(const ParameterType &parameters) {
+    points.push_back(std::vector<double>(
+        parameters.data(), parameters.data() + parameters.size()));
+    return (parameters.array() - 1.0).square().sum();
+  }
+  std::vector<std::vector<double>> points;
+};
+
+// 10 Check that the simplex minimises without evaluating any point twice
+TEST_F(SearchTest, SimplexEvaluations) {
+  RecordingQuadratic fun;
+  auto optimizer = neldermead::CreateSimplex(
+      fun, neldermead::CreateAndCriteria(
+               neldermead::IterationCriterion(500),
+               neldermead::RelativeValueCriterion<double>(1E-12)));
+  optimizer.SetStartPoint(RecordingQuadratic::ParameterType::Zero(4));
+  optimizer.SetDelta(0.3);
+  for (int iCycle = 0; iCycle < 3; iCycle++) {
+    if (iCycle > 0) {
+      optimizer.SetStartPoint(optimizer.GetBestParameters());
+    }
+    optimizer.Optimize(fun);
+  }
+  ASSERT_NEAR(optimizer.GetBestValue(), 0.0, 1E-6);
+  // Only the start point of each cycle, which is the best point of the
+  // cycle before, is evaluated again
+  std::vector<std::vector<double>> points(fun.points);
+  std::sort(points.begin(), points.end());
+  std::size_t nDistinct =
+      std::unique(points.begin(), points.end()) - points.begin();
+  ASSERT_EQ(nDistinct, fun.points.size() - 2);
+}
@@ -0,0 +1,137 @@
+#include "WorkSpoolTest.h"
+#include "rxdock/Error.h"
+#include "rxdock/WorkSpool.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <sys/utime.h>
+#define utime _utime
+#define utimbuf _utimbuf
+#else
+#include <utime.h>
+#endif
+
+using namespace rxdock;
+using namespace rxdock::unittest;
+
+const std::string WorkSpoolTest::m_strDirName = "work_spool_test";
+const std::string WorkSpoolTest::m_strForeignId = "otherhost:1";
+
+void WorkSpoolTest::SetUp() { TearDown(); }
+
+void WorkSpoolTest::TearDown() {
+  const char *suffixes[] = {".lease", ".done", ".reclaim"};
+  for (std::size_t iChunk = 0; iChunk < m_nChunks; iChunk++) {
+    for (const char *suffix : suffixes) {
+      std::remove(GetChunkFileName(iChunk, suffix).c_str());
+    }
+  }
+  std::remove((m_strDirName + "/spool.json").c_str());
+  std::remove(m_strDirName.c_str());
+}
+
+std::string
+WorkSpoolTest::GetChunkFileName(std::size_t iChunk,
+                                const std::string &strSuffix) const {
+  std::ostringstream ostr;
+  ostr << m_strDirName << "/chunk-" << iChunk << strSuffix;
+  return ostr.str();
+}
+
+void WorkSpoolTest::WriteForeignLease(std::size_t iChunk, double dAge) const {
+  std::string strLeaseFile = GetChunkFileName(iChunk, ".lease");
+  std::ofstream(strLeaseFile.c_str()) << m_strForeignId;
+  struct utimbuf times;
+  times.actime = times.modtime =
+      std::time(nullptr) - static_cast<std::time_t>(dAge);
+  utime(strLeaseFile.c_str(), &times);
+}
+
+std::string WorkSpoolTest::ReadFile(const std::string &strFile) const {
+  std::ifstream file(strFile.c_str());
+  std::stringstream fileStream;
+  fileStream << file.rdbuf();
+  return fileStream.str();
+}
+
+// 1 The chunks are claimed in turn until they are all done
+TEST_F(WorkSpoolTest, ClaimAll) {
+  WorkSpool spool(m_strDirName, "job", m_nChunks, 60.0);
+  std::size_t iChunk = m_nChunks;
+  for (std::size_t i = 0; i < m_nChunks; i++) {
+    ASSERT_TRUE(spool.Claim(iChunk));
+    EXPECT_EQ(iChunk, i);
+    EXPECT_THROW(spool.Claim(iChunk), InvalidRequest);
+    EXPECT_TRUE(spool.Complete());
+    EXPECT_TRUE(std::ifstream(GetChunkFileName(i, ".done").c_str()));
+  }
+  EXPECT_FALSE(spool.Claim(iChunk));
+}
+
+// 2 The processes of a spool must have the same job and number of chunks
+TEST_F(WorkSpoolTest, SameJob) {
+  WorkSpool spool(m_strDirName, "job", m_nChunks, 60.0);
+  EXPECT_NO_THROW(WorkSpool(m_strDirName, "job", m_nChunks, 60.0));
+  EXPECT_THROW(WorkSpool(m_strDirName, "other job", m_nChunks, 60.0),
+               BadArgument);
+  EXPECT_THROW(WorkSpool(m_strDirName, "job", m_nChunks + 1, 60.0),
+               BadArgument);
+}
+
+// 3 A released chunk can be claimed again
+TEST_F(WorkSpoolTest, Release) {
+  WorkSpool spool(m_strDirName, "job", m_nChunks, 60.0);
+  std::size_t iChunk = m_nChunks;
+  ASSERT_TRUE(spool.Claim(iChunk));
+  EXPECT_EQ(iChunk, 0);
+  spool.Release();
+  EXPECT_FALSE(std::ifstream(GetChunkFileName(0, ".lease").c_str()));
+  ASSERT_TRUE(spool.Claim(iChunk));
+  EXPECT_EQ(iChunk, 0);
+}
+
+// 4 A live lease of another process is skipped, and an expired one is
+// reclaimed
+TEST_F(WorkSpoolTest, LeaseExpiry) {
+  WorkSpool spool(m_strDirName, "job", m_nChunks, 10.0);
+  WriteForeignLease(0, 0.0);
+  WriteForeignLease(1, 60.0);
+  std::size_t iChunk = m_nChunks;
+  ASSERT_TRUE(spool.Claim(iChunk));
+  EXPECT_EQ(iChunk, 1);
+  std::string strLease = ReadFile(GetChunkFileName(1, ".lease"));
+  EXPECT_NE(strLease, m_strForeignId);
+  EXPECT_FALSE(std::ifstream(GetChunkFileName(1, ".reclaim").c_str()));
+  EXPECT_TRUE(spool.Complete());
+  EXPECT_EQ(ReadFile(GetChunkFileName(1, ".done")), strLease);
+  // The live lease is left alone
+  EXPECT_EQ(ReadFile(GetChunkFileName(0, ".lease")), m_strForeignId);
+}
+
+// 5 A process whose lease was reclaimed is told so, and leaves the chunk to
+// the process that reclaimed it
+TEST_F(WorkSpoolTest, LeaseLost) {
+  WorkSpool spool(m_strDirName, "job", m_nChunks, 1.0);
+  std::atomic<bool> bLeaseLost(false);
+  spool.SetLeaseLost([&bLeaseLost] { bLeaseLost = true; });
+  std::size_t iChunk = m_nChunks;
+  ASSERT_TRUE(spool.Claim(iChunk));
+  EXPECT_FALSE(spool.LeaseLost());
+  WriteForeignLease(iChunk, 0.0);
+  // The lease is renewed every quarter of the lease timeout
+  for (int i = 0; i < 20 && !bLeaseLost; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+  }
+  EXPECT_TRUE(bLeaseLost);
+  EXPECT_TRUE(spool.LeaseLost());
+  EXPECT_FALSE(spool.Complete());
+  EXPECT_EQ(ReadFile(GetChunkFileName(iChunk, ".lease")), m_strForeignId);
+  EXPECT_FALSE(std::ifstream(GetChunkFileName(iChunk, ".done").c_str()));
+}
@@ -0,0 +1,40 @@
+// Unit tests for WorkSpool
+//
+// Required input files:
+// None: the tests create their spool directory in the current directory
+#ifndef WORKSPOOLTEST_H_
+#define WORKSPOOLTEST_H_
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+namespace rxdock {
+
+namespace unittest {
+
+class WorkSpoolTest : public ::testing::Test {
+protected:
+  // TextFixture methods
+  void SetUp() override;
+  void TearDown() override;
+
+  // Returns the name of the file of chunk iChunk with suffix strSuffix
+  std::string GetChunkFileName(std::size_t iChunk,
+                               const std::string &strSuffix) const;
+  // Writes the lease of another process to chunk iChunk, last renewed
+  // dAge seconds ago
+  void WriteForeignLease(std::size_t iChunk, double dAge) const;
+  // Returns the contents of a file
+  std::string ReadFile(const std::string &strFile) const;
+
+  static const std::string m_strDirName;   // Spool directory
+  static const std::string m_strForeignId; // Worker of the foreign leases
+  static const std::size_t m_nChunks = 3;
+};
+
+} // namespace unittest
+
+} // namespace rxdock
+
+#endif /*WORKSPOOLTEST_H_*/
@@ -0,0 +1,110 @@
+//===-- ParseCalibrateScreening.cxx - Parse CLI params ----------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Parse command-line interface parameters for CalibrateScreening operation.
+///
+//===----------------------------------------------------------------------===//
+
+#include "ParseCalibrateScreening.h"
+
+#include "rxdock/operation/CalibrateScreening.h"
+
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+
+int rxdock::parseCalibrateScreening(int argc, char *argv[]) {
+  cxxopts::Options options(
+      "rxcmd calibrate-screening",
+      "Calibrate a multi-stage screening protocol for rxcmd dock --screening "
+      "from a training subset of the library docked exhaustively");
+  options.positional_help("");
+
+  // Command line arguments and default values
+  cxxopts::OptionAdder adder = options.add_options();
+  adder("i,input",
+        "Input structure-data file (SDfile) with all the docked poses of the "
+        "training ligands, in run order",
+        cxxopts::value<std::string>());
+  adder("o,output", "Output screening protocol file name",
+        cxxopts::value<std::string>());
+  adder("stage-runs",
+        "Number of runs of a ligand by the end of each stage, e.g. 5,15",
+        cxxopts::value<std::vector<std::size_t>>()->default_value("5,15"));
+  adder("keep",
+        "Fraction of all the training ligands passing each stage, e.g. "
+        "0.3,0.05",
+        cxxopts::value<std::vector<double>>()->default_value("0.3,0.05"));
+  adder("n,number", "Maximum number of runs of the ligands passing all stages",
+        cxxopts::value<std::size_t>()->default_value("50"));
+  adder("score", "Score data field compared to the stage thresholds",
+        cxxopts::value<std::string>()->default_value("score.inter"));
+  adder("positional",
+        "Positional arguments: unused, but useful to have to catch errors",
+        cxxopts::value<std::vector<std::string>>());
+  adder("h,help", "Print help");
+
+  try {
+    options.parse_positional({"positional"});
+    auto result = options.parse(argc, argv);
+
+    if (result.count("positional")) {
+      fmt::print(
+          "Positional arguments are unsupported but were used: {}.\n",
+          fmt::join(result["positional"].as<std::vector<std::string>>(), ", "));
+      return EXIT_FAILURE;
+    }
+
+    if (result.count("h")) {
+      fmt::print(options.help());
+      return EXIT_SUCCESS;
+    }
+
+    // Command line arguments and default values
+    std::string inputSDFile;
+    if (result.count("i")) {
+      inputSDFile = result["i"].as<std::string>();
+    } else {
+      fmt::print("Input structure-data file name is missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    std::string outputFile;
+    if (result.count("o")) {
+      outputFile = result["o"].as<std::string>();
+    } else {
+      fmt::print("Output screening protocol file name is missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    std::vector<std::size_t> stageRuns =
+        result["stage-runs"].as<std::vector<std::size_t>>();
+    std::vector<double> keepFractions =
+        result["keep"].as<std::vector<double>>();
+    if (stageRuns.size() != keepFractions.size()) {
+      fmt::print("Each stage needs a number of runs and a fraction of "
+                 "ligands to keep.\n");
+      return EXIT_FAILURE;
+    }
+    std::size_t nMaxRuns = result["n"].as<std::size_t>();
+    std::string scoreName = result["score"].as<std::string>();
+
+    return operation::calibrateScreening(inputSDFile, outputFile, stageRuns,
+                                         keepFractions, nMaxRuns, scoreName);
+
+  } catch (const cxxopts::OptionException &e) {
+    fmt::print("Error parsing options: {}\n", e.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
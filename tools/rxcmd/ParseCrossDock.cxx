@@ -0,0 +1,177 @@
+//===-- ParseCrossDock.cxx - Parse CLI params for CrossDock -----*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Parse command-line interface parameters for CrossDock operation.
+///
+//===----------------------------------------------------------------------===//
+
+#include "ParseCrossDock.h"
+
+#include "rxdock/operation/Dock.h"
+
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+
+int rxdock::parseCrossDock(int argc, char *argv[]) {
+  cxxopts::Options options(
+      "rxcmd cross-dock",
+      "Receptor-ligand docking of each ligand against several receptors, "
+      "reading the ligands once");
+  options.positional_help("");
+
+  // Command line arguments and default values
+  cxxopts::OptionAdder adder = options.add_options();
+  adder("i,input", "Input ligand structure-data file (SDfile) name",
+        cxxopts::value<std::string>());
+  adder("o,output",
+        "Output docked ligand structure-data file (SDfile) name (compressed "
+        "with gzip if it ends with .gz)",
+        cxxopts::value<std::string>());
+  adder("r,receptor-param",
+        "Receptor parameters files, e.g. target1.json,target2.json",
+        cxxopts::value<std::vector<std::string>>());
+  adder("p,docking-param", "Docking protocol parameters file",
+        cxxopts::value<std::string>());
+  adder("n,number", "Number of runs per ligand and receptor (0 = unlimited)",
+        cxxopts::value<std::size_t>()->default_value("50"));
+  adder("P,protonate",
+        "Protonate all neutral amines, guanidines, and imidazoles");
+  adder("D,deprotonate",
+        "Deprotonate all carboxylic, sulphur, and phosphorous acid groups");
+  adder("H,all-hydrogens",
+        "Read all hydrogens present instead of only polar hydrogens");
+  adder("t,threshold", "Score threshold", cxxopts::value<double>());
+  adder("c,continue",
+        "Continue if score threshold is met instead of terminating ligand");
+  adder("f,filter", "Filter file name", cxxopts::value<std::string>());
+  adder("s,seed",
+        "Random number seed to use instead of std::random_device (each run "
+        "of each ligand draws from its own stream of the seed)",
+        cxxopts::value<std::size_t>());
+  adder("T,threads",
+        "Number of threads docking ligands in parallel (0 = all cores)",
+        cxxopts::value<std::size_t>()->default_value("1"));
+  adder("output-window",
+        "Size in MiB of the docked poses kept in memory to write the output "
+        "in input order (0 = 64)",
+        cxxopts::value<std::size_t>()->default_value("0"));
+  adder("positional",
+        "Positional arguments: unused, but useful to have to catch errors",
+        cxxopts::value<std::vector<std::string>>());
+  adder("h,help", "Print help");
+
+  try {
+    options.parse_positional({"positional"});
+    auto result = options.parse(argc, argv);
+
+    if (result.count("positional")) {
+      fmt::print(
+          "Positional arguments are unsupported but were used: {}.\n",
+          fmt::join(result["positional"].as<std::vector<std::string>>(), ", "));
+      return EXIT_FAILURE;
+    }
+
+    if (result.count("h")) {
+      fmt::print(options.help());
+      return EXIT_SUCCESS;
+    }
+
+    // Command line arguments and default values
+    std::string strLigandMdlFile;
+    if (result.count("i")) {
+      strLigandMdlFile = result["i"].as<std::string>();
+    } else {
+      fmt::print("Input ligand structure-data file name is missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    std::string strOutputMdlFile;
+    if (result.count("o")) {
+      strOutputMdlFile = result["o"].as<std::string>();
+    } else {
+      fmt::print("Output ligand structure-data file name is missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> receptorPrmFiles;
+    if (result.count("r")) {
+      receptorPrmFiles = result["r"].as<std::vector<std::string>>();
+    } else {
+      fmt::print("Receptor parameters file names are missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    std::string strParamFile;
+    if (result.count("p")) {
+      strParamFile = result["p"].as<std::string>();
+    } else {
+      fmt::print("Docking protocol parameters file name is missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    bool bFilter = result.count("f");
+    std::string strFilterFile;
+    if (bFilter) {
+      strFilterFile = result["f"].as<std::string>();
+    }
+
+    bool bDockingRuns = result.count("n");
+    std::size_t nDockingRuns = result["n"].as<std::size_t>();
+
+    bool bPosIonise = result.count("P");
+    bool bNegIonise = result.count("D");
+    bool bExplH = result.count("H");
+
+    bool bTarget = result.count("t");
+    double dTargetScore = 0.0;
+    if (bTarget) {
+      dTargetScore = result["t"].as<double>();
+    }
+    bool bContinue = result.count("c");
+
+    bool bSeed = result.count("s");
+    std::size_t nSeed = 0;
+    if (bSeed) {
+      nSeed = result["s"].as<std::size_t>();
+    }
+
+    std::size_t nThreads = result["T"].as<std::size_t>();
+    std::size_t nOutputWindow = result["output-window"].as<std::size_t>();
+
+    operation::DockOptions dockOptions;
+    dockOptions.strLigandMdlFile = strLigandMdlFile;
+    dockOptions.strOutputMdlFile = strOutputMdlFile;
+    dockOptions.strParamFile = strParamFile;
+    dockOptions.bFilter = bFilter;
+    dockOptions.strFilterFile = strFilterFile;
+    dockOptions.bDockingRuns = bDockingRuns;
+    dockOptions.nDockingRuns = nDockingRuns;
+    dockOptions.bPosIonise = bPosIonise;
+    dockOptions.bNegIonise = bNegIonise;
+    dockOptions.bExplH = bExplH;
+    dockOptions.bTarget = bTarget;
+    dockOptions.dTargetScore = dTargetScore;
+    dockOptions.bContinue = bContinue;
+    dockOptions.bSeed = bSeed;
+    dockOptions.nSeed = nSeed;
+    dockOptions.nThreads = nThreads;
+    dockOptions.nOutputWindow = nOutputWindow;
+    return operation::crossDock(dockOptions, receptorPrmFiles);
+
+  } catch (const cxxopts::OptionException &e) {
+    fmt::print("Error parsing options: {}\n", e.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -18,6 +18,7 @@
 #include "ParseDock.h"
 
 #include "rxdock/operation/Dock.h"
+#include "rxdock/support/HugePages.h"
 
 #include <cxxopts.hpp>
 #include <fmt/format.h>
@@ -32,7 +33,9 @@ int rxdock::parseDock(int argc, char *argv[]) {
   cxxopts::OptionAdder adder = options.add_options();
   adder("i,input", "Input ligand structure-data file (SDfile) name",
         cxxopts::value<std::string>());
-  adder("o,output", "Output docked ligand structure-data file (SDfile) name",
+  adder("o,output",
+        "Output docked ligand structure-data file (SDfile) name (compressed "
+        "with gzip if it ends with .gz)",
         cxxopts::value<std::string>());
   adder("output-crd", "Output receptor CRD file name",
         cxxopts::value<std::string>());
@@ -54,8 +57,84 @@ int rxdock::parseDock(int argc, char *argv[]) {
   adder("c,continue",
         "Continue if score threshold is met instead of terminating ligand");
   adder("f,filter", "Filter file name", cxxopts::value<std::string>());
-  adder("s,seed", "Random number seed to use instead of std::random_device",
+  adder("s,seed",
+        "Random number seed to use instead of std::random_device (each run "
+        "of each ligand draws from its own stream of the seed, so the "
+        "results do not depend on the number of docking, run and scoring "
+        "threads)",
         cxxopts::value<std::size_t>());
+  adder("T,threads",
+        "Number of threads docking ligands in parallel (0 = all cores)",
+        cxxopts::value<std::size_t>()->default_value("1"));
+  adder("run-threads",
+        "Number of docking runs of each ligand done in parallel (0 = all "
+        "cores)",
+        cxxopts::value<std::size_t>()->default_value("1"));
+  adder("scoring-threads",
+        "Number of threads scoring each genetic algorithm population (0 = all "
+        "cores)",
+        cxxopts::value<std::size_t>()->default_value("1"));
+  adder("output-window",
+        "Size in MiB of the docked poses kept in memory to write the output "
+        "in input order (0 = 64)",
+        cxxopts::value<std::size_t>()->default_value("0"));
+  adder("checkpoint",
+        "Checkpoint file recording which ligands have been docked and written",
+        cxxopts::value<std::string>());
+  adder("checkpoint-interval", "Seconds between checkpoint updates",
+        cxxopts::value<double>()->default_value("60"));
+  adder("resume",
+        "Resume from the checkpoint file, if it exists, instead of starting "
+        "from the first ligand (requires --checkpoint)");
+  adder("shard",
+        "Dock only shard i of n (i/n, i = 1 to n) of the input ligands, split "
+        "into contiguous ranges of records of about the same size",
+        cxxopts::value<std::string>());
+  adder("spool",
+        "Spool directory shared by the processes docking the input ligands "
+        "together: each process claims chunks of the input through lease "
+        "files until all are done, writing chunk i to the output file name "
+        "with _chunk<i> inserted before the extension",
+        cxxopts::value<std::string>());
+  adder("spool-chunks", "Number of chunks the input is split into in the spool",
+        cxxopts::value<std::size_t>()->default_value("100"));
+  adder("lease-timeout",
+        "Seconds after which the chunk of a process that stopped renewing its "
+        "lease is claimed by another process",
+        cxxopts::value<double>()->default_value("600"));
+  adder("screening",
+        "Multi-stage screening protocol file, from rxcmd calibrate-screening "
+        "(sets the maximum number of runs per ligand)",
+        cxxopts::value<std::string>());
+  adder("converge",
+        "Stop docking a ligand once its best pose has been found this many "
+        "times (0 = never)",
+        cxxopts::value<std::size_t>()->default_value("0"));
+  adder("converge-rmsd",
+        "Heavy atom RMSD within which two poses count as the same for "
+        "--converge",
+        cxxopts::value<double>()->default_value("1.0"));
+  adder("schedule-window",
+        "Number of records read at a time and docked largest ligand first, "
+        "to balance the load of the docking threads (0 = input order)",
+        cxxopts::value<std::size_t>()->default_value("0"));
+  adder("cache",
+        "Result cache directory: ligands docked before by a job with the same "
+        "receptor, protocol, options and seed get the poses stored there "
+        "(only used with a seed)",
+        cxxopts::value<std::string>());
+  adder("dedup",
+        "Dock each structure once, writing its poses for all its duplicate "
+        "records: exact, stereo (matching stereoisomers), or tautomer "
+        "(matching tautomers and stereoisomers)",
+        cxxopts::value<std::string>());
+  adder("numa",
+        "Bind the docking threads to the NUMA nodes in turn, with a copy of "
+        "the receptor grids in the memory of each node");
+  adder("huge-pages",
+        "Back the receptor grids with huge pages: off, transparent, or "
+        "explicit (reserved huge pages, then transparent ones)",
+        cxxopts::value<std::string>()->default_value("off"));
   adder("positional",
         "Positional arguments: unused, but useful to have to catch errors",
         cxxopts::value<std::vector<std::string>>());
@@ -152,12 +231,134 @@ int rxdock::parseDock(int argc, char *argv[]) {
       nSeed = result["s"].as<std::size_t>();
     }
 
-    return operation::dock(strLigandMdlFile, strOutputMdlFile, bOutputCrd,
-                           strOutputCrdFile, bOutputHistory,
-                           strOutputHistoryFilePrefix, strReceptorPrmFile,
-                           strParamFile, bFilter, strFilterFile, bDockingRuns,
-                           nDockingRuns, bPosIonise, bNegIonise, bExplH,
-                           bTarget, dTargetScore, bContinue, bSeed, nSeed);
+    std::size_t nThreads = result["T"].as<std::size_t>();
+    std::size_t nRunThreads = result["run-threads"].as<std::size_t>();
+    std::size_t nScoringThreads =
+        result["scoring-threads"].as<std::size_t>();
+    std::size_t nOutputWindow = result["output-window"].as<std::size_t>();
+
+    std::string strScreeningFile;
+    if (result.count("screening")) {
+      strScreeningFile = result["screening"].as<std::string>();
+    }
+    std::size_t nConvergence = result["converge"].as<std::size_t>();
+    double dConvergenceRMSD = result["converge-rmsd"].as<double>();
+    std::size_t nScheduleWindow = result["schedule-window"].as<std::size_t>();
+    std::string strCacheDir;
+    if (result.count("cache")) {
+      strCacheDir = result["cache"].as<std::string>();
+    }
+    std::string strDuplicateMatch;
+    if (result.count("dedup")) {
+      strDuplicateMatch = result["dedup"].as<std::string>();
+      if (strDuplicateMatch != "exact" && strDuplicateMatch != "stereo" &&
+          strDuplicateMatch != "tautomer") {
+        fmt::print("Duplicates must be matched as exact, stereo, or "
+                   "tautomer.\n");
+        return EXIT_FAILURE;
+      }
+    }
+    bool bNumaReplicas = result.count("numa");
+    std::string strHugePages = result["huge-pages"].as<std::string>();
+    if (strHugePages == "transparent") {
+      support::setHugePageMode(support::HUGE_PAGES_TRANSPARENT);
+    } else if (strHugePages == "explicit") {
+      support::setHugePageMode(support::HUGE_PAGES_EXPLICIT);
+    } else if (strHugePages != "off") {
+      fmt::print("Huge pages must be off, transparent, or explicit.\n");
+      return EXIT_FAILURE;
+    }
+
+    std::string strCheckpointFile;
+    if (result.count("checkpoint")) {
+      strCheckpointFile = result["checkpoint"].as<std::string>();
+    }
+    double dCheckpointInterval = result["checkpoint-interval"].as<double>();
+    bool bResume = result.count("resume");
+    if (bResume && strCheckpointFile.empty()) {
+      fmt::print("Resuming requires a checkpoint file.\n");
+      return EXIT_FAILURE;
+    }
+
+    std::size_t iShard = 0;
+    std::size_t nShards = 1;
+    if (result.count("shard")) {
+      std::string strShard = result["shard"].as<std::string>();
+      std::size_t iSlash = strShard.find('/');
+      try {
+        if (iSlash == std::string::npos) {
+          throw std::invalid_argument(strShard);
+        }
+        iShard = std::stoul(strShard.substr(0, iSlash));
+        nShards = std::stoul(strShard.substr(iSlash + 1));
+      } catch (const std::logic_error &) {
+        nShards = 0;
+      }
+      if (nShards == 0 || iShard < 1 || iShard > nShards) {
+        fmt::print("Shard must be given as i/n with i from 1 to n.\n");
+        return EXIT_FAILURE;
+      }
+      iShard--;
+    }
+
+    std::string strSpoolDir;
+    if (result.count("spool")) {
+      strSpoolDir = result["spool"].as<std::string>();
+      if (result.count("shard") || result.count("checkpoint") || bResume) {
+        fmt::print("The spool manages the shards and checkpoints, --shard, "
+                   "--checkpoint, and --resume can not be used with it.\n");
+        return EXIT_FAILURE;
+      }
+    }
+    std::size_t nSpoolChunks = result["spool-chunks"].as<std::size_t>();
+    double dLeaseTimeout = result["lease-timeout"].as<double>();
+    if (nSpoolChunks == 0 || dLeaseTimeout <= 0.0) {
+      fmt::print("The number of spool chunks and the lease timeout must be "
+                 "positive.\n");
+      return EXIT_FAILURE;
+    }
+
+    operation::DockOptions dockOptions;
+    dockOptions.strLigandMdlFile = strLigandMdlFile;
+    dockOptions.strOutputMdlFile = strOutputMdlFile;
+    dockOptions.bOutputCrd = bOutputCrd;
+    dockOptions.strOutputCrdFile = strOutputCrdFile;
+    dockOptions.bOutputHistory = bOutputHistory;
+    dockOptions.strOutputHistoryFilePrefix = strOutputHistoryFilePrefix;
+    dockOptions.strReceptorPrmFile = strReceptorPrmFile;
+    dockOptions.strParamFile = strParamFile;
+    dockOptions.bFilter = bFilter;
+    dockOptions.strFilterFile = strFilterFile;
+    dockOptions.bDockingRuns = bDockingRuns;
+    dockOptions.nDockingRuns = nDockingRuns;
+    dockOptions.bPosIonise = bPosIonise;
+    dockOptions.bNegIonise = bNegIonise;
+    dockOptions.bExplH = bExplH;
+    dockOptions.bTarget = bTarget;
+    dockOptions.dTargetScore = dTargetScore;
+    dockOptions.bContinue = bContinue;
+    dockOptions.bSeed = bSeed;
+    dockOptions.nSeed = nSeed;
+    dockOptions.nThreads = nThreads;
+    dockOptions.nRunThreads = nRunThreads;
+    dockOptions.nScoringThreads = nScoringThreads;
+    dockOptions.nOutputWindow = nOutputWindow;
+    dockOptions.strCheckpointFile = strCheckpointFile;
+    dockOptions.dCheckpointInterval = dCheckpointInterval;
+    dockOptions.bResume = bResume;
+    dockOptions.iShard = iShard;
+    dockOptions.nShards = nShards;
+    dockOptions.strSpoolDir = strSpoolDir;
+    dockOptions.nSpoolChunks = nSpoolChunks;
+    dockOptions.dLeaseTimeout = dLeaseTimeout;
+    dockOptions.strScreeningFile = strScreeningFile;
+    dockOptions.nConvergence = nConvergence;
+    dockOptions.dConvergenceRMSD = dConvergenceRMSD;
+    dockOptions.nScheduleWindow = nScheduleWindow;
+    dockOptions.strCacheDir = strCacheDir;
+    dockOptions.strDuplicateMatch = strDuplicateMatch;
+    dockOptions.bNumaReplicas = bNumaReplicas;
+    return operation::dock(dockOptions);
 
   } catch (const cxxopts::OptionException &e) {
     fmt::print("Error parsing options: {}\n", e.what());
@@ -0,0 +1,126 @@
+//===-- ParseRescore.cxx - Parse CLI params for Rescore ---------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Parse command-line interface parameters for Rescore operation.
+///
+//===----------------------------------------------------------------------===//
+
+#include "ParseRescore.h"
+
+#include "rxdock/operation/Dock.h"
+
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+
+int rxdock::parseRescore(int argc, char *argv[]) {
+  cxxopts::Options options(
+      "rxcmd rescore",
+      "Scoring or minimisation of existing poses, without docking them");
+  options.positional_help("");
+
+  // Command line arguments and default values
+  cxxopts::OptionAdder adder = options.add_options();
+  adder("i,input", "Input pose structure-data file (SDfile) name",
+        cxxopts::value<std::string>());
+  adder("o,output",
+        "Output structure-data file (SDfile) name, or JSON lines file name "
+        "with --scores-only (compressed with gzip if it ends with .gz)",
+        cxxopts::value<std::string>());
+  adder("r,receptor-param", "Receptor parameters file",
+        cxxopts::value<std::string>());
+  adder("p,docking-param",
+        "Protocol parameters file, e.g. score.json or minimise.json",
+        cxxopts::value<std::string>()->default_value("score.json"));
+  adder("scores-only",
+        "Write a JSON line with the score fields of each pose instead of its "
+        "SD record");
+  adder("P,protonate",
+        "Protonate all neutral amines, guanidines, and imidazoles");
+  adder("D,deprotonate",
+        "Deprotonate all carboxylic, sulphur, and phosphorous acid groups");
+  adder("H,all-hydrogens",
+        "Read all hydrogens present instead of only polar hydrogens");
+  adder("T,threads", "Number of threads rescoring poses (0 = all cores)",
+        cxxopts::value<std::size_t>()->default_value("0"));
+  adder("output-window",
+        "Size in MiB of the rescored poses kept in memory to write the output "
+        "in input order (0 = 64)",
+        cxxopts::value<std::size_t>()->default_value("0"));
+  adder("positional",
+        "Positional arguments: unused, but useful to have to catch errors",
+        cxxopts::value<std::vector<std::string>>());
+  adder("h,help", "Print help");
+
+  try {
+    options.parse_positional({"positional"});
+    auto result = options.parse(argc, argv);
+
+    if (result.count("positional")) {
+      fmt::print(
+          "Positional arguments are unsupported but were used: {}.\n",
+          fmt::join(result["positional"].as<std::vector<std::string>>(), ", "));
+      return EXIT_FAILURE;
+    }
+
+    if (result.count("h")) {
+      fmt::print(options.help());
+      return EXIT_SUCCESS;
+    }
+
+    // Command line arguments and default values
+    std::string strInputMdlFile;
+    if (result.count("i")) {
+      strInputMdlFile = result["i"].as<std::string>();
+    } else {
+      fmt::print("Input pose structure-data file name is missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    std::string strOutputFile;
+    if (result.count("o")) {
+      strOutputFile = result["o"].as<std::string>();
+    } else {
+      fmt::print("Output file name is missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    std::string strReceptorPrmFile;
+    if (result.count("r")) {
+      strReceptorPrmFile = result["r"].as<std::string>();
+    } else {
+      fmt::print("Receptor parameters file name is missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    std::string strParamFile = result["p"].as<std::string>();
+    bool bScoresOnly = result.count("scores-only");
+
+    bool bPosIonise = result.count("P");
+    bool bNegIonise = result.count("D");
+    bool bExplH = result.count("H");
+
+    std::size_t nThreads = result["T"].as<std::size_t>();
+    std::size_t nOutputWindow = result["output-window"].as<std::size_t>();
+
+    return operation::rescore(strInputMdlFile, strOutputFile,
+                              strReceptorPrmFile, strParamFile, bPosIonise,
+                              bNegIonise, bExplH, bScoresOnly, nThreads,
+                              nOutputWindow);
+
+  } catch (const cxxopts::OptionException &e) {
+    fmt::print("Error parsing options: {}\n", e.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,222 @@
+//===-- ParseServe.cxx - Parse CLI params for Serve -------------*- C++ -*-===//
+//
+// Part of the RxDock project, under the GNU LGPL version 3.
+// Visit https://www.rxdock.org/ for more information.
+// Copyright (c) 1998--2006 RiboTargets (subsequently Vernalis (R&D) Ltd)
+// Copyright (c) 2006--2012 University of York
+// Copyright (c) 2012--2014 University of Barcelona
+// Copyright (c) 2019--2020 RxTx
+// SPDX-License-Identifier: LGPL-3.0-only
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// Parse command-line interface parameters for Serve operation.
+///
+//===----------------------------------------------------------------------===//
+
+#include "ParseServe.h"
+
+#include "rxdock/operation/Dock.h"
+#include "rxdock/support/HugePages.h"
+
+#include <cxxopts.hpp>
+#include <fmt/format.h>
+
+int rxdock::parseServe(int argc, char *argv[]) {
+  cxxopts::Options options(
+      "rxcmd serve",
+      "Persistent receptor-ligand docking service: loads the receptor once, "
+      "then docks the ligands sent as SD records and streams back a JSON "
+      "header line and the docked poses for each of them");
+  options.positional_help("");
+
+  // Command line arguments and default values
+  cxxopts::OptionAdder adder = options.add_options();
+  adder("socket",
+        "Unix domain socket to listen on for client sessions (default: a "
+        "single session on standard input and output)",
+        cxxopts::value<std::string>());
+  adder("timeout",
+        "Seconds a socket client may send nothing while all its ligands are "
+        "answered before its session is ended (0 = never)",
+        cxxopts::value<double>()->default_value("600"));
+  adder("r,receptor-param", "Receptor parameters file",
+        cxxopts::value<std::string>());
+  adder("p,docking-param", "Docking protocol parameters file",
+        cxxopts::value<std::string>());
+  adder("n,number", "Number of runs per ligand (0 = unlimited)",
+        cxxopts::value<std::size_t>()->default_value("50"));
+  adder("P,protonate",
+        "Protonate all neutral amines, guanidines, and imidazoles");
+  adder("D,deprotonate",
+        "Deprotonate all carboxylic, sulphur, and phosphorous acid groups");
+  adder("H,all-hydrogens",
+        "Read all hydrogens present instead of only polar hydrogens");
+  adder("t,threshold", "Score threshold", cxxopts::value<double>());
+  adder("c,continue",
+        "Continue if score threshold is met instead of terminating ligand");
+  adder("f,filter", "Filter file name", cxxopts::value<std::string>());
+  adder("s,seed",
+        "Random number seed to use instead of std::random_device (each run "
+        "of each ligand of a session draws from its own stream of the seed)",
+        cxxopts::value<std::size_t>());
+  adder("T,threads",
+        "Number of threads docking ligands in parallel (0 = all cores)",
+        cxxopts::value<std::size_t>()->default_value("1"));
+  adder("run-threads",
+        "Number of docking runs of each ligand done in parallel (0 = all "
+        "cores)",
+        cxxopts::value<std::size_t>()->default_value("1"));
+  adder("scoring-threads",
+        "Number of threads scoring each genetic algorithm population (0 = all "
+        "cores)",
+        cxxopts::value<std::size_t>()->default_value("1"));
+  adder("output-window",
+        "Size in MiB of the docked poses kept in memory to send the "
+        "responses in input order (0 = 64)",
+        cxxopts::value<std::size_t>()->default_value("0"));
+  adder("screening",
+        "Multi-stage screening protocol file, from rxcmd calibrate-screening "
+        "(sets the maximum number of runs per ligand)",
+        cxxopts::value<std::string>());
+  adder("converge",
+        "Stop docking a ligand once its best pose has been found this many "
+        "times (0 = never)",
+        cxxopts::value<std::size_t>()->default_value("0"));
+  adder("converge-rmsd",
+        "Heavy atom RMSD within which two poses count as the same for "
+        "--converge",
+        cxxopts::value<double>()->default_value("1.0"));
+  adder("numa",
+        "Bind the docking threads to the NUMA nodes in turn, with a copy of "
+        "the receptor grids in the memory of each node");
+  adder("huge-pages",
+        "Back the receptor grids with huge pages: off, transparent, or "
+        "explicit (reserved huge pages, then transparent ones)",
+        cxxopts::value<std::string>()->default_value("off"));
+  adder("positional",
+        "Positional arguments: unused, but useful to have to catch errors",
+        cxxopts::value<std::vector<std::string>>());
+  adder("h,help", "Print help");
+
+  try {
+    options.parse_positional({"positional"});
+    auto result = options.parse(argc, argv);
+
+    if (result.count("positional")) {
+      fmt::print(
+          "Positional arguments are unsupported but were used: {}.\n",
+          fmt::join(result["positional"].as<std::vector<std::string>>(), ", "));
+      return EXIT_FAILURE;
+    }
+
+    if (result.count("h")) {
+      fmt::print(options.help());
+      return EXIT_SUCCESS;
+    }
+
+    // Command line arguments and default values
+    std::string strSocket;
+    if (result.count("socket")) {
+      strSocket = result["socket"].as<std::string>();
+    }
+    double dTimeout = result["timeout"].as<double>();
+
+    std::string strReceptorPrmFile;
+    if (result.count("r")) {
+      strReceptorPrmFile = result["r"].as<std::string>();
+    } else {
+      fmt::print("Receptor parameters file name is missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    std::string strParamFile;
+    if (result.count("p")) {
+      strParamFile = result["p"].as<std::string>();
+    } else {
+      fmt::print("Docking protocol parameters file name is missing.\n");
+      return EXIT_FAILURE;
+    }
+
+    bool bFilter = result.count("f");
+    std::string strFilterFile;
+    if (bFilter) {
+      strFilterFile = result["f"].as<std::string>();
+    }
+
+    bool bDockingRuns = result.count("n");
+    std::size_t nDockingRuns = result["n"].as<std::size_t>();
+
+    bool bPosIonise = result.count("P");
+    bool bNegIonise = result.count("D");
+    bool bExplH = result.count("H");
+
+    bool bTarget = result.count("t");
+    double dTargetScore = 0.0;
+    if (bTarget) {
+      dTargetScore = result["t"].as<double>();
+    }
+    bool bContinue = result.count("c");
+
+    bool bSeed = result.count("s");
+    std::size_t nSeed = 0;
+    if (bSeed) {
+      nSeed = result["s"].as<std::size_t>();
+    }
+
+    std::size_t nThreads = result["T"].as<std::size_t>();
+    std::size_t nRunThreads = result["run-threads"].as<std::size_t>();
+    std::size_t nScoringThreads =
+        result["scoring-threads"].as<std::size_t>();
+    std::size_t nOutputWindow = result["output-window"].as<std::size_t>();
+
+    std::string strScreeningFile;
+    if (result.count("screening")) {
+      strScreeningFile = result["screening"].as<std::string>();
+    }
+    std::size_t nConvergence = result["converge"].as<std::size_t>();
+    double dConvergenceRMSD = result["converge-rmsd"].as<double>();
+    bool bNumaReplicas = result.count("numa");
+    std::string strHugePages = result["huge-pages"].as<std::string>();
+    if (strHugePages == "transparent") {
+      support::setHugePageMode(support::HUGE_PAGES_TRANSPARENT);
+    } else if (strHugePages == "explicit") {
+      support::setHugePageMode(support::HUGE_PAGES_EXPLICIT);
+    } else if (strHugePages != "off") {
+      fmt::print("Huge pages must be off, transparent, or explicit.\n");
+      return EXIT_FAILURE;
+    }
+
+    operation::DockOptions dockOptions;
+    dockOptions.strReceptorPrmFile = strReceptorPrmFile;
+    dockOptions.strParamFile = strParamFile;
+    dockOptions.bFilter = bFilter;
+    dockOptions.strFilterFile = strFilterFile;
+    dockOptions.bDockingRuns = bDockingRuns;
+    dockOptions.nDockingRuns = nDockingRuns;
+    dockOptions.bPosIonise = bPosIonise;
+    dockOptions.bNegIonise = bNegIonise;
+    dockOptions.bExplH = bExplH;
+    dockOptions.bTarget = bTarget;
+    dockOptions.dTargetScore = dTargetScore;
+    dockOptions.bContinue = bContinue;
+    dockOptions.bSeed = bSeed;
+    dockOptions.nSeed = nSeed;
+    dockOptions.nThreads = nThreads;
+    dockOptions.nRunThreads = nRunThreads;
+    dockOptions.nScoringThreads = nScoringThreads;
+    dockOptions.nOutputWindow = nOutputWindow;
+    dockOptions.strScreeningFile = strScreeningFile;
+    dockOptions.nConvergence = nConvergence;
+    dockOptions.dConvergenceRMSD = dConvergenceRMSD;
+    dockOptions.bNumaReplicas = bNumaReplicas;
+    return operation::serve(dockOptions, strSocket, dTimeout);
+
+  } catch (const cxxopts::OptionException &e) {
+    fmt::print("Error parsing options: {}\n", e.what());
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -15,8 +15,12 @@
 ///
 //===----------------------------------------------------------------------===//
 
+#include "ParseCalibrateScreening.h"
 #include "ParseCavitySearch.h"
+#include "ParseCrossDock.h"
 #include "ParseDock.h"
+#include "ParseRescore.h"
+#include "ParseServe.h"
 #include "ParseTabularize.h"
 #include "ParseTransform.h"
 
@@ -95,12 +99,16 @@ int main(int argc, char *argv[]) {
 
   std::map<std::string, std::function<int(int, char **)>> commandFunctions = {
       {"dock", parseDock},                  // rbdock
+      {"serve", parseServe},                // persistent docking service
+      {"cross-dock", parseCrossDock},       // rbdock for each receptor
+      {"rescore", parseRescore},            // rbdock -p score.json
       {"cavity-search", parseCavitySearch}, // rbcavity
       {"grid", parseNull},   // rbcalcgrid, make_grid.csh, rbconvgrid, rbmoegrid
       {"tether", parseNull}, // sdtether
       {"rmsd", parseNull},   // rbrms, sdrmsd
       {"subset", parseNull}, // representative subset for predictions
       {"predict", parseNull},  // rbhtfinder
+      {"calibrate-screening", parseCalibrateScreening}, // rbhtfinder
       {"describe", parseNull}, // rblist (add molecular descriptors and
                                // fingerprints to structure-data files)
       {"transform",